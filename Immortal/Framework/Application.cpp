@@ -10,8 +10,9 @@ namespace Immortal
 
 Application *Application::That{ nullptr };
 
-Application::Application(const Window::Description &description) :
-    eventSink{ this }
+Application::Application(const Window::Description &description, const Configuration &configuration) :
+    eventSink{ this },
+    configuration{ configuration }
 {
     !!That ? throw Exception(SError::InvalidSingleton) : That = this;
     
@@ -20,7 +21,13 @@ Application::Application(const Window::Description &description) :
 
     UpdateMeta(description);
 
-    Async::Setup();
+    Async::Setup(configuration.Threads);
+
+    auto reserved = Topology::Get().Reserved(configuration.Threads);
+    if (!reserved.empty() && !Topology::PinCurrentThread(reserved.front()))
+    {
+        LOG::WARN("Failed to pin the main thread to processor {0}", reserved.front().Index);
+    }
 
     window.reset(Window::Create(desc));
     window->SetIcon("Assets/Icon/terminal.png");
@@ -32,14 +39,30 @@ Application::Application(const Window::Description &description) :
         desc.Height
         });
 
-    Async::Execute([&](){
+    /* The render setup stays on this thread since the graphics context is bound to it,
+     * everything else of the startup overlaps with it through the graph. The shaders
+     * compiled ahead feed the render setup, so it waits for them before it begins */
+    Async::Graph startup;
+    startup.Emplace([&]() -> void {
         gui = GuiLayer::Create(context.get());
         timer.Start();
     });
 
+    Async::WaitGroup shaders;
+    for (auto &compilation : Render::ShaderCompilations())
+    {
+        shaders.Add();
+        startup.Emplace([&, compilation]() -> void {
+            compilation();
+            shaders.Done();
+        });
+    }
+    startup.Run();
+
+    Async::Wait(shaders);
     Render::Setup(context.get());
 
-    Async::Wait();
+    startup.Wait();
 
     window->Show();
 
@@ -49,6 +72,8 @@ Application::Application(const Window::Description &description) :
 Application::~Application()
 {
     timer.Stop();
+
+    Render::Shutdown();
 }
 
 Layer *Application::PushLayer(Layer *layer)
@@ -6,6 +6,7 @@
 #include "Input.h"
 #include "Window.h"
 #include "LayerStack.h"
+#include "Topology.h"
 
 #include "ImGui/GuiLayer.h"
 #include "Render/RenderContext.h"
@@ -20,12 +21,18 @@ namespace Immortal
 struct Configuration
 {
     float FontSize{ 12.0f };
+
+    /*
+     * @brief Where the workers of Async run. With reserved cores the main thread is pinned
+     *  to the first one of them.
+     */
+    Placement Threads{};
 };
 
 class IMMORTAL_API Application
 {
 public:
-    Application(const Window::Description &desc = { "Immortal Engine", 1920, 1080 });
+    Application(const Window::Description &desc = { "Immortal Engine", 1920, 1080 }, const Configuration &configuration = {});
 
     virtual ~Application();
 
@@ -1,34 +1,598 @@
 #include "impch.h"
 #include "Async.h"
+#include "Fiber.h"
 
 namespace Immortal
 {
 
+/*
+ * @brief Defined ahead of the pool, so it is destroyed after it. Workers still running at
+ *  exit drain their caches into it while the pool joins them.
+ */
+static struct
+{
+    std::mutex mutex;
+    JobPool::Batch *batches{ nullptr };
+    std::vector<std::unique_ptr<Job[]>> blocks;
+} freeList;
+
 std::unique_ptr<ThreadPool> Async::threadPool{ nullptr };
 
-#pragma sl_disable_optimizations
-void ThreadPool::Join()
+thread_local ThreadPool::Current ThreadPool::current{ nullptr, ThreadPool::Invalid };
+
+thread_local JobPool::Cache JobPool::cache;
+
+JobPool::Cache::~Cache()
 {
-    bool tasking{ true };
-    while (!tasks.empty()) { }
+    if (size > 0)
+    {
+        Drain(*this, size);
+    }
+}
 
-    while (1)
+/*
+ * @brief The header of a free batch is kept in the storage of its first job, so moving
+ *  jobs between the caches and the free list never allocates.
+ */
+static inline JobPool::Batch *MakeBatch(Job *head, size_t size, JobPool::Batch *next)
+{
+    return new (head->Storage()) JobPool::Batch{ head, size, next };
+}
+
+void JobPool::Refill(Cache &c)
+{
+    std::unique_lock<std::mutex> lock{ freeList.mutex };
+    if (!freeList.batches)
     {
-        tasking = false;
-        for (int i = 0; i < threads.size(); i++)
+        auto &block = freeList.blocks.emplace_back(new Job[BlockSize]);
+        for (size_t i = 0; i < BlockSize; i += BatchSize)
         {
-            if (semaphores[i] == Thread::State::Block)
+            Job *jobs = block.get() + i;
+            for (size_t j = 0; j < BatchSize - 1; j++)
+            {
+                jobs[j].next = &jobs[j + 1];
+            }
+            freeList.batches = MakeBatch(jobs, BatchSize, freeList.batches);
+        }
+    }
+
+    Batch *batch = freeList.batches;
+    freeList.batches = batch->next;
+
+    c.head = batch->head;
+    c.size = batch->size;
+}
+
+void JobPool::Drain(Cache &c, size_t count)
+{
+    Job *head = c.head;
+    Job *tail = head;
+    for (size_t i = 1; i < count; i++)
+    {
+        tail = tail->next;
+    }
+    c.head = tail->next;
+    c.size -= count;
+    tail->next = nullptr;
+
+    std::unique_lock<std::mutex> lock{ freeList.mutex };
+    freeList.batches = MakeBatch(head, count, freeList.batches);
+}
+
+ThreadPool::ThreadPool(int num, int ioNum, const Placement &placement)
+{
+    auto processors = Topology::Get().Select(placement);
+    if (num <= 0)
+    {
+        num = processors.empty() ? int(std::thread::hardware_concurrency()) : int(processors.size());
+    }
+    num = num > 0 ? num : 1;
+    backgroundLimit = std::max(1, num / 4);
+
+    for (int i = 0; i < num; i++)
+    {
+        workers.emplace_back(new Worker);
+    }
+
+    /* Steal from the workers closest in the cache hierarchy first */
+    for (int i = 0; i < num; i++)
+    {
+        auto &victims = workers[i]->victims;
+        for (int j = 1; j < num; j++)
+        {
+            victims.emplace_back((i + j) % num);
+        }
+        if (!processors.empty())
+        {
+            auto &self = processors[i % processors.size()];
+            std::stable_sort(victims.begin(), victims.end(), [&](int a, int b) -> bool {
+                return Topology::Measure(self, processors[a % processors.size()]) < Topology::Measure(self, processors[b % processors.size()]);
+            });
+        }
+    }
+
+    /* Start the threads after all queues are ready since any worker could steal from the others */
+    for (int i = 0; i < num; i++)
+    {
+        auto &thread = workers[i]->thread;
+        thread = std::thread{ [=]() -> void { Run(i); } };
+        if (!processors.empty())
+        {
+            Topology::Pin(thread, processors[i % processors.size()]);
+        }
+        LOG::INFO("\tid => {0}\thandle => {1}", thread.get_id(), thread.native_handle());
+    }
+
+    for (int i = 0; i < ioNum; i++)
+    {
+        auto &thread = io.threads.emplace_back([=]() -> void { RunIO(); });
+        LOG::INFO("\tid => {0}\thandle => {1} (IO)", thread.get_id(), thread.native_handle());
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::unique_lock<std::mutex> lock{ mutex };
+        stopping.store(true);
+    }
+    condition.notify_all();
+    {
+        std::unique_lock<std::mutex> lock{ io.queue.mutex };
+    }
+    io.condition.notify_all();
+
+    for (auto &worker : workers)
+    {
+        worker->thread.join();
+    }
+    for (auto &thread : io.threads)
+    {
+        thread.join();
+    }
+
+    /* Drop the jobs that were never picked up */
+    Job *job = nullptr;
+    for (size_t lane = 0; lane < LaneCount; lane++)
+    {
+        while ((job = injections[lane].Pop()) != nullptr)
+        {
+            Discard(job);
+        }
+        for (auto &worker : workers)
+        {
+            while (worker->queues[lane].Pop(job))
+            {
+                Discard(job);
+            }
+        }
+    }
+    while ((job = io.queue.Pop()) != nullptr)
+    {
+        Discard(job);
+    }
+}
+
+void ThreadPool::Run(int index)
+{
+    current = Current{ this, index };
+
+    while (!stopping.load(std::memory_order_acquire))
+    {
+        Job *job = Find(index);
+        if (job)
+        {
+            Execute(job);
+            continue;
+        }
+        Park([]() -> bool { return false; });
+    }
+
+    LOG::INFO("Stopping Thread -> \tid => {0}", std::this_thread::get_id());
+    current = Current{ nullptr, Invalid };
+}
+
+/*
+ * @brief The IO threads only serve the IO lane, they are allowed to block for as long as
+ *  they need without taking anything away from the workers.
+ */
+void ThreadPool::RunIO()
+{
+    while (true)
+    {
+        Job *job = nullptr;
+        {
+            std::unique_lock<std::mutex> lock{ io.queue.mutex };
+            io.condition.wait(lock, [this] {
+                return stopping.load() || io.queue.head;
+            });
+            if (stopping.load())
             {
-                tasking = true;
                 break;
             }
+            job = io.queue.Pop();
+        }
+        Execute(job);
+    }
+}
+
+void ThreadPool::Push(Job *job)
+{
+    size_t lane = size_t(job->Lane());
+    if (job->Lane() == Priority::IO)
+    {
+        {
+            std::unique_lock<std::mutex> lock{ io.queue.mutex };
+            io.queue.Push(job);
+        }
+        io.condition.notify_one();
+        return;
+    }
+
+    unfinished.fetch_add(1, std::memory_order_relaxed);
+
+    int index = WorkerIndex();
+    if (index != Invalid)
+    {
+        workers[index]->queues[lane].Push(job);
+    }
+    else
+    {
+        auto &injection = injections[lane];
+        std::unique_lock<std::mutex> lock{ injection.mutex };
+        injection.Push(job);
+    }
+
+    pending[lane].fetch_add(1, std::memory_order_seq_cst);
+    Notify();
+}
+
+/*
+ * @brief Look for a job lane by lane: the own deque first, then the injection queue and
+ *  at last the other workers. Background jobs are only taken while there is a free slot.
+ */
+Job *ThreadPool::Find(int index)
+{
+    Job *job = nullptr;
+    if (Take(index, size_t(Priority::Critical), job) || Take(index, size_t(Priority::Normal), job))
+    {
+        return job;
+    }
+
+    constexpr size_t background = size_t(Priority::Background);
+    if (pending[background].load(std::memory_order_relaxed) > 0 && AcquireBackgroundSlot())
+    {
+        if (Take(index, background, job))
+        {
+            return job;
+        }
+        backgrounds.fetch_sub(1, std::memory_order_seq_cst);
+    }
+
+    return nullptr;
+}
+
+bool ThreadPool::Take(int index, size_t lane, Job *&job)
+{
+    if (index != Invalid && workers[index]->queues[lane].Pop(job))
+    {
+        pending[lane].fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    auto &injection = injections[lane];
+    if (injection.size.load(std::memory_order_relaxed) > 0)
+    {
+        std::unique_lock<std::mutex> lock{ injection.mutex };
+        job = injection.Pop();
+        if (job)
+        {
+            pending[lane].fetch_sub(1, std::memory_order_relaxed);
+            return true;
         }
-        if (!tasking)
+    }
+
+    return Steal(index, lane, job);
+}
+
+bool ThreadPool::Steal(int index, size_t lane, Job *&job)
+{
+    if (index != Invalid)
+    {
+        for (auto victim : workers[index]->victims)
         {
-            break;
+            if (workers[victim]->queues[lane].Steal(job))
+            {
+                pending[lane].fetch_sub(1, std::memory_order_relaxed);
+                return true;
+            }
         }
+        return false;
     }
+
+    for (auto &worker : workers)
+    {
+        if (worker->queues[lane].Steal(job))
+        {
+            pending[lane].fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ThreadPool::AcquireBackgroundSlot()
+{
+    int running = backgrounds.load(std::memory_order_relaxed);
+    while (running < backgroundLimit)
+    {
+        if (backgrounds.compare_exchange_weak(running, running + 1, std::memory_order_acquire))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::Execute(Job *job)
+{
+    if (job->IsCancelled())
+    {
+        Discard(job);
+        return;
+    }
+    (*job)();
+    Complete(job);
+}
+
+void ThreadPool::Discard(Job *job)
+{
+    job->Discard();
+    Complete(job);
+}
+
+void ThreadPool::Complete(Job *job)
+{
+    Priority lane = job->Lane();
+    WaitGroup *waitGroup = job->Group();
+    JobPool::Release(job);
+
+    if (waitGroup)
+    {
+        waitGroup->Done();
+    }
+    if (lane == Priority::IO)
+    {
+        return;
+    }
+    if (lane == Priority::Background && backgrounds.fetch_sub(1, std::memory_order_seq_cst) == backgroundLimit)
+    {
+        /* A slot is free again, let a sleeper pick up the waiting background work */
+        if (pending[size_t(Priority::Background)].load(std::memory_order_seq_cst) > 0)
+        {
+            Notify();
+        }
+    }
+    if (unfinished.fetch_sub(1, std::memory_order_seq_cst) == 1)
+    {
+        WakeAll();
+    }
+}
+
+void ThreadPool::Notify()
+{
+    if (sleepers.load(std::memory_order_seq_cst) > 0)
+    {
+        {
+            std::unique_lock<std::mutex> lock{ mutex };
+        }
+        condition.notify_one();
+    }
+}
+
+void ThreadPool::WakeAll()
+{
+    if (sleepers.load(std::memory_order_seq_cst) > 0)
+    {
+        {
+            std::unique_lock<std::mutex> lock{ mutex };
+        }
+        condition.notify_all();
+    }
+}
+
+void ThreadPool::Launch(Job *task)
+{
+    if (task->IsCancelled())
+    {
+        task->Discard();
+        Finish(task);
+        return;
+    }
+
+    Fiber *fiber = FiberPool::Acquire();
+    fiber->Bind(task);
+    Switch(fiber);
+}
+
+/*
+ * @brief Run the fiber until it finishes or until it waits on a wait group that has not
+ *  finished yet, in which case it is parked until Wake hands it back to the pool.
+ */
+void ThreadPool::Switch(Fiber *fiber)
+{
+    while (true)
+    {
+        fiber->Resume();
+        if (fiber->Finished())
+        {
+            Job *task = fiber->Detach();
+            FiberPool::Release(fiber);
+            Finish(task);
+            return;
+        }
+        if (Suspend(fiber))
+        {
+            return;
+        }
+    }
+}
+
+/*
+ * @brief The fiber is only published after it has switched out completely, so nobody
+ *  could resume it while it is still running. The suspended count is raised before the
+ *  wait group is checked, which pairs with Done lowering the counter before Wake reads
+ *  the count, so the fiber is either resumed right away or found by Wake.
+ */
+bool ThreadPool::Suspend(Fiber *fiber)
+{
+    std::unique_lock<std::mutex> lock{ suspended.mutex };
+    suspended.count.fetch_add(1, std::memory_order_seq_cst);
+    if (fiber->Awaiting()->Finished())
+    {
+        suspended.count.fetch_sub(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    fiber->next = suspended.head;
+    suspended.head = fiber;
+
+    /* Keep Join waiting for the suspended fiber, it is released by the resuming job */
+    unfinished.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void ThreadPool::Wake(WaitGroup *waitGroup)
+{
+    if (suspended.count.load(std::memory_order_seq_cst) == 0)
+    {
+        return;
+    }
+
+    Fiber *ready = nullptr;
+    {
+        std::unique_lock<std::mutex> lock{ suspended.mutex };
+        for (Fiber **it = &suspended.head; *it; )
+        {
+            Fiber *fiber = *it;
+            if (fiber->Awaiting() == waitGroup)
+            {
+                *it = fiber->next;
+                fiber->next = ready;
+                ready = fiber;
+                suspended.count.fetch_sub(1, std::memory_order_relaxed);
+            }
+            else
+            {
+                it = &fiber->next;
+            }
+        }
+    }
+
+    while (ready)
+    {
+        Fiber *fiber = ready;
+        ready = fiber->next;
+        fiber->next = nullptr;
+        Dispatch([this, fiber]() -> void {
+            unfinished.fetch_sub(1, std::memory_order_relaxed);
+            Switch(fiber);
+        }, Job::Description{ fiber->Lane() });
+    }
+}
+
+void ThreadPool::Finish(Job *task)
+{
+    WaitGroup *waitGroup = task->Group();
+    JobPool::Release(task);
+    if (waitGroup)
+    {
+        waitGroup->Done();
+    }
+}
+
+/*
+ * @brief Wait until every submitted task has completed. The calling thread helps to
+ *  execute the pending tasks instead of waiting idle. Not to be called from a task
+ *  since the calling task itself is still unfinished, use a WaitGroup there instead.
+ *  IO jobs are not waited for since they might block for as long as they like.
+ */
+void ThreadPool::Join()
+{
+    SLASSERT(WorkerIndex() == Invalid && "ThreadPool::Join could not be called by a worker");
+    Wait([this]() -> bool {
+        return unfinished.load(std::memory_order_seq_cst) <= 0;
+    });
+}
+
+ThreadPool *WaitGroup::Owner() const
+{
+    ThreadPool *owner = pool.load(std::memory_order_relaxed);
+    return owner ? owner : Async::threadPool.get();
+}
+
+void WaitGroup::Done()
+{
+    /* The waiter may go on and tear the pool down as soon as the counter drops */
+    ThreadPool *owner = Owner();
+    if (counter.fetch_sub(1, std::memory_order_seq_cst) == 1)
+    {
+        owner->WakeAll();
+        owner->Wake(this);
+    }
+}
+
+void WaitGroup::Wait()
+{
+    Fiber *fiber = Fiber::Current();
+    if (fiber)
+    {
+        /* A wake up might be meant for an earlier wait group at the same address */
+        while (!Finished())
+        {
+            fiber->Await(this);
+        }
+        return;
+    }
+
+    Owner()->Wait([this]() -> bool {
+        return Finished();
+    });
+}
+
+void TaskGraph::Run()
+{
+    SLASSERT(waitGroup.Finished() && "The graph is still running");
+
+    for (auto &node : nodes)
+    {
+        node->remaining.store(node->dependencies, std::memory_order_relaxed);
+    }
+    waitGroup.Add(nodes.size());
+
+    for (Node i = 0; i < nodes.size(); i++)
+    {
+        if (nodes[i]->dependencies == 0)
+        {
+            Schedule(i);
+        }
+    }
+}
+
+void TaskGraph::Schedule(Node node)
+{
+    Async::Dispatch([this, node]() -> void {
+        auto &vertex = *nodes[node];
+        vertex.task();
+        for (auto &successor : vertex.successors)
+        {
+            if (nodes[successor]->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            {
+                Schedule(successor);
+            }
+        }
+        waitGroup.Done();
+    });
 }
-#pragma sl_enable_optimizations
 
 }
@@ -1,11 +1,15 @@
 #pragma once
 
 #include "Core.h"
+#include "Topology.h"
 
 #include <thread>
-#include <queue>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
 #include <future>
 #include <functional>
+#include <condition_variable>
 
 namespace Immortal
 {
@@ -13,19 +17,11 @@ namespace Immortal
 class Thread
 {
 public:
-    enum class State : uint32_t
-    {
-        Block = BIT(0),
-        Idle  = BIT(1)
-    };
-
-    using Semaphore = State;
-
     static int Self()
     {
 #ifndef __GNUC__
         return GetCurrentThreadId();
-#else 
+#else
         return (int)pthread_self();
 #endif
     }
@@ -33,100 +29,816 @@ public:
 
 using Task = std::function<void()>;
 
+class WaitGroup;
+
+class ThreadPool;
+
+class Fiber;
+
+/*
+ * @brief The lanes of the pool. Critical work always goes first, background work is
+ *  capped to a part of the workers so that it could never starve frame work, and IO
+ *  work runs on its own threads where it is fine to block.
+ */
+enum class Priority : uint32_t
+{
+    Critical   = 0,
+    Normal     = 1,
+    Background = 2,
+    IO         = 3
+};
+
+/*
+ * @brief Cooperative cancellation. Queued jobs bound to a cancelled token are dropped
+ *  instead of being run, running jobs could poll IsCancelled to bail out early. The
+ *  token must outlive the jobs bound to it.
+ */
+class CancellationToken
+{
+public:
+    void Cancel()
+    {
+        cancelled.store(true, std::memory_order_release);
+    }
+
+    void Reset()
+    {
+        cancelled.store(false, std::memory_order_release);
+    }
+
+    bool IsCancelled() const
+    {
+        return cancelled.load(std::memory_order_acquire);
+    }
+
+private:
+    std::atomic<bool> cancelled{ false };
+};
+
+/*
+ * @brief A unit of work for the pool. The callable lives in the inline storage when it
+ *  fits, and only falls back to the heap for the oversized ones. Jobs are recycled by
+ *  the JobPool instead of being freed.
+ */
+class Job
+{
+public:
+    static constexpr size_t Size       = 128;
+    static constexpr size_t Alignment  = 16;
+    static constexpr size_t InlineSize = Size - 6 * sizeof(void *);
+
+    template <class F>
+    static constexpr bool IsInline = sizeof(F) <= InlineSize && alignof(F) <= Alignment && std::is_nothrow_move_constructible_v<F>;
+
+    struct Description
+    {
+        Description(Immortal::Priority priority = Immortal::Priority::Normal, Immortal::WaitGroup *waitGroup = nullptr, const CancellationToken *token = nullptr) :
+            Priority{ priority }, WaitGroup{ waitGroup }, Token{ token }
+        {
+
+        }
+
+        Description(Immortal::WaitGroup *waitGroup) :
+            Description{ Immortal::Priority::Normal, waitGroup }
+        {
+
+        }
+
+        Immortal::Priority Priority;
+
+        Immortal::WaitGroup *WaitGroup;
+
+        const CancellationToken *Token;
+    };
+
+public:
+    template <class F>
+    void Bind(F &&func, const Description &description = {})
+    {
+        using Callable = std::decay_t<F>;
+
+        waitGroup = description.WaitGroup;
+        token     = description.Token;
+        priority  = description.Priority;
+        if constexpr (IsInline<Callable>)
+        {
+            new (storage) Callable{ std::forward<F>(func) };
+            invoke = [](Job *job) -> void {
+                (*std::launder(reinterpret_cast<Callable *>(job->storage)))();
+            };
+            destroy = [](Job *job) -> void {
+                std::launder(reinterpret_cast<Callable *>(job->storage))->~Callable();
+            };
+        }
+        else
+        {
+            *reinterpret_cast<Callable **>(storage) = new Callable{ std::forward<F>(func) };
+            invoke = [](Job *job) -> void {
+                (**reinterpret_cast<Callable **>(job->storage))();
+            };
+            destroy = [](Job *job) -> void {
+                delete *reinterpret_cast<Callable **>(job->storage);
+            };
+        }
+    }
+
+    /*
+     * @brief Run the callable and destroy it. The job could be recycled afterwards.
+     */
+    void operator()()
+    {
+        invoke(this);
+        destroy(this);
+    }
+
+    /*
+     * @brief Destroy the callable without running it.
+     */
+    void Discard()
+    {
+        destroy(this);
+    }
+
+    WaitGroup *Group() const
+    {
+        return waitGroup;
+    }
+
+    Priority Lane() const
+    {
+        return priority;
+    }
+
+    bool IsCancelled() const
+    {
+        return token && token->IsCancelled();
+    }
+
+    void *Storage()
+    {
+        return storage;
+    }
+
+public:
+    Job *next{ nullptr };
+
+private:
+    void (*invoke)(Job *){ nullptr };
+
+    void (*destroy)(Job *){ nullptr };
+
+    WaitGroup *waitGroup{ nullptr };
+
+    const CancellationToken *token{ nullptr };
+
+    Priority priority{ Priority::Normal };
+
+    alignas(Alignment) unsigned char storage[InlineSize];
+};
+
+static_assert(sizeof(Job) == Job::Size, "Job is expected to take two cache lines");
+
+/*
+ * @brief Recycles jobs through a per-thread cache, which exchanges fixed-size batches with
+ *  a shared free list. Jobs are allocated in blocks, so once the pool has warmed up no
+ *  submission touches the heap.
+ */
+class JobPool
+{
+public:
+    static constexpr size_t BatchSize = 64;
+
+    static constexpr size_t BlockSize = 1024;
+
+    struct Batch
+    {
+        Job *head;
+        size_t size;
+        Batch *next;
+    };
+
+    struct Cache
+    {
+        ~Cache();
+
+        Job *head{ nullptr };
+
+        size_t size{ 0 };
+    };
+
+public:
+    static Job *Acquire()
+    {
+        Cache &c = cache;
+        if (!c.head)
+        {
+            Refill(c);
+        }
+
+        Job *job = c.head;
+        c.head = job->next;
+        c.size--;
+        job->next = nullptr;
+        return job;
+    }
+
+    static void Release(Job *job)
+    {
+        Cache &c = cache;
+        job->next = c.head;
+        c.head = job;
+        if (++c.size >= 2 * BatchSize)
+        {
+            Drain(c, BatchSize);
+        }
+    }
+
+private:
+    static void Refill(Cache &c);
+
+    static void Drain(Cache &c, size_t count);
+
+private:
+    static thread_local Cache cache;
+};
+
+
+/*
+ * @brief Counts outstanding work. Wait blocks until the count drops to zero, and the
+ *  waiting thread runs pending tasks of the pool in the meantime instead of spinning.
+ *  Waiting from a fiber job suspends the fiber instead, and the worker moves on.
+ */
+class WaitGroup
+{
+public:
+    explicit WaitGroup(int64_t count = 0) :
+        counter{ count }
+    {
+
+    }
+
+    /*
+     * @brief Count up work the pool is about to run. Done and Wait go to that pool then,
+     *  and to Async::threadPool for a group no pool has added to.
+     */
+    void Add(int64_t count = 1, ThreadPool *owner = nullptr)
+    {
+        if (owner)
+        {
+            pool.store(owner, std::memory_order_relaxed);
+        }
+        counter.fetch_add(count, std::memory_order_relaxed);
+    }
+
+    void Done();
+
+    bool Finished() const
+    {
+        return counter.load(std::memory_order_seq_cst) <= 0;
+    }
+
+    void Wait();
+
+private:
+    ThreadPool *Owner() const;
+
+private:
+    std::atomic<int64_t> counter;
+
+    std::atomic<ThreadPool *> pool{ nullptr };
+};
+
+/*
+ * @brief Chase-Lev work-stealing deque.
+ *  Only the owner thread could Push and Pop (LIFO) on the bottom end, any other thread
+ *  could Steal (FIFO) from the top end. The ring grows on demand and the retired rings
+ *  are kept until destruction since a thief may still be reading from them.
+ */
+template <class T>
+class WorkStealingQueue
+{
+public:
+    static_assert(std::is_trivially_copyable_v<T>, "WorkStealingQueue only holds trivially copyable items");
+
+    struct Ring
+    {
+        Ring(int64_t capacity) :
+            capacity{ capacity },
+            mask{ capacity - 1 },
+            items{ new std::atomic<T>[capacity] }
+        {
+
+        }
+
+        T Load(int64_t i) const
+        {
+            return items[i & mask].load(std::memory_order_relaxed);
+        }
+
+        void Store(int64_t i, T item)
+        {
+            items[i & mask].store(item, std::memory_order_relaxed);
+        }
+
+        Ring *Grow(int64_t bottom, int64_t top) const
+        {
+            Ring *ring = new Ring{ capacity << 1 };
+            for (int64_t i = top; i < bottom; i++)
+            {
+                ring->Store(i, Load(i));
+            }
+            return ring;
+        }
+
+        int64_t capacity;
+        int64_t mask;
+        std::unique_ptr<std::atomic<T>[]> items;
+    };
+
+public:
+    explicit WorkStealingQueue(int64_t capacity = 1024) :
+        top{ 0 },
+        bottom{ 0 },
+        ring{ new Ring{ capacity } }
+    {
+        SLASSERT((capacity & (capacity - 1)) == 0 && "The capacity must be power of 2");
+        garbage.emplace_back(ring.load(std::memory_order_relaxed));
+    }
+
+    void Push(T item)
+    {
+        int64_t b = bottom.load(std::memory_order_relaxed);
+        int64_t t = top.load(std::memory_order_acquire);
+        Ring *r = ring.load(std::memory_order_relaxed);
+
+        if (b - t > r->capacity - 1)
+        {
+            r = r->Grow(b, t);
+            garbage.emplace_back(r);
+            ring.store(r, std::memory_order_release);
+        }
+
+        r->Store(b, item);
+        bottom.store(b + 1, std::memory_order_release);
+    }
+
+    bool Pop(T &item)
+    {
+        int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+        Ring *r = ring.load(std::memory_order_relaxed);
+        bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = top.load(std::memory_order_relaxed);
+
+        if (t > b)
+        {
+            bottom.store(b + 1, std::memory_order_relaxed);
+            return false;
+        }
+
+        item = r->Load(b);
+        if (t == b)
+        {
+            /* Last item, race against the thieves */
+            bool won = top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+            bottom.store(b + 1, std::memory_order_relaxed);
+            return won;
+        }
+        return true;
+    }
+
+    bool Steal(T &item)
+    {
+        int64_t t = top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t b = bottom.load(std::memory_order_acquire);
+
+        if (t >= b)
+        {
+            return false;
+        }
+
+        Ring *r = ring.load(std::memory_order_acquire);
+        item = r->Load(t);
+        return top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+    }
+
+    bool Empty() const
+    {
+        int64_t b = bottom.load(std::memory_order_relaxed);
+        int64_t t = top.load(std::memory_order_relaxed);
+        return b <= t;
+    }
+
+private:
+    alignas(64) std::atomic<int64_t> top;
+
+    alignas(64) std::atomic<int64_t> bottom;
+
+    alignas(64) std::atomic<Ring *> ring;
+
+    std::vector<std::unique_ptr<Ring>> garbage;
+};
+
 class ThreadPool
 {
 public:
-    explicit ThreadPool(int num)
+    static constexpr int Invalid = -1;
+
+    /* Critical, Normal and Background, IO jobs do not go to the workers */
+    static constexpr size_t LaneCount = 3;
+
+    struct Worker
     {
-        for (int i = 0; i < num; i++)
+        WorkStealingQueue<Job *> queues[LaneCount];
+
+        /* The other workers to steal from, the ones sharing a cache first */
+        std::vector<int> victims;
+
+        std::thread thread;
+    };
+
+    struct Queue
+    {
+        void Push(Job *job)
         {
-            semaphores[i] = Thread::State::Idle;
-            threads.emplace_back([=]() -> void {  while (true) {
-                static Thread::Semaphore *semaphore = semaphores + i;
-                Task task;
+            if (tail)
+            {
+                tail->next = job;
+            }
+            else
+            {
+                head = job;
+            }
+            tail = job;
+            size.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        Job *Pop()
+        {
+            Job *job = head;
+            if (job)
+            {
+                head = job->next;
+                if (!head)
                 {
-                    std::unique_lock<std::mutex> lock{ mutex };
-                    condition.wait(lock, [=] { return stopping || !tasks.empty(); });
-                    if (stopping)
-                    {
-                        LOG::INFO("Stopping Thread -> \tid => {0}\thandle => {1}",
-                                  threads[i].get_id(), threads[i].native_handle());
-                        break;
-                    }
-                    *semaphore = Thread::State::Block;
-                    task = std::move(tasks.front());
-                    tasks.pop();
+                    tail = nullptr;
                 }
-                task();
-                *semaphore = Thread::State::Idle;
-            }});
-            LOG::INFO("\tid => {0}\thandle => {1}", threads[i].get_id(), threads[i].native_handle());
+                job->next = nullptr;
+                size.fetch_sub(1, std::memory_order_relaxed);
+            }
+            return job;
         }
-    }
 
-    ~ThreadPool()
+        Job *head{ nullptr };
+        Job *tail{ nullptr };
+        std::atomic<size_t> size{ 0 };
+        std::mutex mutex;
+    };
+
+public:
+    /*
+     * @brief A num of 0 or less takes one worker per processor the placement selects. Under
+     *  the Default placement the workers are left to the OS.
+     */
+    explicit ThreadPool(int num, int ioNum = 2, const Placement &placement = {});
+
+    ~ThreadPool();
+
+    /*
+     * @brief Submit a task without a future. The optional wait group is the lightweight
+     *  completion handle, it is counted up here and down once the task has run or been
+     *  dropped. Nothing is allocated as long as the callable fits in the job.
+     */
+    template <class F>
+    void Dispatch(F &&func, const Job::Description &description = {})
     {
+        Job *job = JobPool::Acquire();
+        job->Bind(std::forward<F>(func), description);
+        if (description.WaitGroup)
         {
-            std::unique_lock<std::mutex> lock{ mutex };
-            stopping = true;
+            description.WaitGroup->Add(1, this);
         }
-        condition.notify_all();
+        Push(job);
+    }
 
-        for (auto &thread : threads)
+    /*
+     * @brief Submit a task that runs on a fiber. Waiting on a wait group from inside the
+     *  task suspends the fiber rather than the worker, so deeply nested work could never
+     *  run out of threads. The wait group is only done once the fiber has finished.
+     */
+    template <class F>
+    void Spawn(F &&func, const Job::Description &description = {})
+    {
+        Job *task = JobPool::Acquire();
+        task->Bind(std::forward<F>(func), description);
+        if (description.WaitGroup)
         {
-            thread.join();
+            description.WaitGroup->Add(1, this);
         }
+        Dispatch([this, task]() -> void {
+            Launch(task);
+        }, Job::Description{ description.Priority });
     }
 
+    /*
+     * @brief Submit a task with a future. The future of a cancelled task reports a
+     *  broken promise.
+     */
     template <class T>
-    auto Enqueue(T task)->std::future<decltype(task())>
+    auto Enqueue(T task, const Job::Description &description = {})->std::future<decltype(task())>
     {
         auto wrapper = std::make_shared<std::packaged_task<decltype(task())()>>(std::move(task));
+        auto future = wrapper->get_future();
+
+        Dispatch([=]() -> void {
+            (*wrapper)();
+        }, description);
+
+        return future;
+    }
+
+    void Join();
+
+    /*
+     * @brief Run pending tasks until ready() turns true. Sleep if there is nothing to
+     *  run, whoever makes ready() true is expected to call WakeAll afterwards.
+     */
+    template <class Predicate>
+    void Wait(Predicate ready)
+    {
+        int index = WorkerIndex();
+        while (!ready())
         {
-            std::unique_lock<std::mutex> lock{ mutex };
-            tasks.emplace([=]() -> void {
-                (*wrapper)();
-            });
+            Job *job = Find(index);
+            if (job)
+            {
+                Execute(job);
+                continue;
+            }
+            Park(ready);
         }
+    }
+
+    void WakeAll();
 
-        condition.notify_one();
-        return wrapper->get_future();
+    /*
+     * @brief Resume the fibers suspended on the wait group.
+     */
+    void Wake(WaitGroup *waitGroup);
+
+    size_t Size() const
+    {
+        return workers.size();
     }
 
-    void Join();
+    /*
+     * @brief The index of the worker the calling thread belongs to, or Invalid
+     *  if the caller is not a worker of this pool.
+     */
+    int WorkerIndex() const
+    {
+        return current.pool == this ? current.index : Invalid;
+    }
 
 private:
-    std::vector<std::thread> threads;
+    void Run(int index);
 
-    Thread::Semaphore semaphores[256];
+    void RunIO();
 
-    std::condition_variable condition;
+    void Push(Job *job);
+
+    Job *Find(int index);
+
+    bool Take(int index, size_t lane, Job *&job);
+
+    bool Steal(int index, size_t lane, Job *&job);
+
+    bool AcquireBackgroundSlot();
+
+    /*
+     * @brief Whether there is a job a worker is allowed to take right now.
+     */
+    bool Runnable(std::memory_order order = std::memory_order_seq_cst) const
+    {
+        return pending[size_t(Priority::Critical)].load(order) > 0 ||
+               pending[size_t(Priority::Normal)].load(order) > 0 ||
+              (pending[size_t(Priority::Background)].load(order) > 0 && backgrounds.load(order) < backgroundLimit);
+    }
+
+    void Execute(Job *job);
 
-    std::queue<Task> tasks;
+    void Discard(Job *job);
+
+    void Complete(Job *job);
+
+    /*
+     * @brief Spin for a short while and then go to sleep until there is pending work or
+     *  ready() turns true. The sleeper count is published before the last check, which
+     *  pairs with Notify and WakeAll publishing their state before reading the sleeper
+     *  count, so that no wake up could get lost between them.
+     */
+    template <class Predicate>
+    void Park(Predicate ready)
+    {
+        for (int i = 0; i < 64; i++)
+        {
+            if (Runnable(std::memory_order_relaxed) || stopping.load(std::memory_order_relaxed) || ready())
+            {
+                return;
+            }
+            std::this_thread::yield();
+        }
+
+        std::unique_lock<std::mutex> lock{ mutex };
+        sleepers.fetch_add(1, std::memory_order_seq_cst);
+        condition.wait(lock, [&] {
+            return Runnable() || stopping.load() || ready();
+        });
+        sleepers.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    void Notify();
+
+    void Launch(Job *task);
+
+    void Switch(Fiber *fiber);
+
+    bool Suspend(Fiber *fiber);
+
+    void Finish(Job *task);
+
+private:
+    std::vector<std::unique_ptr<Worker>> workers;
+
+    Queue injections[LaneCount];
+
+    struct
+    {
+        std::vector<std::thread> threads;
+        Queue queue;
+        std::condition_variable condition;
+    } io;
+
+    std::condition_variable condition;
 
     std::mutex mutex;
 
-    bool stopping{ false };
+    alignas(64) std::atomic<int64_t> pending[LaneCount]{};
+
+    alignas(64) std::atomic<int> backgrounds{ 0 };
+
+    int backgroundLimit{ 1 };
+
+    alignas(64) std::atomic<int64_t> unfinished{ 0 };
+
+    alignas(64) std::atomic<int> sleepers{ 0 };
+
+    std::atomic<bool> stopping{ false };
+
+    struct
+    {
+        std::mutex mutex;
+        Fiber *head{ nullptr };
+        std::atomic<int> count{ 0 };
+    } suspended;
+
+    struct Current
+    {
+        ThreadPool *pool;
+        int index;
+    };
+
+    static thread_local Current current;
+};
+
+/*
+ * @brief A set of tasks with dependencies between them. A task is submitted to the
+ *  pool as soon as all of its predecessors have finished.
+ */
+class TaskGraph
+{
+public:
+    using Node = size_t;
+
+    struct Vertex
+    {
+        Task task;
+
+        std::vector<Node> successors;
+
+        int dependencies{ 0 };
+
+        std::atomic<int> remaining{ 0 };
+    };
+
+public:
+    TaskGraph() = default;
+
+    ~TaskGraph()
+    {
+        Wait();
+    }
+
+    template <class T>
+    Node Emplace(T &&task)
+    {
+        nodes.emplace_back(new Vertex{ Task{ std::forward<T>(task) } });
+        return nodes.size() - 1;
+    }
+
+    template <class T>
+    Node Emplace(T &&task, std::initializer_list<Node> dependencies)
+    {
+        Node node = Emplace(std::forward<T>(task));
+        for (auto &dependency : dependencies)
+        {
+            Precede(dependency, node);
+        }
+        return node;
+    }
+
+    /*
+     * @brief Make the node after wait for the node before to finish.
+     */
+    void Precede(Node before, Node after)
+    {
+        THROWIF(before >= nodes.size() || after >= nodes.size(), SError::OutOfBound);
+        nodes[before]->successors.emplace_back(after);
+        nodes[after]->dependencies++;
+    }
+
+    void Run();
+
+    void Wait()
+    {
+        waitGroup.Wait();
+    }
+
+    size_t Size() const
+    {
+        return nodes.size();
+    }
+
+private:
+    void Schedule(Node node);
+
+private:
+    std::vector<std::unique_ptr<Vertex>> nodes;
+
+    WaitGroup waitGroup;
 };
 
 class Async
 {
 public:
+    using Graph = TaskGraph;
+
+    using WaitGroup = Immortal::WaitGroup;
+
+public:
+    /*
+     * @brief One worker per hardware thread by default, placed by the OS. A placement pins
+     *  the workers by the topology instead, i.e. one per physical core, with the reserved
+     *  cores left to whatever the caller pins there itself.
+     */
     template <bool isLogNeed = false>
-    static void Setup()
+    static void Setup(const Placement &placement = {})
     {
-        int count = std::thread::hardware_concurrency();
-
         Profiler p;
-        LOG::DEBUG<isLogNeed>("Creating {0} Thread(s)", count);
+        threadPool.reset(new ThreadPool{ 0, 2, placement });
 
-        threadPool.reset(new ThreadPool{ count });
+        LOG::DEBUG<isLogNeed>("Created {0} Thread(s)", threadPool->Size());
     }
 
     template <class T>
-    static auto Execute(T &&task)
+    static auto Execute(T &&task, const Job::Description &description = {})
+    {
+        return threadPool->Enqueue(task, description);
+    }
+
+    template <class F>
+    static void Dispatch(F &&func, const Job::Description &description = {})
+    {
+        threadPool->Dispatch(std::forward<F>(func), description);
+    }
+
+    template <class F>
+    static void Dispatch(F &&func, WaitGroup &waitGroup)
     {
-        return threadPool->Enqueue(task);
+        threadPool->Dispatch(std::forward<F>(func), &waitGroup);
+    }
+
+    template <class F>
+    static void Spawn(F &&func, const Job::Description &description = {})
+    {
+        threadPool->Spawn(std::forward<F>(func), description);
+    }
+
+    template <class F>
+    static void Spawn(F &&func, WaitGroup &waitGroup)
+    {
+        threadPool->Spawn(std::forward<F>(func), &waitGroup);
     }
 
     static void Wait()
@@ -134,6 +846,161 @@ public:
         threadPool->Join();
     }
 
+    static void Wait(WaitGroup &waitGroup)
+    {
+        waitGroup.Wait();
+    }
+
+    /*
+     * @brief Split [begin, end) across the pool. The function is either called per index
+     *  as func(i), or per chunk as func(first, last). A grain of 0 lets the chunk size
+     *  adapt to the range and the number of workers. The calling thread takes part in
+     *  the loop and helps the pool while waiting, so nested calls are fine.
+     */
+    template <class Index, class Function>
+    static void ParallelFor(Index begin, Index end, Index grain, Function &&func)
+    {
+        if (end <= begin)
+        {
+            return;
+        }
+
+        size_t count = static_cast<size_t>(end - begin);
+        size_t participants = threadPool->Size() + 1;
+        size_t minimum = grain > 0 ? static_cast<size_t>(grain) : std::max<size_t>(1, count / (participants * 8));
+
+        auto invoke = [&](size_t first, size_t last) -> void {
+            if constexpr (std::is_invocable_v<Function, Index, Index>)
+            {
+                func(begin + static_cast<Index>(first), begin + static_cast<Index>(last));
+            }
+            else
+            {
+                for (size_t i = first; i < last; i++)
+                {
+                    func(begin + static_cast<Index>(i));
+                }
+            }
+        };
+
+        if (count <= minimum)
+        {
+            invoke(0, count);
+            return;
+        }
+
+        /* Guided self-scheduling: large chunks first, shrinking down to the grain size */
+        std::atomic<size_t> cursor{ 0 };
+        auto loop = [&]() -> void {
+            size_t first = cursor.load(std::memory_order_relaxed);
+            while (first < count)
+            {
+                size_t size = std::max(minimum, (count - first) / (participants * 2));
+                size_t last = std::min(count, first + size);
+                if (cursor.compare_exchange_weak(first, last, std::memory_order_relaxed))
+                {
+                    invoke(first, last);
+                    first = cursor.load(std::memory_order_relaxed);
+                }
+            }
+        };
+
+        size_t helpers = std::min(participants, (count + minimum - 1) / minimum) - 1;
+        WaitGroup waitGroup;
+        for (size_t i = 0; i < helpers; i++)
+        {
+            threadPool->Dispatch(loop, &waitGroup);
+        }
+        loop();
+        waitGroup.Wait();
+    }
+
+    template <class Index, class Function>
+    static void ParallelFor(Index begin, Index end, Function &&func)
+    {
+        ParallelFor(begin, end, Index{ 0 }, std::forward<Function>(func));
+    }
+
+    /*
+     * @brief Reduce [begin, end) in parallel. func(first, last, identity) reduces one chunk
+     *  and reduce(lhs, rhs) combines two partial results. The range is cut into fixed
+     *  chunks and the partial results are combined in order, so the result is the same
+     *  from run to run as long as reduce is associative.
+     */
+    template <class Index, class T, class Function, class Reduction>
+    static T ParallelReduce(Index begin, Index end, Index grain, const T &identity, Function &&func, Reduction &&reduce)
+    {
+        if (end <= begin)
+        {
+            return identity;
+        }
+
+        size_t count = static_cast<size_t>(end - begin);
+        size_t size = grain > 0 ? static_cast<size_t>(grain) : std::max<size_t>(1, count / ((threadPool->Size() + 1) * 4));
+        size_t chunks = (count + size - 1) / size;
+
+        /* A line per chunk, so neither std::vector<bool> nor neighbours share the bytes written */
+        struct alignas(64) Partial
+        {
+            T Value;
+        };
+
+        std::vector<Partial> partials(chunks, Partial{ identity });
+        ParallelFor<size_t>(0, chunks, 1, [&](size_t chunk) -> void {
+            Index first = begin + static_cast<Index>(chunk * size);
+            Index last  = begin + static_cast<Index>(std::min(count, (chunk + 1) * size));
+            partials[chunk].Value = func(first, last, identity);
+        });
+
+        T result = identity;
+        for (auto &partial : partials)
+        {
+            result = reduce(result, partial.Value);
+        }
+        return result;
+    }
+
+    /*
+     * @brief Sort the runs of the range in parallel and merge them pairwise, each level of
+     *  merges running in parallel as well. Not stable.
+     */
+    template <class RandomIt, class Compare = std::less<>>
+    static void ParallelSort(RandomIt first, RandomIt last, Compare compare = Compare{})
+    {
+        static constexpr size_t SequentialThreshold = 8192;
+
+        size_t count = static_cast<size_t>(std::distance(first, last));
+        size_t runs = std::min(threadPool->Size() + 1, count / SequentialThreshold);
+        if (runs < 2)
+        {
+            std::sort(first, last, compare);
+            return;
+        }
+
+        size_t size = (count + runs - 1) / runs;
+        auto bound = [&](size_t run) -> RandomIt {
+            return first + static_cast<ptrdiff_t>(std::min(count, run * size));
+        };
+
+        ParallelFor<size_t>(0, runs, 1, [&](size_t run) -> void {
+            std::sort(bound(run), bound(run + 1), compare);
+        });
+
+        for (size_t width = 1; width < runs; width <<= 1)
+        {
+            size_t merges = (runs + 2 * width - 1) / (2 * width);
+            ParallelFor<size_t>(0, merges, 1, [&](size_t merge) -> void {
+                size_t left = merge * 2 * width;
+                size_t middle = std::min(runs, left + width);
+                size_t right = std::min(runs, left + 2 * width);
+                if (middle < right)
+                {
+                    std::inplace_merge(bound(left), bound(middle), bound(right), compare);
+                }
+            });
+        }
+    }
+
 public:
     static std::unique_ptr<ThreadPool> threadPool;
 };
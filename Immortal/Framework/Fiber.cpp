@@ -0,0 +1,167 @@
+#include "impch.h"
+#include "Fiber.h"
+
+namespace Immortal
+{
+
+thread_local Fiber *Fiber::running{ nullptr };
+
+static struct
+{
+    std::mutex mutex;
+    Fiber *head{ nullptr };
+    std::vector<std::unique_ptr<Fiber>> fibers;
+} fiberPool;
+
+#ifdef WINDOWS
+/*
+ * @brief Switching to a fiber requires the thread itself to be a fiber. Threads are
+ *  converted on their first switch and converted back when they exit.
+ */
+struct ThreadFiber
+{
+    ThreadFiber()
+    {
+        if (!IsThreadAFiber())
+        {
+            converted = ConvertThreadToFiberEx(nullptr, FIBER_FLAG_FLOAT_SWITCH) != nullptr;
+        }
+    }
+
+    ~ThreadFiber()
+    {
+        if (converted)
+        {
+            ConvertFiberToThread();
+        }
+    }
+
+    bool converted{ false };
+};
+
+void WINAPI Fiber::Entry(void *parameter)
+{
+    static_cast<Fiber *>(parameter)->Main();
+}
+
+Fiber::Fiber(size_t stackSize)
+{
+    handle = CreateFiberEx(0, stackSize, FIBER_FLAG_FLOAT_SWITCH, Entry, this);
+    THROWIF(!handle, SError::NullPointerReference);
+}
+
+Fiber::~Fiber()
+{
+    DeleteFiber(handle);
+}
+
+void Fiber::Resume()
+{
+    static thread_local ThreadFiber threadFiber;
+
+    Fiber *previous = running;
+    running  = this;
+    awaiting = nullptr;
+    caller   = GetCurrentFiber();
+    SwitchToFiber(handle);
+    running  = previous;
+}
+
+void Fiber::Suspend()
+{
+    SwitchToFiber(caller);
+}
+#else
+/*
+ * @brief makecontext only passes int arguments, so the fiber pointer is split into two halves.
+ */
+void Fiber::Entry(uint32_t high, uint32_t low)
+{
+    auto fiber = reinterpret_cast<Fiber *>((uintptr_t(high) << 32) | uintptr_t(low));
+    fiber->Main();
+}
+
+Fiber::Fiber(size_t stackSize) :
+    stack{ new uint8_t[stackSize] }
+{
+    getcontext(&context);
+    context.uc_stack.ss_sp   = stack.get();
+    context.uc_stack.ss_size = stackSize;
+    context.uc_link          = nullptr;
+
+    auto address = reinterpret_cast<uintptr_t>(this);
+    makecontext(&context, reinterpret_cast<void(*)()>(Entry), 2, uint32_t(uint64_t(address) >> 32), uint32_t(address));
+}
+
+Fiber::~Fiber()
+{
+
+}
+
+void Fiber::Resume()
+{
+    Fiber *previous = running;
+    running  = this;
+    awaiting = nullptr;
+    swapcontext(&caller, &context);
+    running  = previous;
+}
+
+void Fiber::Suspend()
+{
+    swapcontext(&context, &caller);
+}
+#endif
+
+/*
+ * @brief The fiber never returns from here, it runs one job after another for as long
+ *  as the pool hands them out.
+ */
+void Fiber::Main()
+{
+    while (true)
+    {
+        (*job)();
+        finished = true;
+        Suspend();
+    }
+}
+
+void Fiber::Await(WaitGroup *waitGroup)
+{
+    awaiting = waitGroup;
+    Suspend();
+}
+
+Fiber *Fiber::Current()
+{
+    return running;
+}
+
+Fiber *FiberPool::Acquire()
+{
+    {
+        std::unique_lock<std::mutex> lock{ fiberPool.mutex };
+        Fiber *fiber = fiberPool.head;
+        if (fiber)
+        {
+            fiberPool.head = fiber->next;
+            fiber->next = nullptr;
+            return fiber;
+        }
+    }
+
+    auto fiber = new Fiber;
+    std::unique_lock<std::mutex> lock{ fiberPool.mutex };
+    fiberPool.fibers.emplace_back(fiber);
+    return fiber;
+}
+
+void FiberPool::Release(Fiber *fiber)
+{
+    std::unique_lock<std::mutex> lock{ fiberPool.mutex };
+    fiber->next = fiberPool.head;
+    fiberPool.head = fiber;
+}
+
+}
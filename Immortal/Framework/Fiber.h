@@ -0,0 +1,127 @@
+#pragma once
+
+#include "Core.h"
+#include "Async.h"
+
+#ifndef WINDOWS
+#include <ucontext.h>
+#endif
+
+namespace Immortal
+{
+
+/*
+ * @brief A user mode execution context with a stack of its own. A job running on a
+ *  fiber could suspend itself while it waits for other work, the worker then goes on
+ *  with something else and the fiber is resumed later on, possibly by another worker.
+ *  Since a fiber migrates between threads, thread local state must not be held across
+ *  a wait inside a fiber.
+ */
+class Fiber
+{
+public:
+    static constexpr size_t StackSize = 256 * 1024;
+
+public:
+    Fiber(size_t stackSize = StackSize);
+
+    ~Fiber();
+
+    Fiber(const Fiber &) = delete;
+
+    Fiber &operator=(const Fiber &) = delete;
+
+    void Bind(Job *task)
+    {
+        job      = task;
+        finished = false;
+    }
+
+    /*
+     * @brief Run the fiber on the calling thread until it either finishes its job or
+     *  waits for a wait group.
+     */
+    void Resume();
+
+    /*
+     * @brief Switch back to whoever resumed the fiber. Only to be called from the fiber
+     *  itself, the resumer decides when to come back by looking at Awaiting.
+     */
+    void Await(WaitGroup *waitGroup);
+
+    Job *Detach()
+    {
+        Job *task = job;
+        job = nullptr;
+        return task;
+    }
+
+    bool Finished() const
+    {
+        return finished;
+    }
+
+    WaitGroup *Awaiting() const
+    {
+        return awaiting;
+    }
+
+    Priority Lane() const
+    {
+        return job->Lane();
+    }
+
+    /*
+     * @brief The fiber the calling thread is running, nullptr if it is not on a fiber.
+     */
+    static Fiber *Current();
+
+public:
+    Fiber *next{ nullptr };
+
+private:
+#ifdef WINDOWS
+    static void WINAPI Entry(void *parameter);
+#else
+    static void Entry(uint32_t high, uint32_t low);
+#endif
+
+    void Main();
+
+    void Suspend();
+
+private:
+    Job *job{ nullptr };
+
+    WaitGroup *awaiting{ nullptr };
+
+    bool finished{ true };
+
+#ifdef WINDOWS
+    void *handle{ nullptr };
+
+    void *caller{ nullptr };
+#else
+    std::unique_ptr<uint8_t[]> stack;
+
+    ucontext_t context;
+
+    ucontext_t caller;
+#endif
+
+    static thread_local Fiber *running;
+};
+
+/*
+ * @brief Fibers are expensive to create because of their stacks, so the finished ones
+ *  are kept around for the next fiber job instead of being destroyed.
+ */
+class FiberPool
+{
+public:
+    static Fiber *Acquire();
+
+    static void Release(Fiber *fiber);
+};
+
+}
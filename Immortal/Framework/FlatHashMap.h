@@ -0,0 +1,222 @@
+#pragma once
+
+#include "Core.h"
+
+#include <algorithm>
+#include <functional>
+#include <utility>
+#include <vector>
+
+namespace Immortal
+{
+
+/*
+ * @brief An open addressing hash map with linear probing over one flat array, so a lookup
+ *  is a multiply, a shift and usually a single cache line. Erasing shifts the following
+ *  entries of the cluster back instead of leaving tombstones, so lookups never slow down
+ *  however often entries come and go. Pointers into the map are only good until the next
+ *  insertion.
+ */
+template <class K, class V, class Hash = std::hash<K>>
+class FlatHashMap
+{
+public:
+    static constexpr size_t MinCapacity = 16;
+
+    /* Grows past 3/4 full, clusters stay short for linear probing */
+    static constexpr size_t LoadNumerator = 3;
+
+    static constexpr size_t LoadDenominator = 4;
+
+    struct Slot
+    {
+        K Key;
+        V Value;
+    };
+
+public:
+    FlatHashMap() = default;
+
+    V *Find(const K &key)
+    {
+        return const_cast<V *>(std::as_const(*this).Find(key));
+    }
+
+    const V *Find(const K &key) const
+    {
+        if (!size)
+        {
+            return nullptr;
+        }
+        for (size_t index = Home(key); used[index]; index = (index + 1) & mask)
+        {
+            if (slots[index].Key == key)
+            {
+                return &slots[index].Value;
+            }
+        }
+        return nullptr;
+    }
+
+    bool Contains(const K &key) const
+    {
+        return Find(key) != nullptr;
+    }
+
+    /*
+     * @brief Insert the value if the key is not there yet. Returns the value of the key
+     *  and whether it was inserted.
+     */
+    template <class... Args>
+    std::pair<V *, bool> Emplace(const K &key, Args &&... args)
+    {
+        if ((size + 1) * LoadDenominator > slots.size() * LoadNumerator)
+        {
+            Rehash(std::max(MinCapacity, slots.size() * 2));
+        }
+
+        size_t index = Home(key);
+        for (; used[index]; index = (index + 1) & mask)
+        {
+            if (slots[index].Key == key)
+            {
+                return { &slots[index].Value, false };
+            }
+        }
+
+        used[index]  = true;
+        slots[index] = Slot{ key, V{ std::forward<Args>(args)... } };
+        size++;
+
+        return { &slots[index].Value, true };
+    }
+
+    V &operator[](const K &key)
+    {
+        return *Emplace(key).first;
+    }
+
+    bool Erase(const K &key)
+    {
+        if (!size)
+        {
+            return false;
+        }
+
+        size_t index = Home(key);
+        for (; used[index]; index = (index + 1) & mask)
+        {
+            if (slots[index].Key == key)
+            {
+                break;
+            }
+        }
+        if (!used[index])
+        {
+            return false;
+        }
+
+        /* Pull back every later entry of the cluster that may live before the hole */
+        size_t hole = index;
+        for (size_t next = (hole + 1) & mask; used[next]; next = (next + 1) & mask)
+        {
+            size_t home = Home(slots[next].Key);
+            if (((next - home) & mask) >= ((next - hole) & mask))
+            {
+                slots[hole] = std::move(slots[next]);
+                hole = next;
+            }
+        }
+        used[hole]  = false;
+        slots[hole] = Slot{};
+        size--;
+
+        return true;
+    }
+
+    void Reserve(size_t count)
+    {
+        size_t capacity = MinCapacity;
+        while (count * LoadDenominator > capacity * LoadNumerator)
+        {
+            capacity *= 2;
+        }
+        if (capacity > slots.size())
+        {
+            Rehash(capacity);
+        }
+    }
+
+    void Clear()
+    {
+        slots.clear();
+        used.clear();
+        size = 0;
+        mask = 0;
+    }
+
+    size_t Size() const
+    {
+        return size;
+    }
+
+    bool Empty() const
+    {
+        return size == 0;
+    }
+
+    template <class Callback>
+    void Each(Callback &&callback) const
+    {
+        for (size_t i = 0; i < slots.size(); i++)
+        {
+            if (used[i])
+            {
+                callback(slots[i].Key, slots[i].Value);
+            }
+        }
+    }
+
+private:
+    /* Fibonacci hashing, so close hashes, like the identity hash of a counter, spread out */
+    size_t Home(const K &key) const
+    {
+        uint64_t hash = uint64_t(Hash{}(key)) * 0x9E3779B97F4A7C15ull;
+        return size_t(hash >> 32) & mask;
+    }
+
+    void Rehash(size_t capacity)
+    {
+        std::vector<Slot> oldSlots(capacity);
+        std::vector<uint8_t> oldUsed(capacity, false);
+        oldSlots.swap(slots);
+        oldUsed.swap(used);
+        mask = capacity - 1;
+
+        for (size_t i = 0; i < oldSlots.size(); i++)
+        {
+            if (!oldUsed[i])
+            {
+                continue;
+            }
+            size_t index = Home(oldSlots[i].Key);
+            while (used[index])
+            {
+                index = (index + 1) & mask;
+            }
+            used[index]  = true;
+            slots[index] = std::move(oldSlots[i]);
+        }
+    }
+
+private:
+    std::vector<Slot> slots;
+
+    std::vector<uint8_t> used;
+
+    size_t size{ 0 };
+
+    size_t mask{ 0 };
+};
+
+}
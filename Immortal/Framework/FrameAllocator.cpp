@@ -0,0 +1,129 @@
+#include "impch.h"
+#include "FrameAllocator.h"
+
+namespace Immortal
+{
+
+std::atomic<uint64_t> FrameAllocator::current{ 0 };
+
+thread_local FrameAllocator::Arena *FrameAllocator::arena{ nullptr };
+
+static struct
+{
+    std::mutex mutex;
+    std::vector<std::unique_ptr<FrameAllocator::Arena>> arenas;
+    std::vector<FrameAllocator::Arena *> idle;
+    std::atomic<size_t> reserved{ 0 };
+    uint64_t total{ 0 };
+    FrameAllocator::Statistics stats{};
+} registry;
+
+/*
+ * @brief Hands the arena of an exiting thread over to the next new thread. What the
+ *  thread allocated stays where it is until its frame comes around again, so the arena
+ *  could be picked up right away.
+ */
+static thread_local struct ArenaOwner
+{
+    ~ArenaOwner()
+    {
+        if (arena)
+        {
+            std::unique_lock<std::mutex> lock{ registry.mutex };
+            registry.idle.emplace_back(arena);
+        }
+    }
+
+    FrameAllocator::Arena *arena{ nullptr };
+} owner;
+
+/*
+ * @brief The arenas belong to the registry rather than to their threads, memory handed
+ *  out by a thread stays valid for its frames even after the thread has exited.
+ */
+FrameAllocator::Arena *FrameAllocator::Register()
+{
+    std::unique_lock<std::mutex> lock{ registry.mutex };
+    if (!registry.idle.empty())
+    {
+        owner.arena = registry.idle.back();
+        registry.idle.pop_back();
+        return owner.arena;
+    }
+
+    auto &arena = registry.arenas.emplace_back(new Arena);
+    arena->frame = current.load(std::memory_order_acquire);
+    owner.arena = arena.get();
+    return owner.arena;
+}
+
+void FrameAllocator::Rewind(Arena *arena, uint64_t frame)
+{
+    Buffer &buffer = arena->buffers[frame % FramesInFlight];
+
+#ifdef SLDEBUG
+    /* Poison what the frame left behind, so a stale pointer reads garbage instead of old data */
+    for (size_t i = 0; i < buffer.chunks.size() && i <= buffer.current; i++)
+    {
+        auto &chunk = buffer.chunks[i];
+        memset(chunk.data.get(), 0xCD, i == buffer.current ? buffer.offset : chunk.size);
+    }
+#endif
+
+    buffer.current = 0;
+    buffer.offset  = 0;
+    arena->frame   = frame;
+}
+
+/*
+ * @brief Move on to the next chunk that is large enough, and only allocate one if
+ *  there is none left. Chunks are kept, so a steady frame stops allocating at all.
+ */
+void *FrameAllocator::Grow(Buffer &buffer, size_t size, size_t alignment)
+{
+    size_t required = size + alignment;
+    size_t next = buffer.chunks.empty() ? 0 : buffer.current + 1;
+
+    auto it = std::find_if(buffer.chunks.begin() + next, buffer.chunks.end(), [=](const Chunk &chunk) -> bool {
+        return chunk.size >= required;
+    });
+    if (it == buffer.chunks.end())
+    {
+        size_t capacity = std::max(ChunkSize, required);
+        buffer.chunks.emplace_back(Chunk{ std::unique_ptr<uint8_t[]>{ new uint8_t[capacity] }, capacity });
+        registry.reserved.fetch_add(capacity, std::memory_order_relaxed);
+        it = buffer.chunks.end() - 1;
+    }
+    std::iter_swap(buffer.chunks.begin() + next, it);
+
+    buffer.current = next;
+    buffer.offset  = 0;
+    return Bump(buffer, size, alignment);
+}
+
+void FrameAllocator::BeginFrame()
+{
+    std::unique_lock<std::mutex> lock{ registry.mutex };
+
+    uint64_t total = 0;
+    for (auto &arena : registry.arenas)
+    {
+        total += arena->allocated.load(std::memory_order_relaxed);
+    }
+
+    registry.stats.Frame          = current.load(std::memory_order_relaxed);
+    registry.stats.BytesAllocated = total - registry.total;
+    registry.stats.BytesReserved  = registry.reserved.load(std::memory_order_relaxed);
+    registry.stats.ArenaCount     = registry.arenas.size();
+    registry.total = total;
+
+    current.fetch_add(1, std::memory_order_release);
+}
+
+FrameAllocator::Statistics FrameAllocator::Stats()
+{
+    std::unique_lock<std::mutex> lock{ registry.mutex };
+    return registry.stats;
+}
+
+}
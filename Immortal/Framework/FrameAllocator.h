@@ -0,0 +1,191 @@
+#pragma once
+
+#include "Core.h"
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+namespace Immortal
+{
+
+/*
+ * @brief Transient memory for work that only lives through a frame. Every thread bumps
+ *  from its own arena, so allocating is a pointer increment without any lock, and
+ *  nothing is ever freed on its own. Each arena is buffered per frame in flight, memory
+ *  handed out in one frame stays valid until the same buffer comes around again.
+ */
+class FrameAllocator
+{
+public:
+    static constexpr size_t FramesInFlight = 3;
+
+    static constexpr size_t ChunkSize = 1024 * 1024;
+
+    static constexpr size_t DefaultAlignment = 16;
+
+    struct Chunk
+    {
+        std::unique_ptr<uint8_t[]> data;
+        size_t size;
+    };
+
+    /*
+     * @brief The memory of one thread for one frame: a list of chunks that is rewound
+     *  instead of being freed when its frame comes around again.
+     */
+    struct Buffer
+    {
+        std::vector<Chunk> chunks;
+        size_t current{ 0 };
+        size_t offset{ 0 };
+    };
+
+    struct Arena
+    {
+        Buffer buffers[FramesInFlight];
+        uint64_t frame{ 0 };
+        std::atomic<uint64_t> allocated{ 0 };
+    };
+
+    struct Statistics
+    {
+        uint64_t Frame;
+        size_t   BytesAllocated;
+        size_t   BytesReserved;
+        size_t   ArenaCount;
+    };
+
+public:
+    static void *Allocate(size_t size, size_t alignment = DefaultAlignment)
+    {
+        Arena *arena = CurrentArena();
+        uint64_t frame = current.load(std::memory_order_acquire);
+        if (arena->frame != frame)
+        {
+            Rewind(arena, frame);
+        }
+
+        Buffer &buffer = arena->buffers[frame % FramesInFlight];
+        void *memory = buffer.current < buffer.chunks.size() ? Bump(buffer, size, alignment) : nullptr;
+        if (!memory)
+        {
+            memory = Grow(buffer, size, alignment);
+        }
+        arena->allocated.fetch_add(size, std::memory_order_relaxed);
+
+        return memory;
+    }
+
+    template <class T, class... Args>
+    static T *New(Args &&... args)
+    {
+        return new (Allocate(sizeof(T), alignof(T))) T{ std::forward<Args>(args)... };
+    }
+
+    template <class T>
+    static T *NewArray(size_t count)
+    {
+        return new (Allocate(sizeof(T) * count, alignof(T))) T[count];
+    }
+
+    /*
+     * @brief Start a new frame. The arenas rewind lazily on their next allocation, so
+     *  no thread ever touches the arena of another one.
+     */
+    static void BeginFrame();
+
+    /*
+     * @brief The frame the allocations go to now. Memory handed out in a frame is
+     *  recycled once FramesInFlight more have begun.
+     */
+    static uint64_t Frame()
+    {
+        return current.load(std::memory_order_acquire);
+    }
+
+    /*
+     * @brief The counters of the last completed frame.
+     */
+    static Statistics Stats();
+
+private:
+    static Arena *CurrentArena()
+    {
+        if (!arena)
+        {
+            arena = Register();
+        }
+        return arena;
+    }
+
+    static Arena *Register();
+
+    static void Rewind(Arena *arena, uint64_t frame);
+
+    static void *Bump(Buffer &buffer, size_t size, size_t alignment)
+    {
+        Chunk &chunk = buffer.chunks[buffer.current];
+        uintptr_t base    = reinterpret_cast<uintptr_t>(chunk.data.get());
+        uintptr_t address = (base + buffer.offset + alignment - 1) & ~uintptr_t(alignment - 1);
+        if (address + size > base + chunk.size)
+        {
+            return nullptr;
+        }
+        buffer.offset = address + size - base;
+        return reinterpret_cast<void *>(address);
+    }
+
+    static void *Grow(Buffer &buffer, size_t size, size_t alignment);
+
+private:
+    static std::atomic<uint64_t> current;
+
+    static thread_local Arena *arena;
+};
+
+/*
+ * @brief Hook frame memory into the containers of the standard library. Deallocation is
+ *  a no-op, the memory goes back when the frame is recycled.
+ */
+template <class T>
+class TransientAllocator
+{
+public:
+    using value_type = T;
+
+    TransientAllocator() = default;
+
+    template <class U>
+    TransientAllocator(const TransientAllocator<U> &)
+    {
+
+    }
+
+    T *allocate(size_t n)
+    {
+        return static_cast<T *>(FrameAllocator::Allocate(n * sizeof(T), std::max(alignof(T), FrameAllocator::DefaultAlignment)));
+    }
+
+    void deallocate(T *, size_t)
+    {
+
+    }
+
+    template <class U>
+    bool operator==(const TransientAllocator<U> &) const
+    {
+        return true;
+    }
+
+    template <class U>
+    bool operator!=(const TransientAllocator<U> &) const
+    {
+        return false;
+    }
+};
+
+template <class T>
+using FrameVector = std::vector<T, TransientAllocator<T>>;
+
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include "Core.h"
+#include "VectorBatch.h"
+
+#include <algorithm>
+
+namespace Immortal
+{
+
+struct BoundingBox
+{
+    BoundingBox() = default;
+
+    BoundingBox(const Vector3 &min, const Vector3 &max) :
+        Min{ min },
+        Max{ max }
+    {
+
+    }
+
+    void Merge(const Vector3 &point)
+    {
+        for (int i = 0; i < 3; i++)
+        {
+            Min[i] = std::min(Min[i], point[i]);
+            Max[i] = std::max(Max[i], point[i]);
+        }
+    }
+
+    Vector3 Center() const
+    {
+        return (Min + Max) * 0.5f;
+    }
+
+    Vector3 Extent() const
+    {
+        return (Max - Min) * 0.5f;
+    }
+
+    /*
+     * @brief The box in the space of transform, as a center and half extents. The extents
+     *  are those of the box around the transformed box (Arvo), so it only ever grows.
+     */
+    void Transform(const Matrix4 &transform, Vector3 &center, Vector3 &extent) const
+    {
+        Vector3 localCenter = Center();
+        Vector3 localExtent = Extent();
+        for (int row = 0; row < 3; row++)
+        {
+            center[row] = transform[3][row];
+            extent[row] = 0.0f;
+            for (int column = 0; column < 3; column++)
+            {
+                center[row] += transform[column][row] * localCenter[column];
+                extent[row] += std::fabs(transform[column][row]) * localExtent[column];
+            }
+        }
+    }
+
+    Vector3 Min{ 0.0f, 0.0f, 0.0f };
+
+    Vector3 Max{ 0.0f, 0.0f, 0.0f };
+};
+
+/*
+ * @brief The six planes of a view projection (Gribb and Hartmann), facing inwards. The
+ *  near plane is the one of a -1 to 1 depth range, for a 0 to 1 projection that is a
+ *  little further back than needed, which only keeps a few more boxes.
+ */
+class Frustum
+{
+public:
+    enum Side
+    {
+        Left = 0,
+        Right,
+        Bottom,
+        Top,
+        Near,
+        Far
+    };
+
+public:
+    Frustum(const Matrix4 &viewProjection)
+    {
+        Vector4 rows[4];
+        for (int i = 0; i < 4; i++)
+        {
+            rows[i] = Vector4{ viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i] };
+        }
+
+        planes[Left]   = rows[3] + rows[0];
+        planes[Right]  = rows[3] - rows[0];
+        planes[Bottom] = rows[3] + rows[1];
+        planes[Top]    = rows[3] - rows[1];
+        planes[Near]   = rows[3] + rows[2];
+        planes[Far]    = rows[3] - rows[2];
+    }
+
+    const Vector4 &Plane(Side side) const
+    {
+        return planes[side];
+    }
+
+    void Cull(const Vector::BoundsStreams &bounds, size_t count, uint8_t *visible) const
+    {
+        Vector::CullBounds(planes, bounds, count, visible);
+    }
+
+private:
+    Vector4 planes[6];
+};
+
+}
@@ -0,0 +1,92 @@
+#include "impch.h"
+#include "MappedFile.h"
+
+#ifndef WINDOWS
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Immortal
+{
+
+#ifdef WINDOWS
+MappedFile::MappedFile(const std::string &path)
+{
+    HANDLE handle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (handle == INVALID_HANDLE_VALUE)
+    {
+        return;
+    }
+    file = handle;
+
+    LARGE_INTEGER length{};
+    if (!GetFileSizeEx(handle, &length) || length.QuadPart == 0)
+    {
+        return;
+    }
+
+    mapping = CreateFileMappingA(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping)
+    {
+        return;
+    }
+
+    data = reinterpret_cast<const uint8_t *>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    if (data)
+    {
+        size = size_t(length.QuadPart);
+    }
+}
+
+MappedFile::~MappedFile()
+{
+    if (data)
+    {
+        UnmapViewOfFile(data);
+    }
+    if (mapping)
+    {
+        CloseHandle(mapping);
+    }
+    if (file)
+    {
+        CloseHandle(file);
+    }
+}
+#else
+MappedFile::MappedFile(const std::string &path)
+{
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        return;
+    }
+
+    struct stat status{};
+    if (fstat(fd, &status) == 0 && status.st_size > 0)
+    {
+        void *view = mmap(nullptr, size_t(status.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        if (view != MAP_FAILED)
+        {
+            madvise(view, size_t(status.st_size), MADV_SEQUENTIAL);
+            data = reinterpret_cast<const uint8_t *>(view);
+            size = size_t(status.st_size);
+        }
+    }
+
+    /* The mapping keeps the file alive on its own */
+    close(fd);
+}
+
+MappedFile::~MappedFile()
+{
+    if (data)
+    {
+        munmap(const_cast<uint8_t *>(data), size);
+    }
+}
+#endif
+
+}
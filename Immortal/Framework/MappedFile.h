@@ -0,0 +1,69 @@
+#pragma once
+
+#include "Core.h"
+
+#include <string>
+
+namespace Immortal
+{
+
+/*
+ * @brief A read only view of a whole file mapped into memory. Pages are brought in by the
+ *  system as they are touched, nothing is read up front, and the data stays valid for as
+ *  long as the mapping lives.
+ */
+class MappedFile
+{
+public:
+    MappedFile() = default;
+
+    MappedFile(const std::string &path);
+
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    const uint8_t *Data() const
+    {
+        return data;
+    }
+
+    size_t Size() const
+    {
+        return size;
+    }
+
+    explicit operator bool() const
+    {
+        return data != nullptr;
+    }
+
+    /*
+     * @brief count objects of type T starting at offset, nullptr if they run past the end
+     *  of the file or the offset is not aligned for T.
+     */
+    template <class T>
+    const T *At(uint64_t offset, uint64_t count = 1) const
+    {
+        if (offset > size || count > (size - offset) / sizeof(T) || offset % alignof(T))
+        {
+            return nullptr;
+        }
+        return reinterpret_cast<const T *>(data + offset);
+    }
+
+private:
+    const uint8_t *data{ nullptr };
+
+    size_t size{ 0 };
+
+#ifdef WINDOWS
+    void *file{ nullptr };
+
+    void *mapping{ nullptr };
+#endif
+};
+
+}
@@ -0,0 +1,392 @@
+#pragma once
+
+#include "Core.h"
+#include "FrameAllocator.h"
+
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+
+namespace Immortal
+{
+
+template <class T>
+class ResourceTable;
+
+/*
+ * @brief A 32 bit reference to a resource of the table of T, the slot index in the low
+ *  bits and the generation of the slot in the high ones. A handle to a released resource
+ *  resolves to nullptr instead of to whatever took its slot afterwards. Copying one is
+ *  copying an integer, the same resource always has the same handle, so comparing two is
+ *  comparing what they refer to.
+ */
+template <class T>
+class Handle
+{
+public:
+    static constexpr uint32_t IndexBits = 20;
+
+    static constexpr uint32_t IndexMask = (1u << IndexBits) - 1;
+
+    static constexpr uint32_t GenerationMask = ~0u >> IndexBits;
+
+public:
+    Handle() = default;
+
+    /*
+     * @brief Intern the resource in its table. That takes a lock and a lookup, so it is
+     *  meant to happen once per resource, not every time one is passed along.
+     */
+    explicit Handle(const std::shared_ptr<T> &resource);
+
+    Handle(uint32_t index, uint32_t generation) :
+        value{ (generation << IndexBits) | index }
+    {
+
+    }
+
+    uint32_t Index() const
+    {
+        return value & IndexMask;
+    }
+
+    uint32_t Generation() const
+    {
+        return value >> IndexBits;
+    }
+
+    uint32_t Value() const
+    {
+        return value;
+    }
+
+    T *Get() const;
+
+    std::shared_ptr<T> Share() const;
+
+    T *operator->() const
+    {
+        return Get();
+    }
+
+    T &operator*() const
+    {
+        return *Get();
+    }
+
+    explicit operator bool() const
+    {
+        return Get() != nullptr;
+    }
+
+    bool operator==(const Handle &other) const
+    {
+        return value == other.value;
+    }
+
+    bool operator!=(const Handle &other) const
+    {
+        return value != other.value;
+    }
+
+private:
+    /* Generations start at 1, so the null handle never resolves */
+    uint32_t value{ 0 };
+};
+
+/*
+ * @brief The owner of every resource of type T a handle refers to. Adding the same
+ *  resource twice gives the same handle and the table holds one reference to it, counted
+ *  by Retain and Release, i.e. by the scene when a component takes a handle or gives it
+ *  up. The counting never happens when a handle is copied or resolved. A resource that
+ *  nobody retained stays until Clear. Slots live in blocks that never move, so resolving
+ *  a handle needs no lock while another thread adds a resource.
+ *
+ *  Get hands out a bare pointer that nothing counts, so a resource must never be freed
+ *  while another thread may still use one. Release therefore never frees: the last count
+ *  only queues the slot, and BeginFrame retires it once every packet and every frame in
+ *  flight that could have resolved it is done. A pointer resolved in a frame is valid
+ *  until then, and must not be kept any longer.
+ */
+template <class T>
+class ResourceTable
+{
+public:
+    static constexpr uint32_t BlockSize = 1024;
+
+    static constexpr uint32_t MaxBlocks = (Handle<T>::IndexMask + 1) / BlockSize;
+
+    struct Slot
+    {
+        std::shared_ptr<T> Resource;
+        std::atomic<T *> Pointer{ nullptr };
+        std::atomic<uint32_t> Generation{ 1 };
+        uint32_t Count{ 0 };
+        uint32_t Next{ 0 };
+
+        /* The frame the last count went in, while it waits to be retired */
+        uint64_t Released{ 0 };
+    };
+
+    /*
+     * @brief The frames a released slot waits for: one for the packet simulated ahead of
+     *  the one on screen, and the ones the GPU may still be working on.
+     */
+    static constexpr uint64_t RetireDelay = 1 + FrameAllocator::FramesInFlight;
+
+public:
+    static ResourceTable &Instance()
+    {
+        static ResourceTable table;
+        return table;
+    }
+
+    ResourceTable() = default;
+
+    ResourceTable(const ResourceTable &) = delete;
+
+    ResourceTable &operator=(const ResourceTable &) = delete;
+
+    /*
+     * @brief The handle of the resource, adding it the first time. Adding does not count,
+     *  whoever keeps the handle retains it.
+     */
+    Handle<T> Add(const std::shared_ptr<T> &resource)
+    {
+        if (!resource)
+        {
+            return Handle<T>{};
+        }
+
+        std::lock_guard<std::mutex> lock{ mutex };
+        if (auto it = lookup.find(resource.get()); it != lookup.end())
+        {
+            return it->second;
+        }
+
+        uint32_t index = Allocate();
+        Slot &slot = At(index);
+        slot.Resource = resource;
+        slot.Count    = 0;
+        slot.Pointer.store(resource.get(), std::memory_order_release);
+
+        Handle<T> handle{ index, slot.Generation.load(std::memory_order_relaxed) };
+        lookup.emplace(resource.get(), handle);
+
+        return handle;
+    }
+
+    /*
+     * @brief The resource, or nullptr once its slot is retired. Nothing counts the pointer,
+     *  so it may only be used in the frame it was resolved in. A Release from any thread
+     *  leaves it alone that long, the retirement waits for BeginFrame.
+     */
+    T *Get(Handle<T> handle) const
+    {
+        uint32_t index = handle.Index();
+        Slot *block = blocks[index / BlockSize].load(std::memory_order_acquire);
+        if (!block)
+        {
+            return nullptr;
+        }
+
+        const Slot &slot = block[index % BlockSize];
+        if (slot.Generation.load(std::memory_order_acquire) != handle.Generation())
+        {
+            return nullptr;
+        }
+        return slot.Pointer.load(std::memory_order_acquire);
+    }
+
+    /*
+     * @brief A strong reference for code that still wants one, e.g. to keep a resource
+     *  past a Release.
+     */
+    std::shared_ptr<T> Share(Handle<T> handle)
+    {
+        std::lock_guard<std::mutex> lock{ mutex };
+        return Live(handle) ? At(handle.Index()).Resource : nullptr;
+    }
+
+    void Retain(Handle<T> handle)
+    {
+        std::lock_guard<std::mutex> lock{ mutex };
+        if (Live(handle))
+        {
+            Slot &slot = At(handle.Index());
+            slot.Count++;
+            slot.Released = 0;
+        }
+    }
+
+    /*
+     * @brief Give up one count. The last one queues the slot to be retired by BeginFrame,
+     *  until then the handle still resolves and a Retain takes the slot back.
+     */
+    void Release(Handle<T> handle)
+    {
+        std::lock_guard<std::mutex> lock{ mutex };
+        if (!Live(handle))
+        {
+            return;
+        }
+
+        Slot &slot = At(handle.Index());
+        if (slot.Count == 0 || --slot.Count > 0)
+        {
+            return;
+        }
+
+        slot.Released = frame;
+        released.emplace_back(handle);
+    }
+
+    /*
+     * @brief Start a new frame and retire the slots released long enough ago, dropping the
+     *  reference of the table. Every handle to them resolves to nullptr from then on. Meant
+     *  for the render thread, so the resources go on the thread that draws with them.
+     */
+    void BeginFrame()
+    {
+        std::lock_guard<std::mutex> lock{ mutex };
+        frame++;
+
+        size_t pending = 0;
+        for (auto handle : released)
+        {
+            /* Retired through an earlier entry of the same slot, or retained again */
+            if (!Live(handle) || At(handle.Index()).Count > 0)
+            {
+                continue;
+            }
+
+            if (At(handle.Index()).Released + RetireDelay <= frame)
+            {
+                Retire(handle.Index());
+            }
+            else
+            {
+                released[pending++] = handle;
+            }
+        }
+        released.resize(pending);
+    }
+
+    /*
+     * @brief Drop every resource, i.e. before the device they live on goes away.
+     */
+    void Clear()
+    {
+        std::lock_guard<std::mutex> lock{ mutex };
+        for (uint32_t index = 0; index < size; index++)
+        {
+            if (At(index).Resource)
+            {
+                Retire(index);
+            }
+        }
+        lookup.clear();
+        released.clear();
+    }
+
+    size_t Size() const
+    {
+        std::lock_guard<std::mutex> lock{ mutex };
+        return lookup.size();
+    }
+
+    ~ResourceTable()
+    {
+        for (auto &block : blocks)
+        {
+            delete[] block.load(std::memory_order_relaxed);
+        }
+    }
+
+private:
+    Slot &At(uint32_t index) const
+    {
+        return blocks[index / BlockSize].load(std::memory_order_relaxed)[index % BlockSize];
+    }
+
+    bool Live(Handle<T> handle) const
+    {
+        return handle.Index() < size && At(handle.Index()).Generation.load(std::memory_order_relaxed) == handle.Generation();
+    }
+
+    /* Skips 0 on wrap around, which is the generation of the null handle */
+    static uint32_t NextGeneration(uint32_t generation)
+    {
+        generation = (generation + 1) & Handle<T>::GenerationMask;
+        return generation ? generation : 1;
+    }
+
+    void Retire(uint32_t index)
+    {
+        Slot &slot = At(index);
+        lookup.erase(slot.Resource.get());
+        slot.Pointer.store(nullptr, std::memory_order_relaxed);
+        slot.Generation.store(NextGeneration(slot.Generation.load(std::memory_order_relaxed)), std::memory_order_release);
+        slot.Resource.reset();
+        slot.Released = 0;
+        slot.Next = freeList;
+        freeList  = index + 1;
+    }
+
+    uint32_t Allocate()
+    {
+        if (freeList)
+        {
+            uint32_t index = freeList - 1;
+            freeList = At(index).Next;
+            return index;
+        }
+
+        THROWIF(size > Handle<T>::IndexMask, SError::OutOfMemory);
+        auto &block = blocks[size / BlockSize];
+        if (!block.load(std::memory_order_relaxed))
+        {
+            block.store(new Slot[BlockSize], std::memory_order_release);
+        }
+        return size++;
+    }
+
+private:
+    std::atomic<Slot *> blocks[MaxBlocks]{};
+
+    uint32_t size{ 0 };
+
+    /* One past the index of the first free slot, 0 if there is none */
+    uint32_t freeList{ 0 };
+
+    std::unordered_map<const T *, Handle<T>> lookup;
+
+    /* Handles whose last count went, some may have been retained or released again since */
+    std::vector<Handle<T>> released;
+
+    /* Starts past 0, which marks a slot that is not waiting to be retired */
+    uint64_t frame{ 1 };
+
+    mutable std::mutex mutex;
+};
+
+template <class T>
+inline Handle<T>::Handle(const std::shared_ptr<T> &resource) :
+    Handle{ ResourceTable<T>::Instance().Add(resource) }
+{
+
+}
+
+template <class T>
+inline T *Handle<T>::Get() const
+{
+    return ResourceTable<T>::Instance().Get(*this);
+}
+
+template <class T>
+inline std::shared_ptr<T> Handle<T>::Share() const
+{
+    return ResourceTable<T>::Instance().Share(*this);
+}
+
+}
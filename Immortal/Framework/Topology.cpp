@@ -0,0 +1,350 @@
+#include "impch.h"
+#include "Topology.h"
+
+#include <map>
+#include <set>
+
+#ifndef WINDOWS
+#include <fstream>
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace Immortal
+{
+
+const Topology &Topology::Get()
+{
+    static Topology topology;
+    return topology;
+}
+
+Topology::Topology()
+{
+    Detect();
+
+    if (processors.empty())
+    {
+        uint32_t count = std::max(1u, std::thread::hardware_concurrency());
+        for (uint32_t i = 0; i < count; i++)
+        {
+            processors.emplace_back(Processor{ i, i, 0, 0, 0 });
+        }
+    }
+
+    std::set<std::pair<uint32_t, uint32_t>> cores;
+    for (auto &processor : processors)
+    {
+        cores.emplace(processor.Package, processor.Core);
+    }
+    coreCount = cores.size();
+}
+
+#ifdef WINDOWS
+void Topology::Detect()
+{
+    DWORD length = 0;
+    GetLogicalProcessorInformationEx(RelationAll, nullptr, &length);
+    if (GetLastError() != ERROR_INSUFFICIENT_BUFFER)
+    {
+        return;
+    }
+
+    std::vector<uint8_t> buffer(length);
+    if (!GetLogicalProcessorInformationEx(RelationAll, reinterpret_cast<SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX *>(buffer.data()), &length))
+    {
+        return;
+    }
+
+    std::map<uint32_t, Processor> found;
+    std::map<uint32_t, BYTE> cacheLevels;
+
+    auto forEach = [&](const GROUP_AFFINITY &affinity, auto &&func) {
+        for (uint32_t bit = 0; bit < sizeof(KAFFINITY) * 8; bit++)
+        {
+            if (affinity.Mask & (KAFFINITY(1) << bit))
+            {
+                uint32_t index = uint32_t(affinity.Group) * 64 + bit;
+                auto &processor = found[index];
+                processor.Index = index;
+                func(processor);
+            }
+        }
+    };
+
+    uint32_t cores    = 0;
+    uint32_t packages = 0;
+    uint32_t caches   = 0;
+    for (DWORD offset = 0; offset < length; )
+    {
+        auto info = reinterpret_cast<SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX *>(buffer.data() + offset);
+        switch (info->Relationship)
+        {
+        case RelationProcessorCore:
+            for (WORD i = 0; i < info->Processor.GroupCount; i++)
+            {
+                forEach(info->Processor.GroupMask[i], [&](Processor &processor) { processor.Core = cores; });
+            }
+            cores++;
+            break;
+
+        case RelationProcessorPackage:
+            for (WORD i = 0; i < info->Processor.GroupCount; i++)
+            {
+                forEach(info->Processor.GroupMask[i], [&](Processor &processor) { processor.Package = packages; });
+            }
+            packages++;
+            break;
+
+        case RelationCache:
+            /* The cache shared by the most processors is the last level one */
+            forEach(info->Cache.GroupMask, [&](Processor &processor) {
+                if (info->Cache.Level >= cacheLevels[processor.Index])
+                {
+                    cacheLevels[processor.Index] = info->Cache.Level;
+                    processor.Cache = caches;
+                }
+            });
+            caches++;
+            break;
+
+        case RelationNumaNode:
+            forEach(info->NumaNode.GroupMask, [&](Processor &processor) { processor.Node = info->NumaNode.NodeNumber; });
+            break;
+
+        default:
+            break;
+        }
+        offset += info->Size;
+    }
+
+    for (auto &[index, processor] : found)
+    {
+        processors.emplace_back(processor);
+    }
+}
+
+bool Topology::Pin(std::thread &thread, const Processor &processor)
+{
+    GROUP_AFFINITY affinity{};
+    affinity.Group = WORD(processor.Index / 64);
+    affinity.Mask  = KAFFINITY(1) << (processor.Index % 64);
+    return SetThreadGroupAffinity(thread.native_handle(), &affinity, nullptr);
+}
+
+bool Topology::PinCurrentThread(const Processor &processor)
+{
+    GROUP_AFFINITY affinity{};
+    affinity.Group = WORD(processor.Index / 64);
+    affinity.Mask  = KAFFINITY(1) << (processor.Index % 64);
+    return SetThreadGroupAffinity(GetCurrentThread(), &affinity, nullptr);
+}
+#else
+static bool Read(const std::string &path, std::string &value)
+{
+    std::ifstream file{ path };
+    return !!std::getline(file, value);
+}
+
+static bool Read(const std::string &path, uint32_t &value)
+{
+    std::string text;
+    if (!Read(path, text))
+    {
+        return false;
+    }
+    value = uint32_t(std::stoul(text));
+    return true;
+}
+
+/*
+ * @brief Parse the cpu list format of the kernel, e.g. 0-3,8-11
+ */
+static std::vector<uint32_t> ReadList(const std::string &path)
+{
+    std::vector<uint32_t> list;
+    std::string text;
+    if (!Read(path, text))
+    {
+        return list;
+    }
+
+    size_t position = 0;
+    while (position < text.size())
+    {
+        size_t end = text.find(',', position);
+        if (end == std::string::npos)
+        {
+            end = text.size();
+        }
+        auto range = text.substr(position, end - position);
+        auto dash = range.find('-');
+        uint32_t first = uint32_t(std::stoul(range.substr(0, dash)));
+        uint32_t last  = dash == std::string::npos ? first : uint32_t(std::stoul(range.substr(dash + 1)));
+        for (uint32_t i = first; i <= last; i++)
+        {
+            list.emplace_back(i);
+        }
+        position = end + 1;
+    }
+    return list;
+}
+
+void Topology::Detect()
+{
+    static const std::string root = "/sys/devices/system/cpu/";
+
+    std::map<uint32_t, uint32_t> nodes;
+    for (uint32_t node = 0; ; node++)
+    {
+        auto list = ReadList("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+        if (list.empty())
+        {
+            break;
+        }
+        for (auto index : list)
+        {
+            nodes[index] = node;
+        }
+    }
+
+    std::map<std::pair<uint32_t, uint32_t>, uint32_t> cores;
+    for (auto index : ReadList(root + "online"))
+    {
+        auto path = root + "cpu" + std::to_string(index) + "/";
+
+        Processor processor{ index, 0, index, 0, 0 };
+        uint32_t core = index;
+        Read(path + "topology/core_id", core);
+        Read(path + "topology/physical_package_id", processor.Package);
+
+        /* Number the cores across the packages since core_id is only unique per package */
+        processor.Core = cores.emplace(std::make_pair(processor.Package, core), uint32_t(cores.size())).first->second;
+
+        /* The cache is named after the first processor sharing the last level */
+        uint32_t highest = 0;
+        for (uint32_t i = 0; ; i++)
+        {
+            auto cache = path + "cache/index" + std::to_string(i) + "/";
+            uint32_t level = 0;
+            if (!Read(cache + "level", level))
+            {
+                break;
+            }
+            auto shared = ReadList(cache + "shared_cpu_list");
+            if (level >= highest && !shared.empty())
+            {
+                highest = level;
+                processor.Cache = shared.front();
+            }
+        }
+
+        auto node = nodes.find(index);
+        processor.Node = node != nodes.end() ? node->second : 0;
+
+        processors.emplace_back(processor);
+    }
+}
+
+bool Topology::Pin(std::thread &thread, const Processor &processor)
+{
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(processor.Index, &set);
+    return pthread_setaffinity_np(thread.native_handle(), sizeof(set), &set) == 0;
+}
+
+bool Topology::PinCurrentThread(const Processor &processor)
+{
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(processor.Index, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+}
+#endif
+
+std::vector<Topology::Processor> Topology::Candidates(const Placement &placement) const
+{
+    std::vector<Processor> selected;
+    for (auto &processor : processors)
+    {
+        if (placement.Node == Placement::Any || processor.Node == uint32_t(placement.Node))
+        {
+            selected.emplace_back(processor);
+        }
+    }
+    if (selected.empty())
+    {
+        selected = processors;
+    }
+
+    std::sort(selected.begin(), selected.end(), [](const Processor &a, const Processor &b) -> bool {
+        return std::tie(a.Node, a.Package, a.Cache, a.Core, a.Index) < std::tie(b.Node, b.Package, b.Cache, b.Core, b.Index);
+    });
+
+    return selected;
+}
+
+std::vector<Topology::Processor> Topology::Select(const Placement &placement) const
+{
+    std::vector<Processor> result;
+    if (placement.Policy == Placement::Type::Default)
+    {
+        return result;
+    }
+
+    auto selected = Candidates(placement);
+
+    std::set<uint32_t> reserved;
+    std::set<uint32_t> taken;
+    for (auto &processor : selected)
+    {
+        if (reserved.count(processor.Core) == 0 && reserved.size() < placement.ReservedCores)
+        {
+            reserved.emplace(processor.Core);
+        }
+        if (reserved.count(processor.Core))
+        {
+            continue;
+        }
+        if (placement.Policy == Placement::Type::PhysicalCores && !taken.emplace(processor.Core).second)
+        {
+            continue;
+        }
+        result.emplace_back(processor);
+    }
+
+    /* Never reserve the whole machine away */
+    if (result.empty())
+    {
+        result.emplace_back(selected.back());
+    }
+
+    return result;
+}
+
+std::vector<Topology::Processor> Topology::Reserved(const Placement &placement) const
+{
+    std::vector<Processor> result;
+    if (placement.Policy == Placement::Type::Default)
+    {
+        return result;
+    }
+
+    std::set<uint32_t> reserved;
+    for (auto &processor : Candidates(placement))
+    {
+        if (reserved.size() >= placement.ReservedCores)
+        {
+            break;
+        }
+        if (reserved.emplace(processor.Core).second)
+        {
+            result.emplace_back(processor);
+        }
+    }
+
+    return result;
+}
+
+}
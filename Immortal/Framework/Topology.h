@@ -0,0 +1,133 @@
+#pragma once
+
+#include "Core.h"
+
+#include <thread>
+#include <vector>
+
+namespace Immortal
+{
+
+/*
+ * @brief Where the workers of a pool should go.
+ *  Default leaves the threads to the scheduler of the OS. PhysicalCores puts one worker
+ *  on each physical core, LogicalProcessors one on every hardware thread. ReservedCores
+ *  keeps the first cores free for the main and render threads, and Node keeps every
+ *  worker on one NUMA node.
+ */
+struct Placement
+{
+    enum class Type
+    {
+        Default,
+        PhysicalCores,
+        LogicalProcessors
+    };
+
+    Placement(Type policy = Type::Default, uint32_t reservedCores = 0, int node = Any) :
+        Policy{ policy },
+        ReservedCores{ reservedCores },
+        Node{ node }
+    {
+
+    }
+
+    static constexpr int Any = -1;
+
+    Type     Policy;
+    uint32_t ReservedCores;
+    int      Node;
+};
+
+/*
+ * @brief The layout of the processors of the machine, read once from
+ *  GetLogicalProcessorInformationEx on Windows and /sys/devices/system/cpu on Linux.
+ *  Falls back to a flat layout with one core per hardware thread if neither is there.
+ */
+class Topology
+{
+public:
+    struct Processor
+    {
+        uint32_t Index;
+        uint32_t Core;
+        uint32_t Cache;
+        uint32_t Package;
+        uint32_t Node;
+    };
+
+    /*
+     * @brief How far apart two processors are, the lower the more caches they share.
+     */
+    enum Distance
+    {
+        SameCore    = 0,
+        SameCache   = 1,
+        SameNode    = 2,
+        Remote      = 3
+    };
+
+public:
+    static const Topology &Get();
+
+    const std::vector<Processor> &Processors() const
+    {
+        return processors;
+    }
+
+    size_t CoreCount() const
+    {
+        return coreCount;
+    }
+
+    /*
+     * @brief The processors to run workers on under the placement, one per worker and
+     *  sorted so that neighbours share their caches. Empty for the Default policy.
+     */
+    std::vector<Processor> Select(const Placement &placement) const;
+
+    /*
+     * @brief The first processor of each core the placement keeps away from the workers,
+     *  for the threads the caller pins there, i.e. the main thread.
+     */
+    std::vector<Processor> Reserved(const Placement &placement) const;
+
+    static Distance Measure(const Processor &a, const Processor &b)
+    {
+        if (a.Core == b.Core && a.Package == b.Package)
+        {
+            return SameCore;
+        }
+        if (a.Cache == b.Cache)
+        {
+            return SameCache;
+        }
+        if (a.Node == b.Node)
+        {
+            return SameNode;
+        }
+        return Remote;
+    }
+
+    static bool Pin(std::thread &thread, const Processor &processor);
+
+    static bool PinCurrentThread(const Processor &processor);
+
+private:
+    Topology();
+
+    void Detect();
+
+    /*
+     * @brief The processors the placement may use, sorted so that neighbours share their
+     *  caches. The reserved cores are the first ones.
+     */
+    std::vector<Processor> Candidates(const Placement &placement) const;
+
+private:
+    std::vector<Processor> processors;
+
+    size_t coreCount{ 0 };
+};
+
+}
@@ -0,0 +1,504 @@
+#include "impch.h"
+#include "VectorBatch.h"
+
+#include <cmath>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#define SL_SIMD_SSE
+#include <emmintrin.h>
+#endif
+
+/* MSVC takes AVX intrinsics anywhere, GCC and Clang only in functions built for AVX2. The
+ * kernels are flattened so that the width generic templates end up inlined into them */
+#if defined(SL_SIMD_SSE) && defined(_MSC_VER)
+#define SL_SIMD_AVX2
+#define SL_TARGET_AVX2
+#define SL_KERNEL_AVX2
+#include <immintrin.h>
+#elif defined(SL_SIMD_SSE) && defined(__GNUC__)
+#define SL_SIMD_AVX2
+#define SL_TARGET_AVX2 __attribute__((target("avx2")))
+#define SL_KERNEL_AVX2 __attribute__((target("avx2"), flatten))
+#include <immintrin.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace Immortal
+{
+namespace Vector
+{
+
+/* pi / 2 split in three, the first two short enough that multiplying them by the quadrant is exact */
+static constexpr float PiOver2A  = 1.5703125f;
+static constexpr float PiOver2B  = 4.837512969970703125e-4f;
+static constexpr float PiOver2C  = 7.54978995489188216e-8f;
+static constexpr float TwoOverPi = 0.636619772367581343f;
+
+/* Minimax polynomials of sin and cos over [-pi / 4, pi / 4], from Cephes */
+static constexpr float Sin0 = -1.6666654611e-1f;
+static constexpr float Sin1 =  8.3321608736e-3f;
+static constexpr float Sin2 = -1.9515295891e-4f;
+static constexpr float Cos0 =  4.166664568298827e-2f;
+static constexpr float Cos1 = -1.388731625493765e-3f;
+static constexpr float Cos2 =  2.443315711809948e-5f;
+
+struct Float1
+{
+    static constexpr size_t Width = 1;
+
+    using Int = int32_t;
+
+    Float1(float value) :
+        v{ value }
+    {
+
+    }
+
+    static Float1 Load(const float *source)
+    {
+        return *source;
+    }
+
+    /* Round half to even, the same as cvtps2dq does in the default rounding mode */
+    static Float1 Round(Float1 x, Int &q)
+    {
+        q = static_cast<Int>(std::nearbyint(x.v));
+        return static_cast<float>(q);
+    }
+
+    static void Quadrant(Int q, Float1 &s, Float1 &c)
+    {
+        float sine   = (q & 1) ? c.v : s.v;
+        float cosine = (q & 1) ? s.v : c.v;
+        s = (q & 2) ? -sine : sine;
+        c = ((q + 1) & 2) ? -cosine : cosine;
+    }
+
+    static Float1 Min(Float1 a, Float1 b)
+    {
+        return a.v < b.v ? a.v : b.v;
+    }
+
+    /* Not less than rather than greater equal, a box gone NaN is rather drawn than lost */
+    static void StoreVisible(uint8_t *visible, Float1 distance)
+    {
+        *visible = !(distance.v < 0.0f);
+    }
+
+    static void Store(Matrix4 *output, const Float1 (&e)[16])
+    {
+        float *destination = &(*output)[0][0];
+        for (int i = 0; i < 16; i++)
+        {
+            destination[i] = e[i].v;
+        }
+    }
+
+    float v;
+};
+
+static inline Float1 operator+(Float1 a, Float1 b) { return a.v + b.v; }
+static inline Float1 operator-(Float1 a, Float1 b) { return a.v - b.v; }
+static inline Float1 operator*(Float1 a, Float1 b) { return a.v * b.v; }
+
+#ifdef SL_SIMD_SSE
+struct Float4
+{
+    static constexpr size_t Width = 4;
+
+    using Int = __m128i;
+
+    Float4(__m128 value) :
+        v{ value }
+    {
+
+    }
+
+    Float4(float value) :
+        v{ _mm_set1_ps(value) }
+    {
+
+    }
+
+    static Float4 Load(const float *source)
+    {
+        return _mm_loadu_ps(source);
+    }
+
+    static Float4 Round(Float4 x, Int &q)
+    {
+        q = _mm_cvtps_epi32(x.v);
+        return _mm_cvtepi32_ps(q);
+    }
+
+    static void Quadrant(Int q, Float4 &s, Float4 &c)
+    {
+        __m128 swap       = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(q, _mm_set1_epi32(1)), _mm_set1_epi32(1)));
+        __m128 sineSign   = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(q, _mm_set1_epi32(2)), 30));
+        __m128 cosineSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(_mm_add_epi32(q, _mm_set1_epi32(1)), _mm_set1_epi32(2)), 30));
+
+        __m128 sine   = _mm_or_ps(_mm_and_ps(swap, c.v), _mm_andnot_ps(swap, s.v));
+        __m128 cosine = _mm_or_ps(_mm_and_ps(swap, s.v), _mm_andnot_ps(swap, c.v));
+        s = _mm_xor_ps(sine, sineSign);
+        c = _mm_xor_ps(cosine, cosineSign);
+    }
+
+    static Float4 Min(Float4 a, Float4 b)
+    {
+        return _mm_min_ps(a.v, b.v);
+    }
+
+    static void StoreVisible(uint8_t *visible, Float4 distance)
+    {
+        int mask = _mm_movemask_ps(_mm_cmpnlt_ps(distance.v, _mm_setzero_ps()));
+        for (int k = 0; k < 4; k++)
+        {
+            visible[k] = (mask >> k) & 1;
+        }
+    }
+
+    /* e holds one element of four matrices each, a transpose per column turns them back into matrices */
+    static void Store(Matrix4 *output, const Float4 (&e)[16])
+    {
+        for (int column = 0; column < 4; column++)
+        {
+            __m128 r0 = e[column * 4 + 0].v;
+            __m128 r1 = e[column * 4 + 1].v;
+            __m128 r2 = e[column * 4 + 2].v;
+            __m128 r3 = e[column * 4 + 3].v;
+            _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+            _mm_storeu_ps(&output[0][column][0], r0);
+            _mm_storeu_ps(&output[1][column][0], r1);
+            _mm_storeu_ps(&output[2][column][0], r2);
+            _mm_storeu_ps(&output[3][column][0], r3);
+        }
+    }
+
+    __m128 v;
+};
+
+static inline Float4 operator+(Float4 a, Float4 b) { return _mm_add_ps(a.v, b.v); }
+static inline Float4 operator-(Float4 a, Float4 b) { return _mm_sub_ps(a.v, b.v); }
+static inline Float4 operator*(Float4 a, Float4 b) { return _mm_mul_ps(a.v, b.v); }
+#endif
+
+#ifdef SL_SIMD_AVX2
+/*
+ * @brief The lanes are kept as plain floats rather than a __m256. The templates are not
+ *  built for AVX2, so whatever of them is not inlined passes it in memory, the same way
+ *  the AVX2 functions they call do.
+ */
+struct Float8
+{
+    static constexpr size_t Width = 8;
+
+    using Int = __m256i;
+
+    SL_TARGET_AVX2 Float8(__m256 value)
+    {
+        _mm256_storeu_ps(v, value);
+    }
+
+    SL_TARGET_AVX2 Float8(float value)
+    {
+        _mm256_storeu_ps(v, _mm256_set1_ps(value));
+    }
+
+    SL_TARGET_AVX2 __m256 Get() const
+    {
+        return _mm256_loadu_ps(v);
+    }
+
+    SL_TARGET_AVX2 static Float8 Load(const float *source)
+    {
+        return _mm256_loadu_ps(source);
+    }
+
+    SL_TARGET_AVX2 static Float8 Round(Float8 x, Int &q)
+    {
+        q = _mm256_cvtps_epi32(x.Get());
+        return _mm256_cvtepi32_ps(q);
+    }
+
+    SL_TARGET_AVX2 static void Quadrant(const Int &q, Float8 &s, Float8 &c)
+    {
+        __m256 swap       = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(q, _mm256_set1_epi32(1)), _mm256_set1_epi32(1)));
+        __m256 sineSign   = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(q, _mm256_set1_epi32(2)), 30));
+        __m256 cosineSign = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(_mm256_add_epi32(q, _mm256_set1_epi32(1)), _mm256_set1_epi32(2)), 30));
+
+        __m256 sine   = _mm256_blendv_ps(s.Get(), c.Get(), swap);
+        __m256 cosine = _mm256_blendv_ps(c.Get(), s.Get(), swap);
+        s = _mm256_xor_ps(sine, sineSign);
+        c = _mm256_xor_ps(cosine, cosineSign);
+    }
+
+    SL_TARGET_AVX2 static Float8 Min(Float8 a, Float8 b)
+    {
+        return _mm256_min_ps(a.Get(), b.Get());
+    }
+
+    SL_TARGET_AVX2 static void StoreVisible(uint8_t *visible, Float8 distance)
+    {
+        int mask = _mm256_movemask_ps(_mm256_cmp_ps(distance.Get(), _mm256_setzero_ps(), _CMP_NLT_UQ));
+        for (int k = 0; k < 8; k++)
+        {
+            visible[k] = (mask >> k) & 1;
+        }
+    }
+
+    /* The shuffles only work within 128 bit halves, so every half ends up with a column of a different matrix */
+    SL_TARGET_AVX2 static void Store(Matrix4 *output, const Float8 (&e)[16])
+    {
+        for (int column = 0; column < 4; column++)
+        {
+            __m256 t0 = _mm256_unpacklo_ps(e[column * 4 + 0].Get(), e[column * 4 + 1].Get());
+            __m256 t1 = _mm256_unpackhi_ps(e[column * 4 + 0].Get(), e[column * 4 + 1].Get());
+            __m256 t2 = _mm256_unpacklo_ps(e[column * 4 + 2].Get(), e[column * 4 + 3].Get());
+            __m256 t3 = _mm256_unpackhi_ps(e[column * 4 + 2].Get(), e[column * 4 + 3].Get());
+
+            __m256 c0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+            __m256 c1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+            __m256 c2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+            __m256 c3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+
+            _mm_storeu_ps(&output[0][column][0], _mm256_castps256_ps128(c0));
+            _mm_storeu_ps(&output[1][column][0], _mm256_castps256_ps128(c1));
+            _mm_storeu_ps(&output[2][column][0], _mm256_castps256_ps128(c2));
+            _mm_storeu_ps(&output[3][column][0], _mm256_castps256_ps128(c3));
+            _mm_storeu_ps(&output[4][column][0], _mm256_extractf128_ps(c0, 1));
+            _mm_storeu_ps(&output[5][column][0], _mm256_extractf128_ps(c1, 1));
+            _mm_storeu_ps(&output[6][column][0], _mm256_extractf128_ps(c2, 1));
+            _mm_storeu_ps(&output[7][column][0], _mm256_extractf128_ps(c3, 1));
+        }
+    }
+
+    float v[Width];
+};
+
+SL_TARGET_AVX2 static inline Float8 operator+(Float8 a, Float8 b) { return _mm256_add_ps(a.Get(), b.Get()); }
+SL_TARGET_AVX2 static inline Float8 operator-(Float8 a, Float8 b) { return _mm256_sub_ps(a.Get(), b.Get()); }
+SL_TARGET_AVX2 static inline Float8 operator*(Float8 a, Float8 b) { return _mm256_mul_ps(a.Get(), b.Get()); }
+
+static bool SupportsAVX2()
+{
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7)
+    {
+        return false;
+    }
+
+    /* The OS has to save the upper halves of the registers as well */
+    __cpuid(info, 1);
+    bool osxsave = info[2] & (1 << 27);
+    bool avx     = info[2] & (1 << 28);
+    if (!osxsave || !avx || (_xgetbv(0) & 6) != 6)
+    {
+        return false;
+    }
+
+    __cpuidex(info, 7, 0);
+    return info[1] & (1 << 5);
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+#endif
+
+/*
+ * @brief No fused multiply add on purpose, so that every width rounds the same way.
+ */
+template <class V>
+static inline void SinCos(V x, V &s, V &c)
+{
+    typename V::Int q;
+    V k = V::Round(x * V{ TwoOverPi }, q);
+    V r = ((x - k * V{ PiOver2A }) - k * V{ PiOver2B }) - k * V{ PiOver2C };
+    V r2 = r * r;
+
+    s = r + r * r2 * (V{ Sin0 } + r2 * (V{ Sin1 } + r2 * V{ Sin2 }));
+    c = (V{ 1.0f } - r2 * V{ 0.5f }) + r2 * r2 * (V{ Cos0 } + r2 * (V{ Cos1 } + r2 * V{ Cos2 }));
+
+    V::Quadrant(q, s, c);
+}
+
+/*
+ * @brief The same steps as Translate(position) * toMat4(Quaternion(rotation)) * Scale(scale)
+ *  of glm, minus the products with zero the matrix multiplications go through.
+ */
+template <class V>
+static inline void Compose(const TransformStreams &streams, size_t i, Matrix4 *output)
+{
+    V half{ 0.5f };
+    V sx{ 0.0f }, cx{ 0.0f }, sy{ 0.0f }, cy{ 0.0f }, sz{ 0.0f }, cz{ 0.0f };
+    SinCos(V::Load(streams.Rotation[0] + i) * half, sx, cx);
+    SinCos(V::Load(streams.Rotation[1] + i) * half, sy, cy);
+    SinCos(V::Load(streams.Rotation[2] + i) * half, sz, cz);
+
+    V w = cx * cy * cz + sx * sy * sz;
+    V x = sx * cy * cz - cx * sy * sz;
+    V y = cx * sy * cz + sx * cy * sz;
+    V z = cx * cy * sz - sx * sy * cz;
+
+    V xx = x * x;
+    V yy = y * y;
+    V zz = z * z;
+    V xz = x * z;
+    V xy = x * y;
+    V yz = y * z;
+    V wx = w * x;
+    V wy = w * y;
+    V wz = w * z;
+
+    V one{ 1.0f };
+    V two{ 2.0f };
+    V zero{ 0.0f };
+    V scaleX = V::Load(streams.Scale[0] + i);
+    V scaleY = V::Load(streams.Scale[1] + i);
+    V scaleZ = V::Load(streams.Scale[2] + i);
+
+    const V e[16] = {
+        (one - two * (yy + zz)) * scaleX,
+        two * (xy + wz) * scaleX,
+        two * (xz - wy) * scaleX,
+        zero,
+
+        two * (xy - wz) * scaleY,
+        (one - two * (xx + zz)) * scaleY,
+        two * (yz + wx) * scaleY,
+        zero,
+
+        two * (xz + wy) * scaleZ,
+        two * (yz - wx) * scaleZ,
+        (one - two * (xx + yy)) * scaleZ,
+        zero,
+
+        V::Load(streams.Position[0] + i),
+        V::Load(streams.Position[1] + i),
+        V::Load(streams.Position[2] + i),
+        one
+    };
+    V::Store(output + i, e);
+}
+
+/*
+ * @brief The box is behind a plane when even its corner furthest along the normal is,
+ *  that corner is the center plus the extent times the signs of the normal.
+ */
+template <class V>
+static inline void Cull(const Vector4 (&planes)[6], const BoundsStreams &bounds, size_t i, uint8_t *visible)
+{
+    V centerX = V::Load(bounds.Center[0] + i);
+    V centerY = V::Load(bounds.Center[1] + i);
+    V centerZ = V::Load(bounds.Center[2] + i);
+    V extentX = V::Load(bounds.Extent[0] + i);
+    V extentY = V::Load(bounds.Extent[1] + i);
+    V extentZ = V::Load(bounds.Extent[2] + i);
+
+    V distance{ 0.0f };
+    for (int p = 0; p < 6; p++)
+    {
+        const Vector4 &plane = planes[p];
+        V d = (centerX * V{ plane.x } + centerY * V{ plane.y } + centerZ * V{ plane.z } + V{ plane.w }) +
+            (extentX * V{ std::fabs(plane.x) } + extentY * V{ std::fabs(plane.y) } + extentZ * V{ std::fabs(plane.z) });
+        distance = p == 0 ? d : V::Min(distance, d);
+    }
+    V::StoreVisible(visible + i, distance);
+}
+
+#ifdef SL_SIMD_AVX2
+/*
+ * @brief The whole batches of eight, returns how far they got.
+ */
+SL_KERNEL_AVX2 static size_t ComposeTransformsAVX2(const TransformStreams &streams, size_t count, Matrix4 *output)
+{
+    size_t i = 0;
+    for (; i + Float8::Width <= count; i += Float8::Width)
+    {
+        Compose<Float8>(streams, i, output);
+    }
+    _mm256_zeroupper();
+    return i;
+}
+
+SL_KERNEL_AVX2 static size_t CullBoundsAVX2(const Vector4 (&planes)[6], const BoundsStreams &bounds, size_t count, uint8_t *visible)
+{
+    size_t i = 0;
+    for (; i + Float8::Width <= count; i += Float8::Width)
+    {
+        Cull<Float8>(planes, bounds, i, visible);
+    }
+    _mm256_zeroupper();
+    return i;
+}
+#endif
+
+void ComposeTransforms(const TransformStreams &streams, size_t count, Matrix4 *output)
+{
+    size_t i = 0;
+
+#ifdef SL_SIMD_AVX2
+    static const bool avx2 = SupportsAVX2();
+    if (avx2)
+    {
+        i = ComposeTransformsAVX2(streams, count, output);
+    }
+#endif
+
+#ifdef SL_SIMD_SSE
+    for (; i + Float4::Width <= count; i += Float4::Width)
+    {
+        Compose<Float4>(streams, i, output);
+    }
+#endif
+
+    for (; i < count; i++)
+    {
+        Compose<Float1>(streams, i, output);
+    }
+}
+
+Matrix4 ComposeTransform(const Vector3 &position, const Vector3 &rotation, const Vector3 &scale)
+{
+    TransformStreams streams = {
+        { &position.x, &position.y, &position.z },
+        { &rotation.x, &rotation.y, &rotation.z },
+        { &scale.x,    &scale.y,    &scale.z    }
+    };
+
+    Matrix4 transform;
+    Compose<Float1>(streams, 0, &transform);
+    return transform;
+}
+
+void CullBounds(const Vector4 (&planes)[6], const BoundsStreams &bounds, size_t count, uint8_t *visible)
+{
+    size_t i = 0;
+
+#ifdef SL_SIMD_AVX2
+    static const bool avx2 = SupportsAVX2();
+    if (avx2)
+    {
+        i = CullBoundsAVX2(planes, bounds, count, visible);
+    }
+#endif
+
+#ifdef SL_SIMD_SSE
+    for (; i + Float4::Width <= count; i += Float4::Width)
+    {
+        Cull<Float4>(planes, bounds, i, visible);
+    }
+#endif
+
+    for (; i < count; i++)
+    {
+        Cull<Float1>(planes, bounds, i, visible);
+    }
+}
+
+}
+}
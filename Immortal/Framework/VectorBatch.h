@@ -0,0 +1,53 @@
+#pragma once
+
+#include "Core.h"
+
+namespace Immortal
+{
+namespace Vector
+{
+
+/*
+ * @brief The position, rotation and scale of many transforms laid out as one stream of
+ *  floats per component, which is how the batch kernel loads them, several at a time.
+ */
+struct TransformStreams
+{
+    const float *Position[3];
+    const float *Rotation[3];
+    const float *Scale[3];
+};
+
+/*
+ * @brief Build Translate(position) * Rotate(rotation) * Scale(scale) for count transforms
+ *  into the contiguous output. Runs 8 transforms at a time with AVX2, 4 with SSE and one
+ *  at a time otherwise. All paths evaluate the same expressions in the same order, so
+ *  they agree bit for bit with each other and with ComposeTransform.
+ *
+ *  Against the glm path the only difference is sin and cos, which are a polynomial here.
+ *  It is within a few ulp of the standard library, so each element of the rotation part
+ *  is off by less than 2e-6 times the scale of its column, and the translation is exact.
+ */
+void ComposeTransforms(const TransformStreams &streams, size_t count, Matrix4 *output);
+
+Matrix4 ComposeTransform(const Vector3 &position, const Vector3 &rotation, const Vector3 &scale);
+
+/*
+ * @brief Axis aligned boxes as streams of their centers and half extents.
+ */
+struct BoundsStreams
+{
+    const float *Center[3];
+    const float *Extent[3];
+};
+
+/*
+ * @brief Test count boxes against six planes a * x + b * y + c * z + d = 0 facing inwards,
+ *  as many at a time as ComposeTransforms does. visible[i] is 0 if box i lies entirely
+ *  behind one of the planes and 1 otherwise, so a box is never dropped by mistake, only
+ *  kept a little longer around the corners of the frustum.
+ */
+void CullBounds(const Vector4 (&planes)[6], const BoundsStreams &bounds, size_t count, uint8_t *visible);
+
+}
+}
@@ -37,8 +37,13 @@
 #include "Platform/Vulkan/RenderContext.h"
 #include "Platform/Vulkan/GuiLayer.h"
 
+#include "Sync/Latch.h"
+#include "Sync/Mutex.h"
+#include "Sync/Queue.h"
+#include "Sync/SeqLock.h"
 #include "Sync/Semaphore.h"
 #include "Sync/SemaphorePool.h"
+#include "Sync/Signal.h"
 
 #include "Editor/EditorCamera.h"
 
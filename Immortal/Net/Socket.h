@@ -200,8 +200,7 @@ public:
     int Receive(std::vector<T> *out)
     {
         int status = 0;
-        std::vector<char> buffer;
-        buffer.resize(65536);
+        auto &buffer = ReceiveBuffer();
 
         while(true)
         {
@@ -224,8 +223,7 @@ public:
     int Receive(Callback callback)
     {
         int status = 0;
-        std::vector<char> buffer;
-        buffer.resize(65536);
+        auto &buffer = ReceiveBuffer();
 
         while (true)
         {
@@ -244,9 +242,26 @@ public:
     }
 
 private:
+    /*
+     * @brief Allocated on the first receive and kept for the lifetime of the socket.
+     */
+    std::vector<char> &ReceiveBuffer()
+    {
+        if (receiveBuffer.empty())
+        {
+            receiveBuffer.resize(ReceiveBufferSize);
+        }
+        return receiveBuffer;
+    }
+
+private:
+    static constexpr size_t ReceiveBufferSize = 65536;
+
     SOCKET    handle;
     WSAData   wsaData;
     AddrInfo  addrInfo;
+
+    std::vector<char> receiveBuffer;
 };
 
 }
@@ -0,0 +1,509 @@
+#include "impch.h"
+#include "DynamicTree.h"
+
+#include <cmath>
+#include <limits>
+#include <queue>
+
+namespace Immortal
+{
+namespace Physics
+{
+
+static inline BoundingBox Union(const BoundingBox &a, const BoundingBox &b)
+{
+    BoundingBox box;
+    for (int i = 0; i < 3; i++)
+    {
+        box.Min[i] = std::min(a.Min[i], b.Min[i]);
+        box.Max[i] = std::max(a.Max[i], b.Max[i]);
+    }
+    return box;
+}
+
+static inline bool Contains(const BoundingBox &outer, const BoundingBox &inner)
+{
+    for (int i = 0; i < 3; i++)
+    {
+        if (inner.Min[i] < outer.Min[i] || outer.Max[i] < inner.Max[i])
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static inline float Area(const BoundingBox &box)
+{
+    float x = box.Max[0] - box.Min[0];
+    float y = box.Max[1] - box.Min[1];
+    float z = box.Max[2] - box.Min[2];
+    return 2.0f * (x * y + y * z + z * x);
+}
+
+static inline BoundingBox Fat(const BoundingBox &box)
+{
+    BoundingBox fat;
+    for (int i = 0; i < 3; i++)
+    {
+        float margin = DynamicTree::Margin + (box.Max[i] - box.Min[i]) * 0.5f * DynamicTree::Fatten;
+        fat.Min[i] = box.Min[i] - margin;
+        fat.Max[i] = box.Max[i] + margin;
+    }
+    return fat;
+}
+
+DynamicTree::DynamicTree()
+{
+
+}
+
+int32_t DynamicTree::Allocate()
+{
+    int32_t index = freeList;
+    if (index == Null)
+    {
+        index = int32_t(nodes.size());
+        nodes.emplace_back();
+    }
+    else
+    {
+        freeList = nodes[index].Parent;
+    }
+
+    Node &node = nodes[index];
+    node.Parent   = Null;
+    node.Left     = Null;
+    node.Right    = Null;
+    node.Height   = 0;
+    node.UserData = 0;
+    return index;
+}
+
+/* A free node links to the next one through its parent */
+void DynamicTree::Free(int32_t index)
+{
+    nodes[index].Parent = freeList;
+    nodes[index].Height = -1;
+    freeList = index;
+}
+
+int32_t DynamicTree::Insert(const BoundingBox &box, uint32_t userData)
+{
+    int32_t proxy = Allocate();
+    Node &node = nodes[proxy];
+    node.Box      = Fat(box);
+    node.Tight    = box;
+    node.UserData = userData;
+
+    InsertLeaf(proxy);
+    count++;
+
+    return proxy;
+}
+
+void DynamicTree::Remove(int32_t proxy)
+{
+    SLASSERT(nodes[proxy].IsLeaf() && "Only leaves are handed out as proxies");
+
+    RemoveLeaf(proxy);
+    Free(proxy);
+    count--;
+}
+
+bool DynamicTree::Move(int32_t proxy, const BoundingBox &box)
+{
+    Node &node = nodes[proxy];
+    node.Tight = box;
+
+    BoundingBox fat = Fat(box);
+    if (Contains(node.Box, box) && Area(node.Box) <= 2.0f * Area(fat))
+    {
+        return false;
+    }
+
+    RemoveLeaf(proxy);
+    nodes[proxy].Box = fat;
+    InsertLeaf(proxy);
+
+    return true;
+}
+
+/*
+ * @brief Go down to the sibling that grows the surface area of the tree the least, the
+ *  cost of a subtree includes what all its ancestors grow by to take the new leaf in.
+ */
+void DynamicTree::InsertLeaf(int32_t leaf)
+{
+    if (root == Null)
+    {
+        root = leaf;
+        nodes[root].Parent = Null;
+        return;
+    }
+
+    BoundingBox box = nodes[leaf].Box;
+    int32_t index = root;
+    while (!nodes[index].IsLeaf())
+    {
+        const Node &node = nodes[index];
+        float area         = Area(node.Box);
+        float combinedArea = Area(Union(node.Box, box));
+
+        /* Cost of a new parent for this node and the leaf, and of pushing the leaf further down */
+        float cost        = 2.0f * combinedArea;
+        float inheritance = 2.0f * (combinedArea - area);
+
+        auto descend = [&](int32_t child) -> float {
+            const Node &c = nodes[child];
+            float grown = Area(Union(box, c.Box));
+            return (c.IsLeaf() ? grown : grown - Area(c.Box)) + inheritance;
+        };
+        float costLeft  = descend(node.Left);
+        float costRight = descend(node.Right);
+
+        if (cost < costLeft && cost < costRight)
+        {
+            break;
+        }
+        index = costLeft < costRight ? node.Left : node.Right;
+    }
+
+    int32_t sibling   = index;
+    int32_t oldParent = nodes[sibling].Parent;
+    int32_t newParent = Allocate();
+
+    Node &parent = nodes[newParent];
+    parent.Parent = oldParent;
+    parent.Box    = Union(box, nodes[sibling].Box);
+    parent.Height = nodes[sibling].Height + 1;
+    parent.Left   = sibling;
+    parent.Right  = leaf;
+
+    if (oldParent != Null)
+    {
+        if (nodes[oldParent].Left == sibling)
+        {
+            nodes[oldParent].Left = newParent;
+        }
+        else
+        {
+            nodes[oldParent].Right = newParent;
+        }
+    }
+    else
+    {
+        root = newParent;
+    }
+    nodes[sibling].Parent = newParent;
+    nodes[leaf].Parent    = newParent;
+
+    Refit(nodes[leaf].Parent);
+}
+
+void DynamicTree::RemoveLeaf(int32_t leaf)
+{
+    if (leaf == root)
+    {
+        root = Null;
+        return;
+    }
+
+    int32_t parent      = nodes[leaf].Parent;
+    int32_t grandParent = nodes[parent].Parent;
+    int32_t sibling     = nodes[parent].Left == leaf ? nodes[parent].Right : nodes[parent].Left;
+
+    if (grandParent != Null)
+    {
+        if (nodes[grandParent].Left == parent)
+        {
+            nodes[grandParent].Left = sibling;
+        }
+        else
+        {
+            nodes[grandParent].Right = sibling;
+        }
+        nodes[sibling].Parent = grandParent;
+        Free(parent);
+
+        Refit(grandParent);
+    }
+    else
+    {
+        root = sibling;
+        nodes[sibling].Parent = Null;
+        Free(parent);
+    }
+}
+
+/*
+ * @brief Walk up from index, rebalancing and refitting the boxes and heights.
+ */
+void DynamicTree::Refit(int32_t index)
+{
+    while (index != Null)
+    {
+        index = Balance(index);
+
+        Node &node = nodes[index];
+        const Node &left  = nodes[node.Left];
+        const Node &right = nodes[node.Right];
+        node.Height = 1 + std::max(left.Height, right.Height);
+        node.Box    = Union(left.Box, right.Box);
+
+        index = node.Parent;
+    }
+}
+
+/*
+ * @brief Rotate the taller child of A up if the heights of its children are more than one
+ *  apart. Returns the node that is in the place of A afterwards.
+ */
+int32_t DynamicTree::Balance(int32_t iA)
+{
+    Node &A = nodes[iA];
+    if (A.IsLeaf() || A.Height < 2)
+    {
+        return iA;
+    }
+
+    int32_t iB = A.Left;
+    int32_t iC = A.Right;
+    Node &B = nodes[iB];
+    Node &C = nodes[iC];
+
+    int32_t balance = C.Height - B.Height;
+
+    auto replace = [&](int32_t parent, int32_t from, int32_t to) {
+        if (parent == Null)
+        {
+            root = to;
+        }
+        else if (nodes[parent].Left == from)
+        {
+            nodes[parent].Left = to;
+        }
+        else
+        {
+            nodes[parent].Right = to;
+        }
+    };
+
+    /* Rotate C up */
+    if (balance > 1)
+    {
+        int32_t iF = C.Left;
+        int32_t iG = C.Right;
+        Node &F = nodes[iF];
+        Node &G = nodes[iG];
+
+        C.Left   = iA;
+        C.Parent = A.Parent;
+        A.Parent = iC;
+        replace(C.Parent, iA, iC);
+
+        if (F.Height > G.Height)
+        {
+            C.Right  = iF;
+            A.Right  = iG;
+            G.Parent = iA;
+            A.Box    = Union(B.Box, G.Box);
+            C.Box    = Union(A.Box, F.Box);
+            A.Height = 1 + std::max(B.Height, G.Height);
+            C.Height = 1 + std::max(A.Height, F.Height);
+        }
+        else
+        {
+            C.Right  = iG;
+            A.Right  = iF;
+            F.Parent = iA;
+            A.Box    = Union(B.Box, F.Box);
+            C.Box    = Union(A.Box, G.Box);
+            A.Height = 1 + std::max(B.Height, F.Height);
+            C.Height = 1 + std::max(A.Height, G.Height);
+        }
+        return iC;
+    }
+
+    /* Rotate B up */
+    if (balance < -1)
+    {
+        int32_t iD = B.Left;
+        int32_t iE = B.Right;
+        Node &D = nodes[iD];
+        Node &E = nodes[iE];
+
+        B.Left   = iA;
+        B.Parent = A.Parent;
+        A.Parent = iB;
+        replace(B.Parent, iA, iB);
+
+        if (D.Height > E.Height)
+        {
+            B.Right  = iD;
+            A.Left   = iE;
+            E.Parent = iA;
+            A.Box    = Union(C.Box, E.Box);
+            B.Box    = Union(A.Box, D.Box);
+            A.Height = 1 + std::max(C.Height, E.Height);
+            B.Height = 1 + std::max(A.Height, D.Height);
+        }
+        else
+        {
+            B.Right  = iE;
+            A.Left   = iD;
+            D.Parent = iA;
+            A.Box    = Union(C.Box, D.Box);
+            B.Box    = Union(A.Box, E.Box);
+            A.Height = 1 + std::max(C.Height, D.Height);
+            B.Height = 1 + std::max(A.Height, E.Height);
+        }
+        return iB;
+    }
+
+    return iA;
+}
+
+/*
+ * @brief Slab test, the distance along the ray where it enters the box and the axis of the
+ *  face it enters through, or -1 if it starts inside.
+ */
+static inline bool IntersectRay(const BoundingBox &box, const Vector3 &origin, const Vector3 &inverse, float maxDistance, float &distance, int &axis)
+{
+    float enter = 0.0f;
+    float exit  = maxDistance;
+    axis = -1;
+    for (int i = 0; i < 3; i++)
+    {
+        float t1 = (box.Min[i] - origin[i]) * inverse[i];
+        float t2 = (box.Max[i] - origin[i]) * inverse[i];
+        if (t1 > t2)
+        {
+            std::swap(t1, t2);
+        }
+        if (t1 > enter)
+        {
+            enter = t1;
+            axis = i;
+        }
+        exit = std::min(exit, t2);
+        if (enter > exit)
+        {
+            return false;
+        }
+    }
+    distance = enter;
+    return true;
+}
+
+bool DynamicTree::Raycast(const Vector3 &origin, const Vector3 &direction, float maxDistance, RaycastHit &hit) const
+{
+    if (root == Null)
+    {
+        return false;
+    }
+
+    Vector3 inverse;
+    for (int i = 0; i < 3; i++)
+    {
+        inverse[i] = 1.0f / direction[i];
+    }
+
+    float best = maxDistance;
+    int32_t closest = Null;
+    int closestAxis = -1;
+
+    Stack stack;
+    stack.Push(root);
+    while (!stack.Empty())
+    {
+        int32_t index = stack.Pop();
+
+        const Node &node = nodes[index];
+        float distance;
+        int axis;
+        if (!IntersectRay(node.Box, origin, inverse, best, distance, axis))
+        {
+            continue;
+        }
+        if (node.IsLeaf())
+        {
+            if (IntersectRay(node.Tight, origin, inverse, best, distance, axis) && (closest == Null || distance < best))
+            {
+                best = distance;
+                closest = index;
+                closestAxis = axis;
+            }
+            continue;
+        }
+        stack.Push(node.Left);
+        stack.Push(node.Right);
+    }
+
+    if (closest == Null)
+    {
+        return false;
+    }
+
+    hit.Distance = best;
+    hit.Point    = origin + direction * best;
+    hit.Normal   = Vector3{ 0.0f, 0.0f, 0.0f };
+    if (closestAxis >= 0)
+    {
+        hit.Normal[closestAxis] = direction[closestAxis] > 0.0f ? -1.0f : 1.0f;
+    }
+    hit.EntityID = int(nodes[closest].UserData);
+
+    return true;
+}
+
+/*
+ * @brief Best first: nodes come off the queue closest first and the search stops as soon
+ *  as the closest one left is further away than the count-th result so far.
+ */
+void DynamicTree::Nearest(const Vector3 &point, size_t k, std::vector<uint32_t> &result) const
+{
+    result.clear();
+    if (root == Null || k == 0)
+    {
+        return;
+    }
+
+    using Entry = std::pair<float, int32_t>;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> queue;
+    std::priority_queue<Entry> found;
+
+    queue.emplace(Distance2(nodes[root].Box, point), root);
+    while (!queue.empty())
+    {
+        auto [distance, index] = queue.top();
+        queue.pop();
+        if (found.size() == k && distance >= found.top().first)
+        {
+            break;
+        }
+
+        const Node &node = nodes[index];
+        if (node.IsLeaf())
+        {
+            found.emplace(Distance2(node.Tight, point), index);
+            if (found.size() > k)
+            {
+                found.pop();
+            }
+            continue;
+        }
+        queue.emplace(Distance2(nodes[node.Left].Box, point), node.Left);
+        queue.emplace(Distance2(nodes[node.Right].Box, point), node.Right);
+    }
+
+    result.resize(found.size());
+    for (size_t i = found.size(); i > 0; i--)
+    {
+        result[i - 1] = nodes[found.top().second].UserData;
+        found.pop();
+    }
+}
+
+}
+}
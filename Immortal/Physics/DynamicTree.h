@@ -0,0 +1,262 @@
+#pragma once
+
+#include "Core.h"
+#include "Physics.h"
+#include "Framework/Frustum.h"
+
+#include <cstring>
+#include <vector>
+
+namespace Immortal
+{
+namespace Physics
+{
+
+/*
+ * @brief A dynamic bounding volume hierarchy over axis aligned boxes, in the spirit of
+ *  the dynamic tree of Box2D. Leaves keep a fattened copy of their box, so an object
+ *  moving a little stays where it is in the tree. Insertion picks the sibling with the
+ *  surface area heuristic and rotations keep the tree balanced on the way back up, so
+ *  every query is logarithmic in the number of leaves.
+ */
+class DynamicTree
+{
+public:
+    static constexpr int32_t Null = -1;
+
+    /* Leaves are grown by this much on every side, plus Fatten times their extent */
+    static constexpr float Margin = 0.1f;
+
+    static constexpr float Fatten = 0.1f;
+
+    struct Node
+    {
+        bool IsLeaf() const
+        {
+            return Left == Null;
+        }
+
+        BoundingBox Box;
+
+        BoundingBox Tight;
+
+        int32_t Parent;
+
+        int32_t Left;
+
+        int32_t Right;
+
+        int32_t Height;
+
+        uint32_t UserData;
+    };
+
+public:
+    DynamicTree();
+
+    int32_t Insert(const BoundingBox &box, uint32_t userData);
+
+    void Remove(int32_t proxy);
+
+    /*
+     * @brief Set the box of the proxy. Only goes back into the tree if the box left its fat
+     *  box, or shrank so much the fat box is no good for it anymore. Returns whether it did.
+     */
+    bool Move(int32_t proxy, const BoundingBox &box);
+
+    uint32_t UserData(int32_t proxy) const
+    {
+        return nodes[proxy].UserData;
+    }
+
+    const BoundingBox &Bounds(int32_t proxy) const
+    {
+        return nodes[proxy].Tight;
+    }
+
+    size_t Size() const
+    {
+        return count;
+    }
+
+    int32_t Height() const
+    {
+        return root == Null ? 0 : nodes[root].Height;
+    }
+
+    /*
+     * @brief Walk every node the test accepts, the fat boxes on the way down and the tight
+     *  box at the leaves. callback(proxy) returns false to stop.
+     */
+    template <class Test, class Callback>
+    void Query(Test &&test, Callback &&callback) const
+    {
+        if (root == Null)
+        {
+            return;
+        }
+
+        Stack stack;
+        stack.Push(root);
+        while (!stack.Empty())
+        {
+            int32_t index = stack.Pop();
+
+            const Node &node = nodes[index];
+
+            if (!test(node.Box))
+            {
+                continue;
+            }
+            if (node.IsLeaf())
+            {
+                if (test(node.Tight) && !callback(index))
+                {
+                    return;
+                }
+                continue;
+            }
+            stack.Push(node.Left);
+            stack.Push(node.Right);
+        }
+    }
+
+    template <class Callback>
+    void Overlap(const BoundingBox &box, Callback &&callback) const
+    {
+        Query([&](const BoundingBox &other) -> bool { return Intersect(box, other); }, callback);
+    }
+
+    template <class Callback>
+    void Overlap(const Vector3 &center, float radius, Callback &&callback) const
+    {
+        Query([&](const BoundingBox &other) -> bool { return Distance2(other, center) <= radius * radius; }, callback);
+    }
+
+    /*
+     * @brief The closest hit of the ray along the normalized direction within maxDistance,
+     *  against the tight boxes. hit.EntityID is set to the user data of the leaf.
+     */
+    bool Raycast(const Vector3 &origin, const Vector3 &direction, float maxDistance, RaycastHit &hit) const;
+
+    /*
+     * @brief The user data of the count leaves closest to point, the closest first.
+     */
+    void Nearest(const Vector3 &point, size_t count, std::vector<uint32_t> &result) const;
+
+    static bool Intersect(const BoundingBox &a, const BoundingBox &b)
+    {
+        for (int i = 0; i < 3; i++)
+        {
+            if (a.Max[i] < b.Min[i] || b.Max[i] < a.Min[i])
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /* The squared distance from the point to the box, 0 inside */
+    static float Distance2(const BoundingBox &box, const Vector3 &point)
+    {
+        float distance = 0.0f;
+        for (int i = 0; i < 3; i++)
+        {
+            float d = std::max(std::max(box.Min[i] - point[i], point[i] - box.Max[i]), 0.0f);
+            distance += d * d;
+        }
+        return distance;
+    }
+
+private:
+    int32_t Allocate();
+
+    void Free(int32_t index);
+
+    void InsertLeaf(int32_t leaf);
+
+    void RemoveLeaf(int32_t leaf);
+
+    int32_t Balance(int32_t index);
+
+    void Refit(int32_t index);
+
+    /*
+     * @brief The nodes left to visit by one query, in place on the stack of the caller as
+     *  long as the tree is not deeper than anything balanced gets, like b2GrowableStack.
+     *  Every query has its own, so a callback could run another one.
+     */
+    class Stack
+    {
+    public:
+        static constexpr size_t FixedSize = 256;
+
+    public:
+        Stack() = default;
+
+        Stack(const Stack &) = delete;
+
+        Stack &operator=(const Stack &) = delete;
+
+        ~Stack()
+        {
+            if (data != fixed)
+            {
+                delete[] data;
+            }
+        }
+
+        void Push(int32_t index)
+        {
+            if (size == capacity)
+            {
+                Grow();
+            }
+            data[size++] = index;
+        }
+
+        int32_t Pop()
+        {
+            return data[--size];
+        }
+
+        bool Empty() const
+        {
+            return size == 0;
+        }
+
+    private:
+        void Grow()
+        {
+            int32_t *grown = new int32_t[capacity * 2];
+            memcpy(grown, data, size * sizeof(int32_t));
+            if (data != fixed)
+            {
+                delete[] data;
+            }
+            data = grown;
+            capacity *= 2;
+        }
+
+    private:
+        int32_t fixed[FixedSize];
+
+        int32_t *data{ fixed };
+
+        size_t size{ 0 };
+
+        size_t capacity{ FixedSize };
+    };
+
+private:
+    std::vector<Node> nodes;
+
+    int32_t root{ Null };
+
+    int32_t freeList{ Null };
+
+    size_t count{ 0 };
+};
+
+}
+}
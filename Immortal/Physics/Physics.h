@@ -12,6 +12,7 @@ namespace Immortal
 			float Distance;
 			Vector3 Point;
 			Vector3 Normal;
+			int EntityID{ -1 };
 		};
 	}
 }
@@ -2,6 +2,7 @@
 
 #include "Common.h"
 #include "CommandPool.h"
+#include "Sync/Mutex.h"
 
 #include <mutex>
 #include <queue>
@@ -32,7 +33,7 @@ public:
 
     ID3D12CommandAllocator *RequestAllocator(uint64_t CompletedFenceValue)
     {
-        std::lock_guard<std::mutex> lock{ mutex };
+        std::lock_guard<Mutex> lock{ mutex };
         ID3D12CommandAllocator *allocator{ nullptr };
 
         if (!readyAllocators.empty())
@@ -63,7 +64,7 @@ public:
 
     void DiscardAllocator(uint64_t fenceValue, ID3D12CommandAllocator *allocator)
     {
-        std::lock_guard<std::mutex> lock{ mutex };
+        std::lock_guard<Mutex> lock{ mutex };
         readyAllocators.push(std::make_pair(fenceValue, allocator));
     }
 
@@ -76,7 +77,7 @@ private:
 
     std::queue<std::pair<uint64_t, ID3D12CommandAllocator*>> readyAllocators;
 
-    std::mutex mutex;
+    Mutex mutex;
 };
 
 }
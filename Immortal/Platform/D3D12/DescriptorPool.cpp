@@ -9,11 +9,11 @@ namespace D3D12
 
 std::vector<std::unique_ptr<DescriptorPool>> DescriptorAllocator::descriptorPools;
 
-std::mutex DescriptorAllocator::mutex;
+Mutex DescriptorAllocator::mutex;
 
 DescriptorPool *DescriptorAllocator::Request(Device *device, DescriptorPool::Type type, DescriptorPool::Flag flag)
 {
-    std::lock_guard<std::mutex> lock{ mutex };
+    std::lock_guard<Mutex> lock{ mutex };
 
     DescriptorPool::Description desc{ type, NumDescriptorPerPool, flag, 1 };
     descriptorPools.emplace_back(new DescriptorPool{ *device, &desc });
@@ -2,6 +2,7 @@
 #include "Common.h"
 
 #include "Descriptor.h"
+#include "Sync/Mutex.h"
 
 namespace Immortal
 {
@@ -210,7 +211,7 @@ private:
 public:
     static std::vector<std::unique_ptr<DescriptorPool>> descriptorPools;
 
-    static std::mutex mutex;
+    static Mutex mutex;
 };
 
 }
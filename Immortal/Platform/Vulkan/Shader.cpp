@@ -66,6 +66,27 @@ bool ReadSpirv(const std::string &path, const std::string &shaderName, const std
     return true;
 }
 
+static constexpr const char *SpirvCachePath = "tmp/";
+
+static bool Compile(const std::string &filename, Shader::Stage stage, std::vector<uint32_t> &spirv)
+{
+    auto src = FileSystem::ReadString(filename);
+    if (ReadSpirv(SpirvCachePath, filename, src, spirv))
+    {
+        return true;
+    }
+
+    std::string error;
+    if (!GLSLCompiler::Src2Spirv(Shader::API::Vulkan, stage, src.size(), src.data(), "main", spirv, error))
+    {
+        LOG::FATAL("Failed to compiler Shader => {0}\n", error.c_str());
+        return false;
+    }
+    CacheSpirv(SpirvCachePath, filename, src, spirv);
+
+    return true;
+}
+
 static inline VkPipelineShaderStageCreateInfo CreateStage(VkShaderModule module, VkShaderStageFlagBits stage)
 {
     VkPipelineShaderStageCreateInfo createInfo{};
@@ -111,25 +132,18 @@ Shader::~Shader()
     device->Destory(descriptorSetLayout);
 }
 
-VkShaderModule Shader::Load(const std::string &filename, Shader::Stage stage)
+bool Shader::Precompile(const std::string &filename, Shader::Stage stage)
 {
-    constexpr const char *tmpPath = "tmp/";
-
-    GLSLCompiler compiler{};
-
-    auto src = FileSystem::ReadString(filename);
-
     std::vector<uint32_t> spirv;
-    std::string error;
+    return Compile(filename, stage, spirv);
+}
 
-    if (!ReadSpirv(tmpPath, filename, src, spirv))
+VkShaderModule Shader::Load(const std::string &filename, Shader::Stage stage)
+{
+    std::vector<uint32_t> spirv;
+    if (!Compile(filename, stage, spirv))
     {
-        if (!GLSLCompiler::Src2Spirv(Shader::API::Vulkan, stage, src.size(), src.data(), "main", spirv, error))
-        {
-            LOG::FATAL("Failed to compiler Shader => {0}\n", error.c_str());
-            return VK_NULL_HANDLE;
-        }
-        CacheSpirv(tmpPath, filename, src, spirv);
+        return VK_NULL_HANDLE;
     }
 
     GLSLCompiler::Reflect(spirv, resources);
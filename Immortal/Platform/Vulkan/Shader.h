@@ -46,6 +46,12 @@ public:
 
     VkShaderModule Load(const std::string &filename, Stage stage);
 
+    /*
+     * @brief Compile a stage to SPIR-V into the cache without a device, so that Load
+     *  only reads it back. Fine to call from any thread.
+     */
+    static bool Precompile(const std::string &filename, Stage stage);
+
     auto &Stages()
     {
         return stages;
@@ -81,16 +81,34 @@ Mesh::Mesh(const std::string & filepath)
         faces.push_back(face);
     }
 
+    CalculateBounds(vertices);
+
     buffer.vertex.reset(Render::Create<Buffer>(vertices, Buffer::Type::Vertex)); 
     buffer.index.reset(Render::Create<Buffer>(faces, Buffer::Type::Index));
 }
 
 Mesh::Mesh(const std::vector<Vertex> &vertices, const std::vector<Index> &indicies)
 {
+    CalculateBounds(vertices);
+
     buffer.vertex.reset(Render::Create<Buffer>(vertices, Buffer::Type::Vertex));
     buffer.index.reset(Render::Create<Buffer>(indicies, Buffer::Type::Index));
 }
 
+void Mesh::CalculateBounds(const std::vector<Vertex> &vertices)
+{
+    if (vertices.empty())
+    {
+        return;
+    }
+
+    bounds = BoundingBox{ vertices[0].Position, vertices[0].Position };
+    for (auto &vertex : vertices)
+    {
+        bounds.Merge(vertex.Position);
+    }
+}
+
 std::shared_ptr<Mesh> Mesh::CreateSphere(float radius)
 {
     std::vector<Vertex> vertices;
@@ -2,6 +2,7 @@
 
 #include "Core.h"
 
+#include "Framework/Frustum.h"
 #include "Buffer.h"
 #include "Shader.h"
 
@@ -120,11 +121,24 @@ public:
         return path;
     }
 
+    /*
+     * @brief The box around the vertices in model space, for culling.
+     */
+    const BoundingBox &Bounds() const
+    {
+        return bounds;
+    }
+
+private:
+    void CalculateBounds(const std::vector<Vertex> &vertices);
+
 private:
     std::unique_ptr<Assimp::Importer> importer{ nullptr };
 
     std::string path;
 
+    BoundingBox bounds;
+
     struct {
         std::shared_ptr<Buffer> vertex;
         std::shared_ptr<Buffer> index;
@@ -2,6 +2,8 @@
 #include "Render.h"
 #include "Render2D.h"
 
+#include "Platform/Vulkan/Shader.h"
+
 namespace Immortal
 {
 
@@ -19,6 +21,36 @@ const Shader::Properties Render::ShaderProperties[] = {
     { "Render2D", U32(Render::Type::Vulkan | Render::Type::OpenGL | Render::Type::D3D12), Shader::Type::Graphics }
 };
 
+std::vector<std::function<void()>> Render::ShaderCompilations()
+{
+    std::vector<std::function<void()>> compilations;
+    if (API != Type::Vulkan)
+    {
+        return compilations;
+    }
+
+    for (int i = 0; i < SL_ARRAY_LENGTH(ShaderProperties); i++)
+    {
+        if (!(ncast<Render::Type>(ShaderProperties[i].API) & API))
+        {
+            continue;
+        }
+
+        auto path = std::string{ AssetsPathes[0] } + ShaderProperties[i].Path;
+        if (ShaderProperties[i].Type == Shader::Type::Graphics)
+        {
+            compilations.emplace_back([=]() -> void { Vulkan::Shader::Precompile(path + ".vert", Shader::Stage::Vertex); });
+            compilations.emplace_back([=]() -> void { Vulkan::Shader::Precompile(path + ".frag", Shader::Stage::Fragment); });
+        }
+        else
+        {
+            compilations.emplace_back([=]() -> void { Vulkan::Shader::Precompile(path + ".comp", Shader::Stage::Compute); });
+        }
+    }
+
+    return compilations;
+}
+
 void Render::Setup(RenderContext *context)
 {
     LOG::INFO("Initialize Renderer with API => {0}", Sringify(Render::API));
@@ -69,20 +101,34 @@ void Render::Setup(RenderContext *context)
         data.WhiteTexture       = std::shared_ptr<Texture>{ Render::Create<Texture>(1, 1, &white, desc)        };
         data.BlackTexture       = std::shared_ptr<Texture>{ Render::Create<Texture>(1, 1, &black, desc)        };
         data.TransparentTexture = std::shared_ptr<Texture>{ Render::Create<Texture>(1, 1, &transparency, desc) };
+
+        data.WhiteTextureHandle = Handle<Texture>{ data.WhiteTexture };
+        ResourceTable<Texture>::Instance().Retain(data.WhiteTextureHandle);
     }
     Render2D::Setup();
 }
 
+void Render::Shutdown()
+{
+    Render2D::Shutdown();
+
+    ResourceTable<Texture>::Instance().Clear();
+    ResourceTable<Mesh>::Instance().Clear();
+
+    data = Data{};
+}
+
 void Render::Setup(const std::shared_ptr<RenderTarget> &renderTarget)
 {
     Render2D::Setup(renderTarget);
 }
 
-void Render::Submit(const std::shared_ptr<Immortal::Shader> &shader, const std::shared_ptr<Mesh> &mesh, const Matrix4 &transform)
+void Render::Submit(const std::shared_ptr<Immortal::Shader> &shader, Handle<Mesh> mesh, const Matrix4 &transform)
 {
     shader->Map();
     shader->Set("uTransform", transform);
     shader->Unmap(); 
+    stats.MeshCount++;
 }
 
 }
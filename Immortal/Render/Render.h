@@ -1,6 +1,8 @@
 #pragma once
 
 #include "Core.h"
+#include "Framework/FrameAllocator.h"
+#include "Framework/ResourceTable.h"
 #include "Camera.h"
 #include "OrthographicCamera.h"
 #include "RenderContext.h"
@@ -21,6 +23,15 @@ public:
         Matrix4 viewProjectionMatrix;
     };
 
+    /*
+     * @brief Counted from one PrepareFrame to the next.
+     */
+    struct Statistics
+    {
+        uint32_t MeshCount = 0;
+        uint32_t CulledMeshCount = 0;
+    };
+
     struct Data
     {
         std::shared_ptr<RenderTarget> Target;
@@ -28,6 +39,9 @@ public:
         std::shared_ptr<Texture>      BlackTexture;
         std::shared_ptr<Texture>      TransparentTexture;
         std::shared_ptr<Texture>      WhiteTexture;
+
+        /* Retained by the render itself, so it outlives the last component using it */
+        Handle<Texture>               WhiteTextureHandle;
     };
 
     enum class Type
@@ -98,10 +112,23 @@ public:
     }
 
 public:
+    /*
+     * @brief The work of Setup that needs no device and could run on any thread ahead of
+     *  it, one task per shader stage. Only Vulkan has any, its GLSL is compiled into the
+     *  SPIR-V cache that Setup then reads back.
+     */
+    static std::vector<std::function<void()>> ShaderCompilations();
+
     static void Setup(RenderContext *context);
 
     static void Setup(const std::shared_ptr<RenderTarget> &renderTarget);
 
+    /*
+     * @brief Drop the presets and every resource of the tables, while the device they
+     *  live on is still there.
+     */
+    static void Shutdown();
+
 
     static const char *Sringify(Render::Type type)
     {
@@ -178,7 +205,7 @@ public:
         return renderer->Index();
     }
 
-    static void Submit(const std::shared_ptr<Shader> &shader, const std::shared_ptr<Mesh> &mesh, const Matrix4 &transform = Matrix4{ 1.0f });
+    static void Submit(const std::shared_ptr<Shader> &shader, Handle<Mesh> mesh, const Matrix4 &transform = Matrix4{ 1.0f });
 
     static void SwapBuffers()
     {
@@ -187,9 +214,26 @@ public:
 
     static void PrepareFrame()
     {
+        FrameAllocator::BeginFrame();
+        ResourceTable<Texture>::Instance().BeginFrame();
+        ResourceTable<Mesh>::Instance().BeginFrame();
+        stats = Statistics{};
         renderer->PrepareFrame();
     }
 
+    static const Statistics &Stats()
+    {
+        return stats;
+    }
+
+    /*
+     * @brief Count the meshes that were culled instead of submitted.
+     */
+    static void Cull(uint32_t count)
+    {
+        stats.CulledMeshCount += count;
+    }
+
     static const char *Api()
     {
         return SAPI;
@@ -296,6 +340,8 @@ private:
 
     static inline Vector2 viewport{ 1, 1 };
 
+    static inline Statistics stats;
+
 public:
     static inline Type API{ Type::None };
 
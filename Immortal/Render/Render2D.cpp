@@ -53,7 +53,7 @@ void Render2D::Setup()
     }
     pipeline->Create(Render::Preset()->Target);
 
-    data.WhiteTexture = Render::Preset()->WhiteTexture;
+    data.WhiteTexture = Render::Preset()->WhiteTextureHandle;
 
     for (uint32_t i = 0; i < data.MaxTextureSlots; i++)
     {
@@ -137,7 +137,7 @@ void Render2D::DrawQuad(const Matrix4 &transform, const Vector4 &color, int enti
     data.Stats.QuadCount++;
 }
 
-void Render2D::DrawQuad(const Matrix4 &transform, const std::shared_ptr<Texture> &texture, float tilingFactor, const Vector4 &tintColor, int entityID)
+void Render2D::DrawQuad(const Matrix4 &transform, Handle<Texture> texture, float tilingFactor, const Vector4 &tintColor, int entityID)
 {
     constexpr size_t quadVertexCount = 4;
     constexpr Vector2 textureCoords[] = {
@@ -156,22 +156,27 @@ void Render2D::DrawQuad(const Matrix4 &transform, const std::shared_ptr<Texture>
     size_t i = 0;
     for (i = 0; i < SL_ARRAY_LENGTH(data.ActiveTextures); i++)
     {
-        if (*data.ActiveTextures[i] == *texture)
+        if (data.ActiveTextures[i] == texture)
         {
             break;
         }
     }
-    if (i == SL_ARRAY_LENGTH(data.ActiveTextures))
+    if (i < SL_ARRAY_LENGTH(data.ActiveTextures))
+    {
+        textureIndex = static_cast<float>(i);
+    }
+    else if (Texture *resource = texture.Get())
     {
         data.ActiveTextures[data.TextureSlotIndex] = texture;
-        texture->As(data.textureDescriptors.get(), data.TextureSlotIndex);
+        resource->As(data.textureDescriptors.get(), data.TextureSlotIndex);
         isTextureChanged = true;
         data.TextureSlotIndex++;
         textureIndex = static_cast<float>(data.TextureSlotIndex);
     }
     else
     {
-        textureIndex = static_cast<float>(i);
+        /* A released texture draws with the white one in slot 0 */
+        textureIndex = 0.0f;
     }
 
     for (size_t i = 0; i < quadVertexCount; i++)
@@ -5,6 +5,7 @@
 #include "OrthographicCamera.h"
 #include "Camera.h"
 #include "Texture.h"
+#include "Framework/ResourceTable.h"
 #include "Scene/Component.h"
 
 namespace Immortal
@@ -41,6 +42,7 @@ public:
     {
         uint32_t DrawCalls = 0;
         uint32_t QuadCount = 0;
+        uint32_t CulledQuadCount = 0;
 
         uint32_t TotalVertexCount() const
         { 
@@ -60,7 +62,7 @@ public:
         static constexpr uint32_t MaxIndices      = MaxQuads * 6;
         static constexpr uint32_t MaxTextureSlots = 32;
 
-        std::shared_ptr<Texture> WhiteTexture;
+        Handle<Texture> WhiteTexture;
         std::shared_ptr<Shader> TextureShader;
         std::unique_ptr<Descriptor> textureDescriptors;
         
@@ -68,7 +70,7 @@ public:
         std::unique_ptr<QuadVertex> QuadVertexBufferBase;
         QuadVertex *QuadVertexBufferPtr = nullptr;
 
-        std::array<std::shared_ptr<Texture>, MaxTextureSlots> ActiveTextures;
+        std::array<Handle<Texture>, MaxTextureSlots> ActiveTextures;
         uint32_t TextureSlotIndex = 1; // 0 = white texture
 
         Vector4 QuadVertexPositions[4];
@@ -106,6 +108,14 @@ public:
         CleanUpObject(&data.Stats);
     }
 
+    /*
+     * @brief Count the quads that were culled instead of drawn.
+     */
+    static void Cull(uint32_t count)
+    {
+        data.Stats.CulledQuadCount += count;
+    }
+
     static void Render2D::BeginScene(const Camera &camera)
     {
         uniform->Update(sizeof(Matrix4), &camera.ViewProjection());
@@ -113,6 +123,12 @@ public:
         StartBatch();
     }
 
+    static void BeginScene(const Matrix4 &viewProjection)
+    {
+        uniform->Update(sizeof(Matrix4), &viewProjection);
+        StartBatch();
+    }
+
     static void Render2D::BeginScene(const Camera &camera, const Matrix4 &view)
     {
         auto viewProjection = camera.Projection() * Vector::Inverse(view);
@@ -134,7 +150,7 @@ public:
 
     static void DrawQuad(const Matrix4 &transform, const Vector4 &color, int entityID = -1);
 
-    static void DrawQuad(const Matrix4 &transform, const std::shared_ptr<Texture> &texture, float tilingFactor = 1.0f, const Vector4 &tintColor = Vector4(1.0f), int entityID = -1);
+    static void DrawQuad(const Matrix4 &transform, Handle<Texture> texture, float tilingFactor = 1.0f, const Vector4 &tintColor = Vector4(1.0f), int entityID = -1);
 
     static void DrawQuad(const Vector2 &position, const Vector2 &size, const Vector4 &color)
     {
@@ -148,12 +164,12 @@ public:
         DrawQuad(transform, color);
     }
 
-    static void DrawQuad(const Vector2 &position, const Vector2 &size, const std::shared_ptr<Texture> &texture, float tilingFactor = 1.0f, const Vector4 &tintColor = Vector4(1.0f))
+    static void DrawQuad(const Vector2 &position, const Vector2 &size, Handle<Texture> texture, float tilingFactor = 1.0f, const Vector4 &tintColor = Vector4(1.0f))
     {
         DrawQuad({ position.x, position.y, 0.0f }, size, texture, tilingFactor, tintColor);
     }
 
-    static void DrawQuad(const Vector3 &position, const Vector2 &size, const std::shared_ptr<Texture> &texture, float tilingFactor = 1.0f, const Vector4 &tintColor = Vector4(1.0f))
+    static void DrawQuad(const Vector3 &position, const Vector2 &size, Handle<Texture> texture, float tilingFactor = 1.0f, const Vector4 &tintColor = Vector4(1.0f))
     {
         Matrix4 transform = Vector::Translate(position) * Vector::Scale({ size.x, size.y, 1.0f });
         DrawQuad(transform, texture, tilingFactor, tintColor);
@@ -172,12 +188,12 @@ public:
         DrawQuad(transform, color);
     }
 
-    static void DrawRotatedQuad(const Vector2 &position, const Vector2 &size, float rotation, const std::shared_ptr<Texture> &texture, float tilingFactor = 1.0f, const Vector4 &tintColor = Vector4{ 1.0f })
+    static void DrawRotatedQuad(const Vector2 &position, const Vector2 &size, float rotation, Handle<Texture> texture, float tilingFactor = 1.0f, const Vector4 &tintColor = Vector4{ 1.0f })
     {
         DrawRotatedQuad({ position.x, position.y, 0.0f }, size, rotation, texture, tilingFactor, tintColor);
     }
 
-    static void DrawRotatedQuad(const Vector3 &position, const Vector2 &size, float rotation, const std::shared_ptr<Texture> &texture, float tilingFactor = 1.0f, const Vector4 &tintColor = Vector4{ 1.0f })
+    static void DrawRotatedQuad(const Vector3 &position, const Vector2 &size, float rotation, Handle<Texture> texture, float tilingFactor = 1.0f, const Vector4 &tintColor = Vector4{ 1.0f })
     {
         Matrix4 transform = Vector::Translate(position) * Vector::Rotate(rotation, { 0.0f, 0.0f, 1.0f }) * Vector::Scale({ size.x, size.y, 1.0f });
         DrawQuad(transform, texture, tilingFactor, tintColor);
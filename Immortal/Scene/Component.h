@@ -1,9 +1,12 @@
 #pragma once
 
 #include "Core.h"
+#include "entt.hpp"
 
 #include "Render/Render.h"
 #include "Render/Mesh.h"
+#include "Framework/VectorBatch.h"
+#include "Framework/ResourceTable.h"
 #include "Render/Texture.h"
 #include "SceneCamera.h"
 
@@ -26,7 +29,8 @@ struct Component
         Script,
         Scene,
         SpriteRenderer,
-        Camera
+        Camera,
+        Relationship
     };
 
     Component(Type type) :
@@ -89,9 +93,60 @@ struct TransformComponent : public Component
         Scale    = scale;
     }
 
-    Matrix4 Transform() const
+    /*
+     * @brief Position, Rotation and Scale are written directly all over the place, so
+     *  the cached matrix remembers what it was built from instead of relying on a flag
+     *  that every writer would have to remember to set.
+     */
+    bool Dirty() const
     {
-        return Vector::Translate(Position) * Vector::Rotate(Rotation) * Vector::Scale(Scale);
+        return Position != cache.Position || Rotation != cache.Rotation || Scale != cache.Scale;
+    }
+
+    /*
+     * @brief Rebuild the cached matrix if the transform has changed since the last time.
+     *  Returns whether anything had to be done.
+     */
+    bool Update() const
+    {
+        if (!Dirty())
+        {
+            return false;
+        }
+        Update(Vector::ComposeTransform(Position, Rotation, Scale));
+        return true;
+    }
+
+    /*
+     * @brief Take a matrix built elsewhere from the current position, rotation and scale,
+     *  e.g. by Vector::ComposeTransforms for many transforms at once.
+     */
+    void Update(const Matrix4 &transform) const
+    {
+        cache.Position  = Position;
+        cache.Rotation  = Rotation;
+        cache.Scale     = Scale;
+        cache.Transform = transform;
+    }
+
+    const Matrix4 &Transform() const
+    {
+        Update();
+        return cache.Transform;
+    }
+
+    /*
+     * @brief The transform in world space, i.e. combined with the transforms of all
+     *  parents. Only valid after Scene::UpdateTransforms.
+     */
+    const Matrix4 &WorldTransform() const
+    {
+        return cache.World;
+    }
+
+    void SetWorldTransform(const Matrix4 &world)
+    {
+        cache.World = world;
     }
 
     operator Matrix4() const
@@ -110,6 +165,41 @@ struct TransformComponent : public Component
     Vector3 Rotation{ 0.0f, 0.0f, 0.0f };
 
     Vector3 Scale{ 1.0f, 1.0f, 1.0f };
+
+private:
+    /* The defaults above build the identity exactly, so a new cache starts out clean */
+    mutable struct
+    {
+        Vector3 Position{ 0.0f, 0.0f, 0.0f };
+        Vector3 Rotation{ 0.0f, 0.0f, 0.0f };
+        Vector3 Scale{ 1.0f, 1.0f, 1.0f };
+        Matrix4 Transform{ 1.0f };
+        Matrix4 World{ 1.0f };
+    } cache;
+};
+
+/*
+ * @brief The place of an object in the hierarchy. Children form a doubly linked list
+ *  hanging off their parent, so attaching and detaching never has to search. Objects
+ *  without one are roots. Only to be changed through Scene::SetParent.
+ */
+struct RelationshipComponent : public Component
+{
+    RelationshipComponent() :
+        Component{ Type::Relationship }
+    {
+
+    }
+
+    entt::entity Parent{ entt::null };
+
+    entt::entity First{ entt::null };
+
+    entt::entity Previous{ entt::null };
+
+    entt::entity Next{ entt::null };
+
+    size_t Children{ 0 };
 };
 
 struct MeshComponent : public Component
@@ -120,16 +210,16 @@ struct MeshComponent : public Component
     
     }
 
-    MeshComponent(std::shared_ptr<Immortal::Mesh> mesh) :
+    MeshComponent(Handle<Immortal::Mesh> mesh) :
         Component{ Type::Mesh },
         Mesh{ mesh }
     {
     
     }
 
-    operator std::shared_ptr<Immortal::Mesh>() { return Mesh; }
+    operator std::shared_ptr<Immortal::Mesh>() { return Mesh.Share(); }
 
-    std::shared_ptr<Immortal::Mesh> Mesh;
+    Handle<Immortal::Mesh> Mesh;
 };
 
 struct MaterialComponent : public Component
@@ -144,16 +234,16 @@ struct MaterialComponent : public Component
         Metalness(1.0f),
         Roughness(1.0f)
     {
-        AlbedoMap    = Render::Preset()->WhiteTexture;
+        AlbedoMap    = Render::Preset()->WhiteTextureHandle;
         NormalMap    = AlbedoMap;
         MetalnessMap = AlbedoMap;
         RoughnessMap = AlbedoMap;
     }
 
-    std::shared_ptr<Immortal::Texture> AlbedoMap;
-    std::shared_ptr<Immortal::Texture> NormalMap;
-    std::shared_ptr<Immortal::Texture> MetalnessMap;
-    std::shared_ptr<Immortal::Texture> RoughnessMap;
+    Handle<Immortal::Texture> AlbedoMap;
+    Handle<Immortal::Texture> NormalMap;
+    Handle<Immortal::Texture> MetalnessMap;
+    Handle<Immortal::Texture> RoughnessMap;
 };
 
 struct LightComponent : public Component
@@ -179,17 +269,17 @@ struct SpriteRendererComponent : public Component
     SpriteRendererComponent() :
         Component{ Type::SpriteRenderer }
     {
-        Texture = Render::Preset()->WhiteTexture;
+
     }
 
-    SpriteRendererComponent(std::shared_ptr<Texture> texture) :
+    SpriteRendererComponent(Handle<Immortal::Texture> texture) :
         Component{ Type::SpriteRenderer },
         Texture{ texture }
     {
 
     }
 
-    SpriteRendererComponent(std::shared_ptr<Texture> texture, const Vector4 color) :
+    SpriteRendererComponent(Handle<Immortal::Texture> texture, const Vector4 color) :
         Component{ Type::SpriteRenderer },
         Texture{ texture },
         Color{ color }
@@ -199,7 +289,7 @@ struct SpriteRendererComponent : public Component
 
     SpriteRendererComponent(const SpriteRendererComponent &other) = default;
 
-    std::shared_ptr<Texture> Texture = Render::Preset()->WhiteTexture;;
+    Handle<Immortal::Texture> Texture = Render::Preset()->WhiteTextureHandle;
 
     Vector4 Color{ 1.0f, 1.0f, 1.0f, 1.0f };
 
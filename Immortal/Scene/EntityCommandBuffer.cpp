@@ -0,0 +1,111 @@
+#include "impch.h"
+#include "EntityCommandBuffer.h"
+
+#include "Scene.h"
+
+namespace Immortal
+{
+
+/* Queues are told apart by id rather than by address, which a new scene could reuse */
+static std::atomic<uint64_t> queues{ 0 };
+
+EntityCommandQueue::EntityCommandQueue() :
+    id{ ++queues }
+{
+
+}
+
+EntityCommandBuffer &EntityCommandQueue::Local()
+{
+    static thread_local struct {
+        uint64_t queue{ 0 };
+        EntityCommandBuffer *buffer{ nullptr };
+    } cache;
+
+    if (cache.queue == id)
+    {
+        return *cache.buffer;
+    }
+
+    std::lock_guard<std::mutex> lock{ mutex };
+    auto &buffer = owners[std::this_thread::get_id()];
+    if (!buffer)
+    {
+        buffers.emplace_back(new EntityCommandBuffer{ uint32_t(buffers.size()) });
+        buffer = buffers.back().get();
+    }
+
+    cache.queue  = id;
+    cache.buffer = buffer;
+
+    return *buffer;
+}
+
+void EntityCommandQueue::Apply(Scene &scene)
+{
+    /* Buffers are never freed, the ones added from here on have nothing to apply yet */
+    std::vector<EntityCommandBuffer *> taken;
+    {
+        std::lock_guard<std::mutex> lock{ mutex };
+        taken.reserve(buffers.size());
+        for (auto &buffer : buffers)
+        {
+            taken.emplace_back(buffer.get());
+        }
+    }
+
+    for (auto buffer : taken)
+    {
+        std::lock_guard<std::mutex> lock{ buffer->mutex };
+        std::swap(buffer->recording, buffer->applying);
+    }
+
+    std::vector<std::vector<entt::entity>> created(taken.size());
+    for (size_t i = 0; i < taken.size(); i++)
+    {
+        if (taken[i]->applying.Created)
+        {
+            created[i] = scene.CreateObjects(taken[i]->applying.Created);
+        }
+    }
+    EntityCommandBuffer::Resolver resolve{ created };
+
+    std::vector<std::pair<entt::id_type, EntityCommandBuffer::Commands *>> commands;
+    for (auto buffer : taken)
+    {
+        for (auto &[type, components] : buffer->applying.Components)
+        {
+            commands.emplace_back(type, components.get());
+        }
+    }
+    std::stable_sort(commands.begin(), commands.end(), [](const auto &lhs, const auto &rhs) -> bool {
+        return lhs.first < rhs.first;
+    });
+
+    auto &registry = scene.Registry();
+    for (auto &[type, components] : commands)
+    {
+        components->Apply(registry, resolve);
+        components->Clear();
+    }
+
+    std::vector<entt::entity> destroyed;
+    for (auto buffer : taken)
+    {
+        for (auto &target : buffer->applying.Destroyed)
+        {
+            entt::entity entity = resolve(target);
+            if (registry.valid(entity))
+            {
+                destroyed.emplace_back(entity);
+            }
+        }
+        buffer->applying.Destroyed.clear();
+        buffer->applying.Created = 0;
+    }
+
+    /* The same object could have been destroyed from several places, DestroyObjects takes it once */
+    scene.DestroyObjects(destroyed);
+}
+
+}
@@ -0,0 +1,255 @@
+#pragma once
+
+#include "Core.h"
+
+#include "entt.hpp"
+
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+namespace Immortal
+{
+
+class Scene;
+
+/*
+ * @brief Structural changes to the registry recorded while it must not change, i.e. in
+ *  the middle of iterating a view or from a system running on the pool, and applied all
+ *  at once at the next sync point. Every thread records into a buffer of its own.
+ */
+class EntityCommandBuffer
+{
+public:
+    static constexpr uint32_t Existing = ~0u;
+
+    /*
+     * @brief An entity created by a buffer, which only exists once the buffer is applied.
+     *  Components could be added to it in the meantime.
+     */
+    struct Pending
+    {
+        uint32_t Buffer;
+        uint32_t Index;
+    };
+
+    /*
+     * @brief Either an entity of the registry or a pending one.
+     */
+    struct Target
+    {
+        Target(entt::entity entity) :
+            Entity{ entity }, Buffer{ Existing }, Index{ 0 }
+        {
+
+        }
+
+        /* Anything that is an entity, i.e. an Object */
+        template <class T, class = std::enable_if_t<std::is_convertible_v<const T &, entt::entity>>>
+        Target(const T &object) :
+            Target{ entt::entity(object) }
+        {
+
+        }
+
+        Target(Pending pending) :
+            Entity{ entt::null }, Buffer{ pending.Buffer }, Index{ pending.Index }
+        {
+
+        }
+
+        entt::entity Entity;
+        uint32_t Buffer;
+        uint32_t Index;
+    };
+
+    class Resolver
+    {
+    public:
+        Resolver(const std::vector<std::vector<entt::entity>> &created) :
+            created{ created }
+        {
+
+        }
+
+        entt::entity operator()(const Target &target) const
+        {
+            return target.Buffer == Existing ? target.Entity : created[target.Buffer][target.Index];
+        }
+
+    private:
+        const std::vector<std::vector<entt::entity>> &created;
+    };
+
+    class Commands
+    {
+    public:
+        virtual ~Commands() = default;
+
+        virtual void Apply(entt::registry &registry, const Resolver &resolve) = 0;
+
+        virtual void Clear() = 0;
+    };
+
+    /*
+     * @brief The adds and removes of one component type, kept in the order they came in.
+     */
+    template <class T>
+    class ComponentCommands : public Commands
+    {
+    public:
+        template <class... Args>
+        void Add(Target target, Args &&... args)
+        {
+            targets.emplace_back(target);
+            adds.emplace_back(true);
+            values.emplace_back(T{ std::forward<Args>(args)... });
+        }
+
+        void Remove(Target target)
+        {
+            targets.emplace_back(target);
+            adds.emplace_back(false);
+        }
+
+        virtual void Apply(entt::registry &registry, const Resolver &resolve) override
+        {
+            size_t value = 0;
+            for (size_t i = 0; i < targets.size(); i++)
+            {
+                entt::entity entity = resolve(targets[i]);
+                if (adds[i])
+                {
+                    T &component = values[value++];
+                    if (registry.valid(entity))
+                    {
+                        registry.emplace_or_replace<T>(entity, std::move(component));
+                    }
+                }
+                else if (registry.valid(entity))
+                {
+                    registry.remove_if_exists<T>(entity);
+                }
+            }
+        }
+
+        virtual void Clear() override
+        {
+            targets.clear();
+            adds.clear();
+            values.clear();
+        }
+
+    private:
+        std::vector<Target> targets;
+
+        std::vector<uint8_t> adds;
+
+        std::vector<T> values;
+    };
+
+public:
+    EntityCommandBuffer(uint32_t index) :
+        index{ index }
+    {
+
+    }
+
+    Pending Create()
+    {
+        std::lock_guard<std::mutex> lock{ mutex };
+        return Pending{ index, recording.Created++ };
+    }
+
+    void Destroy(Target target)
+    {
+        std::lock_guard<std::mutex> lock{ mutex };
+        recording.Destroyed.emplace_back(target);
+    }
+
+    template <class T, class... Args>
+    void Add(Target target, Args &&... args)
+    {
+        std::lock_guard<std::mutex> lock{ mutex };
+        Get<T>().Add(target, std::forward<Args>(args)...);
+    }
+
+    template <class T>
+    void Remove(Target target)
+    {
+        std::lock_guard<std::mutex> lock{ mutex };
+        Get<T>().Remove(target);
+    }
+
+private:
+    /*
+     * @brief What was recorded since the buffer was last applied. The commands of each type
+     *  stay around once cleared, so recording the same kinds every frame does not allocate.
+     */
+    struct Recording
+    {
+        uint32_t Created{ 0 };
+
+        std::vector<Target> Destroyed;
+
+        std::vector<std::pair<entt::id_type, std::unique_ptr<Commands>>> Components;
+    };
+
+    template <class T>
+    ComponentCommands<T> &Get()
+    {
+        auto id = entt::type_info<T>::id();
+        for (auto &[type, commands] : recording.Components)
+        {
+            if (type == id)
+            {
+                return static_cast<ComponentCommands<T> &>(*commands);
+            }
+        }
+        recording.Components.emplace_back(id, std::make_unique<ComponentCommands<T>>());
+        return static_cast<ComponentCommands<T> &>(*recording.Components.back().second);
+    }
+
+    friend class EntityCommandQueue;
+
+private:
+    uint32_t index;
+
+    Recording recording;
+
+    /* Swapped with recording under the lock, then applied without it */
+    Recording applying;
+
+    std::mutex mutex;
+};
+
+/*
+ * @brief The buffers of every thread recording for a scene. Applying creates the pending
+ *  entities first, then goes through the components one type at a time, so each pool is
+ *  touched once, and destroys last, so whatever was destroyed in the same frame goes.
+ *  No lock is held while applying, what the signals record on the way goes to the next
+ *  sync point.
+ */
+class EntityCommandQueue
+{
+public:
+    EntityCommandQueue();
+
+    /*
+     * @brief The buffer of the calling thread.
+     */
+    EntityCommandBuffer &Local();
+
+    void Apply(Scene &scene);
+
+private:
+    uint64_t id;
+
+    std::vector<std::unique_ptr<EntityCommandBuffer>> buffers;
+
+    std::unordered_map<std::thread::id, EntityCommandBuffer *> owners;
+
+    std::mutex mutex;
+};
+
+}
@@ -2,7 +2,6 @@
 
 #include "Core.h"
 #include "Object.h"
-#include "Interface/Delegate.h"
 
 namespace Immortal
 {
@@ -42,6 +41,16 @@ public:
 
     }
 
+    /*
+     * @brief Return true if OnUpdate only touches the object of the script and queues
+     *  anything else on Scene::Commands, to have the instances of the type updated on
+     *  the pool in parallel. Asked once per type, the first time an instance runs.
+     */
+    virtual bool ThreadSafe() const
+    {
+        return false;
+    }
+
     GameObject &operator=(const Object &o)
     {
         *dynamic_cast<Object *>(this) = o;
@@ -56,7 +65,7 @@ struct NativeScriptComponent : public Component
         Component{ Type::Script },
         Status{ Status::NotLoaded }
     {
-        delegate = std::make_shared<Delegate<void()>>();
+
     }
 
     NativeScriptComponent(const std::string &module) :
@@ -64,19 +73,23 @@ struct NativeScriptComponent : public Component
         Module{ module },
         Status{ Status::NotLoaded }
     {
-        delegate = std::make_shared<Delegate<void()>>();
+
     }
 
+    /*
+     * @brief Take over the instance of the script, which is deleted along with the last
+     *  copy of the component that holds it.
+     */
     void Map(Object o, GameObject *script)
     {
         *script = o;
         script->OnStart();
-        delegate->Map<GameObject, &GameObject::OnUpdate>(script);
+        Script.reset(script);
     }
 
     void OnRuntime()
     {
-        delegate->Invoke();
+        Script->OnUpdate();
     }
 
     ~NativeScriptComponent()
@@ -92,7 +105,7 @@ struct NativeScriptComponent : public Component
 
     std::string Module;
 
-    std::shared_ptr<Delegate<void()>> delegate;
+    std::shared_ptr<GameObject> Script;
 
     NativeScriptComponent::Status Status;
 };
@@ -50,6 +50,16 @@ public:
         return scene->Registry().emplace<T>(handle, std::forward<Args>(args)...);
     }
 
+    /*
+     * @brief Change a component in place and let the registry know, i.e. to keep the
+     *  indices of the scene up to date.
+     */
+    template <class T, class F>
+    T &PatchComponent(F &&func)
+    {
+        return scene->Registry().patch<T>(handle, std::forward<F>(func));
+    }
+
     template <class T>
     T &GetComponent() const
     {
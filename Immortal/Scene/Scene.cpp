@@ -10,9 +10,17 @@
 #include "Component.h"
 #include "GameObject.h"
 
+#include "Framework/Async.h"
+#include "Framework/FrameAllocator.h"
+#include "Framework/Frustum.h"
+#include "Framework/Timer.h"
+
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
+#include <chrono>
+#include <random>
+
 namespace Immortal
 {
 
@@ -32,9 +40,215 @@ struct ShadingUniformBuffer
     Vector4 eyePosition;
 };
 
+/* The tag of the node of an entity without a TagComponent */
+static constexpr uint32_t NoTag = ~0u;
+
+/* The quad Render2D draws every sprite with */
+static const BoundingBox QuadBounds{ Vector3{ -0.5f, -0.5f, 0.0f }, Vector3{ 0.5f, 0.5f, 0.0f } };
+
+/*
+ * @brief Test the world bounds of every object of the view against the frustum, in
+ *  parallel chunks of batches, and keep the visible ones in the order of the view.
+ *  bounds(object) gives the bounds of the object in model space.
+ */
+template <class View, class Bounds>
+static FrameVector<entt::entity> Cull(View &view, const Frustum &frustum, Bounds &&bounds, uint32_t &culled)
+{
+    static constexpr size_t BatchSize = 64;
+
+    FrameVector<entt::entity> objects{ view.begin(), view.end() };
+    FrameVector<uint8_t> visible(objects.size());
+
+    Async::ParallelFor(size_t(0), objects.size(), Scene::TransformGrain, [&](size_t first, size_t last) {
+        float streams[6][BatchSize];
+        Vector::BoundsStreams batch = {
+            { streams[0], streams[1], streams[2] },
+            { streams[3], streams[4], streams[5] }
+        };
+
+        for (size_t base = first; base < last; base += BatchSize)
+        {
+            size_t count = std::min(BatchSize, last - base);
+            for (size_t k = 0; k < count; k++)
+            {
+                auto o = objects[base + k];
+                Vector3 center;
+                Vector3 extent;
+                bounds(o).Transform(view.template get<TransformComponent>(o).WorldTransform(), center, extent);
+                for (int c = 0; c < 3; c++)
+                {
+                    streams[c + 0][k] = center[c];
+                    streams[c + 3][k] = extent[c];
+                }
+            }
+            frustum.Cull(batch, count, &visible[base]);
+        }
+    });
+
+    size_t count = 0;
+    for (size_t i = 0; i < objects.size(); i++)
+    {
+        if (visible[i])
+        {
+            objects[count++] = objects[i];
+        }
+    }
+    culled = uint32_t(objects.size() - count);
+    objects.resize(count);
+
+    return objects;
+}
+
+/*
+ * @brief Count every change the registry signals on the saved components.
+ */
+template <class... Components>
+void Scene::TrackChanges()
+{
+    ([this] {
+        registry.on_construct<Components>().template connect<&Scene::Touch>(*this);
+        registry.on_update<Components>().template connect<&Scene::Touch>(*this);
+        registry.on_destroy<Components>().template connect<&Scene::Touch>(*this);
+    }(), ...);
+}
+
+template <class T>
+static void Hold(Handle<T> &held, Handle<T> handle)
+{
+    if (held != handle)
+    {
+        auto &table = ResourceTable<T>::Instance();
+        table.Retain(handle);
+        table.Release(held);
+        held = handle;
+    }
+}
+
+/*
+ * @brief Count the resources a component refers to, in place of the ones it did before.
+ */
+template <class T>
+void Scene::RetainResources(entt::registry &registry, entt::entity entity)
+{
+    auto &held = Held(entity);
+    const T &component = registry.get<T>(entity);
+    if constexpr (std::is_same_v<T, SpriteRendererComponent>)
+    {
+        Hold(held.Sprite, component.Texture);
+    }
+    else if constexpr (std::is_same_v<T, MeshComponent>)
+    {
+        Hold(held.Mesh, component.Mesh);
+    }
+    else
+    {
+        Hold(held.Material[0], component.AlbedoMap);
+        Hold(held.Material[1], component.NormalMap);
+        Hold(held.Material[2], component.MetalnessMap);
+        Hold(held.Material[3], component.RoughnessMap);
+    }
+}
+
+template <class T>
+void Scene::ReleaseResources(entt::registry &, entt::entity entity)
+{
+    auto &held = Held(entity);
+    if constexpr (std::is_same_v<T, SpriteRendererComponent>)
+    {
+        Hold(held.Sprite, {});
+    }
+    else if constexpr (std::is_same_v<T, MeshComponent>)
+    {
+        Hold(held.Mesh, {});
+    }
+    else
+    {
+        for (auto &texture : held.Material)
+        {
+            Hold(texture, {});
+        }
+    }
+}
+
+/*
+ * @brief Catch up with handles written straight into the components, which never signal.
+ *  That is an integer compare per handle, only the ones that differ are counted. A handle
+ *  whose count went meanwhile is still there, the table waits frames before retiring it.
+ */
+template <class... Components>
+void Scene::RecountResources()
+{
+    ([this] {
+        auto view = registry.view<Components>();
+        auto entities = view.data();
+        for (size_t i = 0; i < view.size(); i++)
+        {
+            RetainResources<Components>(registry, entities[i]);
+        }
+    }(), ...);
+}
+
+/*
+ * @brief Let the components count the resources they refer to, so a texture or a mesh
+ *  goes with the last component using it instead of staying in its table for good.
+ */
+template <class... Components>
+void Scene::CountResources()
+{
+    ([this] {
+        registry.on_construct<Components>().template connect<&Scene::RetainResources<Components>>(*this);
+        registry.on_update<Components>().template connect<&Scene::RetainResources<Components>>(*this);
+        registry.on_destroy<Components>().template connect<&Scene::ReleaseResources<Components>>(*this);
+    }(), ...);
+}
+
 Scene::Scene(const std::string &debugName, bool isEditorScene) :
     debugName{ debugName }
 {
+    registry.on_construct<TransformComponent>().connect<&Scene::AddTransform>(*this);
+    registry.on_destroy<TransformComponent>().connect<&Scene::RemoveTransform>(*this);
+    registry.on_destroy<TransformComponent>().connect<&Scene::RemoveProxy>(*this);
+    registry.on_construct<RelationshipComponent>().connect<&Scene::Invalidate>(*this);
+    registry.on_update<RelationshipComponent>().connect<&Scene::Invalidate>(*this);
+    registry.on_destroy<RelationshipComponent>().connect<&Scene::Invalidate>(*this);
+
+    /* The bounds come from these, refresh the ones of the object when one comes or goes */
+    registry.on_construct<MeshComponent>().connect<&Scene::RefreshBounds>(*this);
+    registry.on_update<MeshComponent>().connect<&Scene::RefreshBounds>(*this);
+    registry.on_destroy<MeshComponent>().connect<&Scene::RefreshBounds>(*this);
+    registry.on_construct<SpriteRendererComponent>().connect<&Scene::RefreshBounds>(*this);
+    registry.on_destroy<SpriteRendererComponent>().connect<&Scene::RefreshBounds>(*this);
+
+    registry.on_construct<IDComponent>().connect<&Scene::IndexUID>(*this);
+    registry.on_update<IDComponent>().connect<&Scene::ReindexUID>(*this);
+    registry.on_destroy<IDComponent>().connect<&Scene::UnindexUID>(*this);
+    registry.on_construct<TagComponent>().connect<&Scene::IndexTag>(*this);
+    registry.on_update<TagComponent>().connect<&Scene::ReindexTag>(*this);
+    registry.on_destroy<TagComponent>().connect<&Scene::UnindexTag>(*this);
+
+    registry.on_construct<CameraComponent>().connect<&Scene::InvalidateCamera>(*this);
+    registry.on_update<CameraComponent>().connect<&Scene::InvalidateCamera>(*this);
+    registry.on_destroy<CameraComponent>().connect<&Scene::InvalidateCamera>(*this);
+
+    TrackChanges<
+        IDComponent,
+        TransformComponent,
+        RelationshipComponent,
+        TagComponent,
+        MeshComponent,
+        MaterialComponent,
+        LightComponent,
+        SceneComponent,
+        SpriteRendererComponent,
+        CameraComponent,
+        DirectionalLightComponent,
+        ScriptComponent,
+        NativeScriptComponent,
+        ColorMixingComponent
+    >();
+
+    CountResources<SpriteRendererComponent, MeshComponent, MaterialComponent>();
+
     entity = registry.create();
     registry.emplace<TransformComponent>(entity);
 
@@ -58,6 +272,7 @@ Scene::Scene(const std::string &debugName, bool isEditorScene) :
 
 Scene::~Scene()
 {
+    Synchronize();
     registry.clear();
 }
 
@@ -71,112 +286,254 @@ void Scene::OnEvent()
 
 }
 
+static RenderPacket::CameraProxy Capture(const Camera &camera)
+{
+    return RenderPacket::CameraProxy{ camera.ViewProjection(), camera.Projection(), camera.View() };
+}
+
 void Scene::OnRenderRuntime()
 {
-    // Update Script
+    Synchronize();
+
+    /* A packet simulated ahead before the scene was last left alone sits on recycled frame memory */
+    if (pipeline.primed && pipeline.packets[pipeline.front].Expired())
     {
-        registry.view<NativeScriptComponent>().each([=](auto o, NativeScriptComponent &script)
-            {
-                if (script.Status == NativeScriptComponent::Status::Ready)
-                {
-                    script.OnRuntime();
-                }
-            });
+        pipeline.primed = false;
     }
 
-    SceneCamera *primaryCamera = nullptr;
-    Matrix4 cameraTransform;
+    /* Input is polled on this thread, so the observer camera moves here and only its view goes along */
+    if (!pipeline.primed || pipeline.packets[pipeline.front].Observed)
     {
-        auto view = registry.view<TransformComponent, CameraComponent>();
-        for (auto &o : view)
-        {
-            auto [transform, camera] = view.get<TransformComponent, CameraComponent>(o);
-            if (camera.Primary)
-            {
-                primaryCamera = &camera.Camera;
-                cameraTransform = transform;
-                break;
-            }
-        }
+        observerCamera.SetViewportSize(viewportSize);
+        observerCamera.OnUpdate(Application::DeltaTime());
     }
+    pipeline.observer = Capture(observerCamera);
 
-    // Only renderer when we have a primary Camera
-    if (!primaryCamera)
+    if (!pipeline.primed)
     {
-        primaryCamera = dynamic_cast<SceneCamera*>(&observerCamera);
-        primaryCamera->SetViewportSize(viewportSize);
-        observerCamera.OnUpdate(Application::DeltaTime());
+        RenderPacket &first = pipeline.packets[pipeline.front];
+        first.Scripts.clear();
+        UpdateScripts(first.Scripts, false);
+        Simulate(first, pipeline.observer);
+        pipeline.primed = true;
     }
-    else
+
+    const RenderPacket &packet = pipeline.packets[pipeline.front];
+    pipeline.front ^= 1;
+
+    /* Scripts that are not thread safe may poll input or call into ImGui, which only works from here */
+    RenderPacket *next = &pipeline.packets[pipeline.front];
+    next->Scripts.clear();
+    UpdateScripts(next->Scripts, false);
+
+    pipeline.owner = std::this_thread::get_id();
+    Async::Dispatch([this, next]() -> void {
+        Simulate(*next, pipeline.observer);
+    }, Job::Description{ Priority::Critical, &pipeline.simulation });
+
+    Draw(packet);
+}
+
+void Scene::OnRenderEditor(const EditorCamera &editorCamera)
+{
+    Synchronize();
+
+    /* The editor changes the registry in between, so nothing is simulated ahead */
+    pipeline.primed = false;
+
+    ApplyCommands();
+    UpdateTransforms();
+
+    RenderPacket &packet = pipeline.packets[pipeline.front];
+    Extract(packet, Capture(editorCamera));
+    Draw(packet);
+}
+
+void Scene::Synchronize()
+{
+    if (!pipeline.simulation.Finished())
     {
-        primaryCamera->SetTransform(cameraTransform);
+        /* The jobs of the simulation this thread picks up while waiting own the registry */
+        pipeline.synchronizing = true;
+        Async::Wait(pipeline.simulation);
+        pipeline.synchronizing = false;
     }
+}
+
+/*
+ * @brief Whether the calling thread may touch the registry. Only the thread that handed
+ *  the frame over is kept out while it is simulated, the workers running it are not.
+ */
+bool Scene::Owned() const
+{
+    return std::this_thread::get_id() != pipeline.owner || pipeline.synchronizing || pipeline.simulation.Finished();
+}
+
+void Scene::ApplyCommands()
+{
+    commands.Apply(*this);
+}
+
+/*
+ * @brief Update the scripts of one kind one type after the other, so the same code runs
+ *  over and over while it is hot. The types that are thread safe have their instances
+ *  spread over the pool and have to queue structural changes on Commands. The others run
+ *  one by one on the calling thread, which owns the registry, so they are gathered and
+ *  run before the thread safe ones are even looked at.
+ */
+void Scene::UpdateScripts(std::vector<RenderPacket::ScriptTiming> &timings, bool threadSafe)
+{
+    auto &groups = scripts.groups;
+    for (auto &group : groups)
+    {
+        group.Instances.clear();
+    }
+
+    /* Instances of a type tend to come in runs, the map is only asked when the type changes */
+    const std::type_info *previous = nullptr;
+    size_t current = 0;
+
+    auto view = registry.view<NativeScriptComponent>();
+    auto components = view.raw();
+    for (size_t i = 0; i < view.size(); i++)
     {
-        Render::Begin(renderTarget);
+        auto &script = components[i];
+        if (script.Status != NativeScriptComponent::Status::Ready || !script.Script)
+        {
+            continue;
+        }
 
+        GameObject *instance = script.Script.get();
+        const std::type_info *type = &typeid(*instance);
+        if (type != previous)
         {
-            Render2D::BeginScene(dynamic_cast<const Camera&>(*primaryCamera));
-            auto group = registry.group<TransformComponent>(entt::get<SpriteRendererComponent>);
-            for (auto o : group)
+            auto [index, inserted] = scripts.types.Emplace(type, groups.size());
+            if (inserted)
             {
-                auto [transform, sprite] = group.get<TransformComponent, SpriteRendererComponent>(o);
-                Render2D::DrawSprite(transform.Transform(), sprite, (int)o);
+                groups.emplace_back(ScriptGroup{ type, instance->ThreadSafe(), {} });
             }
-
-            Render2D::EndScene();
+            current = *index;
+            previous = type;
         }
-
+        if (groups[current].ThreadSafe == threadSafe)
         {
-            TransformUniformBuffer transformUniforms;
-            transformUniforms.viewProjectionMatrix = primaryCamera->ViewProjection();
-            transformUniforms.skyProjectionMatrix  = primaryCamera->Projection() * Matrix4(Vector::Matrix3(primaryCamera->View()));
-            transformUniforms.sceneRotationMatrix  = Matrix4(Vector::Matrix3(primaryCamera->View()));
-            uniforms.transform->Update(sizeof(TransformUniformBuffer), &transformUniforms);
+            groups[current].Instances.emplace_back(instance);
         }
+    }
 
+    for (auto &group : groups)
+    {
+        if (group.Instances.empty())
         {
-            ShadingUniformBuffer shadingUniforms;
-            shadingUniforms.eyePosition = primaryCamera->View()[3];
-            for (int i = 0; i < SL_ARRAY_LENGTH(shadingUniforms.lights); ++i)
-            {
-                const Light &light = environments.light.lights[i];
-                shadingUniforms.lights[i].direction = Vector4{ light.Direction, 0.0f };
+            continue;
+        }
+
+        Timer timer;
+        timer.Start();
 
-                Vector4 finalLight = Vector4{};
-                if (light.Enabled)
+        GameObject **instances = group.Instances.data();
+        if (group.ThreadSafe)
+        {
+            Async::ParallelFor(size_t(0), group.Instances.size(), ScriptGrain, [=](size_t first, size_t last) {
+                for (size_t i = first; i < last; i++)
                 {
-                    finalLight = Vector4{ light.Radiance, 0.0f };
+                    instances[i]->OnUpdate();
                 }
-                shadingUniforms.lights[i].radiance = finalLight;
-            }
-            uniforms.shading->Update(sizeof(ShadingUniformBuffer), &shadingUniforms);
+            });
         }
-
+        else
         {
-            auto view = registry.view<TransformComponent, MeshComponent, MaterialComponent>();
-            for (auto o : view)
+            for (size_t i = 0; i < group.Instances.size(); i++)
             {
-                auto [transform, mesh, material] = view.get<TransformComponent, MeshComponent, MaterialComponent>(o);
-                auto &shader = Render::Get<Shader, ShaderName::PBR>();
-                Render::Submit(shader, mesh.Mesh, transform.Transform());
+                instances[i]->OnUpdate();
             }
         }
-        Render::End();
+
+        timings.emplace_back(RenderPacket::ScriptTiming{
+            group.Type->name(),
+            uint32_t(group.Instances.size()),
+            group.ThreadSafe,
+            float(timer.Stop())
+        });
+    }
+}
+
+void Scene::Simulate(RenderPacket &packet, const RenderPacket::CameraProxy &observer)
+{
+    UpdateScripts(packet.Scripts, true);
+
+    ApplyCommands();
+    UpdateTransforms();
+
+    SceneCamera *primaryCamera = nullptr;
+    if (auto o = FindPrimaryCamera(); o != entt::null && registry.has<TransformComponent>(o))
+    {
+        primaryCamera = &registry.get<CameraComponent>(o).Camera;
+        primaryCamera->SetTransform(registry.get<TransformComponent>(o).WorldTransform());
+    }
+
+    Extract(packet, primaryCamera ? Capture(*primaryCamera) : observer);
+    packet.Observed = !primaryCamera;
+}
+
+/*
+ * @brief Copy what is visible from the camera out of the registry. Only the world matrix,
+ *  the resources and the look of each object go along, the components stay behind.
+ */
+void Scene::Extract(RenderPacket &packet, const RenderPacket::CameraProxy &camera)
+{
+    RecountResources<SpriteRendererComponent, MeshComponent, MaterialComponent>();
+
+    packet.Clear();
+    packet.Camera = camera;
+
+    Frustum frustum{ camera.ViewProjection };
+
+    {
+        auto view = registry.view<TransformComponent, SpriteRendererComponent>();
+        auto visible = Cull(view, frustum, [](entt::entity) -> const BoundingBox & { return QuadBounds; }, packet.CulledSprites);
+
+        packet.Sprites.reserve(visible.size());
+        for (auto o : visible)
+        {
+            auto [transform, sprite] = view.get<TransformComponent, SpriteRendererComponent>(o);
+            packet.Sprites.emplace_back(RenderPacket::SpriteProxy{
+                transform.WorldTransform(), sprite.Texture, sprite.Color, sprite.TilingFactor, (int)o });
+        }
     }
 
+    {
+        auto view = registry.view<TransformComponent, MeshComponent, MaterialComponent>();
+        auto visible = Cull(view, frustum, [&](entt::entity o) -> BoundingBox {
+            auto &mesh = view.get<MeshComponent>(o);
+            return mesh.Mesh ? mesh.Mesh->Bounds() : BoundingBox{};
+        }, packet.CulledMeshes);
+
+        packet.Meshes.reserve(visible.size());
+        for (auto o : visible)
+        {
+            auto [transform, mesh] = view.get<TransformComponent, MeshComponent>(o);
+            packet.Meshes.emplace_back(RenderPacket::MeshProxy{ transform.WorldTransform(), mesh.Mesh, (int)o });
+        }
+    }
 }
 
-void Scene::OnRenderEditor(const EditorCamera &editorCamera)
+/*
+ * @brief Record the draws of a packet. Never touches the registry.
+ */
+void Scene::Draw(const RenderPacket &packet)
 {
+    const auto &camera = packet.Camera;
+
     Render::Begin(renderTarget);
 
     {
-        Render2D::BeginScene(dynamic_cast<const Camera&>(editorCamera));
-        auto group = registry.group<TransformComponent>(entt::get<SpriteRendererComponent>);
-        for (auto o : group)
+        Render2D::BeginScene(camera.ViewProjection);
+        Render2D::Cull(packet.CulledSprites);
+
+        for (auto &sprite : packet.Sprites)
         {
-            auto [transform, sprite] = group.get<TransformComponent, SpriteRendererComponent>(o);
-            Render2D::DrawSprite(transform.Transform(), sprite, (int)o);
+            Render2D::DrawQuad(sprite.Transform, sprite.Texture, sprite.TilingFactor, sprite.Color, sprite.EntityID);
         }
 
         Render2D::EndScene();
@@ -184,76 +541,973 @@ void Scene::OnRenderEditor(const EditorCamera &editorCamera)
 
     {
         TransformUniformBuffer transformUniforms;
-        transformUniforms.viewProjectionMatrix = editorCamera.ViewProjection();
-        transformUniforms.skyProjectionMatrix  = editorCamera.Projection() * Matrix4(Vector::Matrix3(editorCamera.View()));
-        transformUniforms.sceneRotationMatrix  = Matrix4{ Matrix3{ editorCamera.View() } };
-        uniforms.shading->Update(sizeof(TransformUniformBuffer), &transformUniforms);
+        transformUniforms.viewProjectionMatrix = camera.ViewProjection;
+        transformUniforms.skyProjectionMatrix  = camera.Projection * Matrix4(Vector::Matrix3(camera.View));
+        transformUniforms.sceneRotationMatrix  = Matrix4(Vector::Matrix3(camera.View));
+        uniforms.transform->Update(sizeof(TransformUniformBuffer), &transformUniforms);
     }
 
     {
         ShadingUniformBuffer shadingUniforms;
-        shadingUniforms.eyePosition = editorCamera.View()[3];
+        shadingUniforms.eyePosition = camera.View[3];
         for (int i = 0; i < SL_ARRAY_LENGTH(shadingUniforms.lights); ++i)
         {
             const Light &light = environments.light.lights[i];
             shadingUniforms.lights[i].direction = Vector4{ light.Direction, 0.0f };
 
-            Vector4 finalLight{};
+            Vector4 finalLight = Vector4{};
             if (light.Enabled)
             {
                 finalLight = Vector4{ light.Radiance, 0.0f };
             }
-
             shadingUniforms.lights[i].radiance = finalLight;
         }
         uniforms.shading->Update(sizeof(ShadingUniformBuffer), &shadingUniforms);
     }
 
-    auto view = registry.view<TransformComponent, MeshComponent, MaterialComponent>();
-    for (auto &o : view)
+    Render::Cull(packet.CulledMeshes);
+    for (auto &mesh : packet.Meshes)
     {
-        auto [transform, mesh, material] = view.get<TransformComponent, MeshComponent, MaterialComponent>(o);
         auto &shader = Render::Get<Shader, ShaderName::PBR>();
-        Render::Submit(shader, mesh.Mesh, transform.Transform());
+        Render::Submit(shader, mesh.Mesh, mesh.Transform);
     }
 
     Render::End();
 }
 
-Object Scene::CreateObject(const std::string &name)
+/* The pool is one array, the address of a transform is its place in it */
+template <class View>
+static inline size_t TransformIndex(const View &view, entt::entity e)
 {
-    auto o = Object{ registry.create(), this };
+    return size_t(&view.template get<TransformComponent>(e) - view.raw());
+}
 
-    o.AddComponent<TransformComponent>();
-    auto &idComponent = o.AddComponent<IDComponent>();
-    o.AddComponent<TagComponent>(name);
+/* What changed holds for each transform of the last pass */
+enum : uint8_t
+{
+    Moved  = 1 << 0,
+    Edited = 1 << 1
+};
 
-    return o;
+/*
+ * @brief Rebuild the local matrices of the dirty transforms in [first, last). They are
+ *  gathered into streams a batch at a time, so the kernel runs on full vectors no matter
+ *  how the dirty ones are spread over the pool. Marks each of them in changed.
+ */
+static void ComposeTransforms(TransformComponent *transforms, size_t first, size_t last, uint8_t *changed)
+{
+    static constexpr size_t BatchSize = 64;
+
+    float streams[9][BatchSize];
+    uint32_t indices[BatchSize];
+    Matrix4 matrices[BatchSize];
+
+    Vector::TransformStreams batch = {
+        { streams[0], streams[1], streams[2] },
+        { streams[3], streams[4], streams[5] },
+        { streams[6], streams[7], streams[8] }
+    };
+
+    auto flush = [&](size_t count) {
+        Vector::ComposeTransforms(batch, count, matrices);
+        for (size_t k = 0; k < count; k++)
+        {
+            transforms[indices[k]].Update(matrices[k]);
+        }
+    };
+
+    size_t count = 0;
+    for (size_t i = first; i < last; i++)
+    {
+        auto &transform = transforms[i];
+        bool dirty = transform.Dirty();
+        changed[i] |= dirty ? Moved | Edited : 0;
+        if (!dirty)
+        {
+            continue;
+        }
+
+        for (int c = 0; c < 3; c++)
+        {
+            streams[c + 0][count] = transform.Position[c];
+            streams[c + 3][count] = transform.Rotation[c];
+            streams[c + 6][count] = transform.Scale[c];
+        }
+        indices[count++] = uint32_t(i);
+
+        if (count == BatchSize)
+        {
+            flush(count);
+            count = 0;
+        }
+    }
+    flush(count);
 }
 
-void Scene::DestroyObject(Object & o)
+void Scene::UpdateTransforms()
 {
-    registry.destroy(o);
+    if (hierarchy.dirty)
+    {
+        SortHierarchy();
+        hierarchy.dirty = false;
+    }
+
+    auto view = registry.view<TransformComponent>();
+    SLASSERT(hierarchy.changed.size() == view.size() && "Every transform has to have a place in the hierarchy");
+
+    auto transforms = view.raw();
+    auto parents    = hierarchy.parents.data();
+    auto changed    = hierarchy.changed.data();
+
+    /* Whatever their own matrix did, these ended up somewhere else in the world */
+    std::fill(hierarchy.changed.begin(), hierarchy.changed.end(), uint8_t(0));
+    for (auto e : hierarchy.stale)
+    {
+        if (registry.valid(e) && view.contains(e))
+        {
+            changed[TransformIndex(view, e)] = Moved;
+        }
+    }
+    hierarchy.stale.clear();
+
+    /* A level only reads the level above it, which is complete by the time ParallelFor returns */
+    for (size_t level = 0; level + 1 < hierarchy.levels.size(); level++)
+    {
+        Async::ParallelFor(hierarchy.levels[level], hierarchy.levels[level + 1], TransformGrain, [=](size_t first, size_t last) {
+            ComposeTransforms(transforms, first, last, changed);
+
+            for (size_t i = first; i < last; i++)
+            {
+                auto &transform = transforms[i];
+                uint32_t parent = parents[i];
+
+                bool dirty = changed[i] || (parent != RootNode && changed[parent]);
+                if (dirty)
+                {
+                    transform.SetWorldTransform(parent == RootNode ?
+                        transform.Transform() : transforms[parent].WorldTransform() * transform.Transform());
+                }
+                changed[i] = (changed[i] & Edited) | (dirty ? Moved : 0);
+            }
+        });
+    }
+
+    /* Fields written in place never signal, the transforms they changed are edits all the same */
+    auto entities = view.data();
+    for (size_t i = 0; i < view.size(); i++)
+    {
+        if (changed[i] & Edited)
+        {
+            Touch(registry, entities[i]);
+        }
+    }
+
+    UpdateSpatial();
 }
 
-void Scene::SetViewportSize(const Vector2 &size)
+static inline size_t EntityIndex(entt::entity e)
 {
-    viewportSize = size;
-    renderTarget->Resize(size);
+    using Traits = entt::entt_traits<std::underlying_type_t<entt::entity>>;
+    return size_t(entt::to_integral(e) & Traits::entity_mask);
 }
 
-Object Scene::PrimaryCameraObject()
+/*
+ * @brief Move the proxies of the transforms the last pass changed, and of the objects
+ *  whose mesh or sprite came or went since. The tree is not safe to change from several
+ *  threads, but most moves stay inside their fat boxes and only store the new bounds.
+ */
+void Scene::UpdateSpatial()
 {
-    auto view = registry.view<CameraComponent>();
-    for (auto o : view)
+    auto view = registry.view<TransformComponent>();
+    auto transforms = view.raw();
+    auto entities   = view.data();
+
+    for (size_t i = 0; i < view.size(); i++)
+    {
+        if (hierarchy.changed[i])
+        {
+            PlaceProxy(entities[i], transforms[i]);
+        }
+    }
+
+    /* Checked here, the component that went is still there while it is signaled */
+    for (auto e : spatial.stale)
     {
-        const auto &camera = view.get<CameraComponent>(o);
-        if (camera.Primary)
+        if (registry.valid(e) && view.contains(e))
         {
-            return Object{ o, this };
+            PlaceProxy(e, view.get<TransformComponent>(e));
         }
     }
-    return Object{};
+    spatial.stale.clear();
+}
+
+void Scene::PlaceProxy(entt::entity e, const TransformComponent &transform)
+{
+    BoundingBox local;
+    if (auto mesh = registry.try_get<MeshComponent>(e); mesh && mesh->Mesh)
+    {
+        local = mesh->Mesh->Bounds();
+    }
+    else if (registry.has<SpriteRendererComponent>(e))
+    {
+        local = QuadBounds;
+    }
+
+    Vector3 center;
+    Vector3 extent;
+    local.Transform(transform.WorldTransform(), center, extent);
+    BoundingBox world{ center - extent, center + extent };
+
+    size_t id = EntityIndex(e);
+    if (id >= spatial.proxies.size())
+    {
+        spatial.proxies.resize(id + 1, Physics::DynamicTree::Null);
+    }
+
+    int32_t &proxy = spatial.proxies[id];
+    if (proxy == Physics::DynamicTree::Null)
+    {
+        proxy = spatial.tree.Insert(world, entt::to_integral(e));
+    }
+    else
+    {
+        spatial.tree.Move(proxy, world);
+    }
+}
+
+void Scene::RefreshBounds(entt::registry &, entt::entity e)
+{
+    spatial.stale.emplace_back(e);
+}
+
+void Scene::RemoveProxy(entt::registry &, entt::entity e)
+{
+    size_t id = EntityIndex(e);
+    if (id < spatial.proxies.size() && spatial.proxies[id] != Physics::DynamicTree::Null)
+    {
+        spatial.tree.Remove(spatial.proxies[id]);
+        spatial.proxies[id] = Physics::DynamicTree::Null;
+    }
+}
+
+bool Scene::Raycast(const Vector3 &origin, const Vector3 &direction, float maxDistance, Physics::RaycastHit &hit) const
+{
+    return spatial.tree.Raycast(origin, Vector::Normalize(direction), maxDistance, hit);
+}
+
+std::vector<Object> Scene::Overlap(const BoundingBox &box)
+{
+    std::vector<Object> objects;
+    spatial.tree.Overlap(box, [&](int32_t proxy) -> bool {
+        objects.emplace_back(entt::entity(spatial.tree.UserData(proxy)), this);
+        return true;
+    });
+    return objects;
+}
+
+std::vector<Object> Scene::Overlap(const Vector3 &center, float radius)
+{
+    std::vector<Object> objects;
+    spatial.tree.Overlap(center, radius, [&](int32_t proxy) -> bool {
+        objects.emplace_back(entt::entity(spatial.tree.UserData(proxy)), this);
+        return true;
+    });
+    return objects;
+}
+
+std::vector<Object> Scene::Nearest(const Vector3 &point, size_t count)
+{
+    std::vector<uint32_t> found;
+    spatial.tree.Nearest(point, count, found);
+
+    std::vector<Object> objects;
+    objects.reserve(found.size());
+    for (auto id : found)
+    {
+        objects.emplace_back(entt::entity(id), this);
+    }
+    return objects;
+}
+
+/*
+ * @brief Sort the transform pool breadth first, starting from every root at once so that
+ *  each level ends up contiguous. Objects whose parent has no transform count as roots,
+ *  and so do the ones no root leads to, e.g. a cycle or a child missing from the list of
+ *  its parent after an inconsistent load. Each of those starts a walk of its own, which
+ *  comes after the deeper levels, but still only reads ranges sorted before it.
+ */
+void Scene::SortHierarchy()
+{
+    auto id = EntityIndex;
+
+    auto view = registry.view<TransformComponent>();
+    auto parentOf = [&](entt::entity e) -> entt::entity {
+        auto relationship = registry.try_get<RelationshipComponent>(e);
+        return relationship && relationship->Parent != entt::null && view.contains(relationship->Parent) ?
+            relationship->Parent : entt::null;
+    };
+
+    std::vector<entt::entity> order;
+    std::vector<uint32_t> parents;
+    order.reserve(view.size());
+    parents.reserve(view.size());
+
+    std::vector<uint32_t> ranks(registry.size(), RootNode);
+    std::vector<uint32_t> depths(registry.size(), 0);
+    auto enqueue = [&](entt::entity e, uint32_t parent) {
+        ranks[id(e)]  = uint32_t(order.size());
+        depths[id(e)] = parent == RootNode ? 0 : depths[id(order[parent])] + 1;
+        order.emplace_back(e);
+        parents.emplace_back(parent);
+    };
+
+    size_t next = 0;
+    auto walk = [&]() {
+        for (; next < order.size(); next++)
+        {
+            auto relationship = registry.try_get<RelationshipComponent>(order[next]);
+            if (!relationship)
+            {
+                continue;
+            }
+            for (auto child = relationship->First; child != entt::null; child = registry.get<RelationshipComponent>(child).Next)
+            {
+                /* Reached before means the list is broken, what is left of it is picked up as roots */
+                if (ranks[id(child)] != RootNode)
+                {
+                    break;
+                }
+                if (view.contains(child))
+                {
+                    enqueue(child, uint32_t(next));
+                }
+            }
+        }
+    };
+
+    for (auto e : view)
+    {
+        if (parentOf(e) == entt::null)
+        {
+            enqueue(e, RootNode);
+        }
+    }
+    walk();
+
+    if (order.size() < view.size())
+    {
+        size_t reached = order.size();
+        for (auto e : view)
+        {
+            if (ranks[id(e)] == RootNode)
+            {
+                enqueue(e, RootNode);
+                walk();
+            }
+        }
+        LOG::WARN("{0} transforms could not be reached from a root of the hierarchy, they are treated as roots.", order.size() - reached);
+    }
+    SLASSERT(order.size() == view.size() && "Every transform has to have a place in the hierarchy");
+
+    /* The pool is sorted back to front, so the greater rank has to go first */
+    registry.sort<TransformComponent>([&](const entt::entity lhs, const entt::entity rhs) -> bool {
+        return ranks[id(lhs)] > ranks[id(rhs)];
+    });
+
+    hierarchy.parents = std::move(parents);
+    hierarchy.changed.resize(order.size());
+    hierarchy.levels.clear();
+    for (size_t i = 0; i < order.size(); i++)
+    {
+        if (i == 0 || depths[id(order[i])] != depths[id(order[i - 1])])
+        {
+            hierarchy.levels.emplace_back(i);
+        }
+    }
+    hierarchy.levels.emplace_back(order.size());
+}
+
+/*
+ * @brief A transform was added at the end of the pool. Without a RelationshipComponent it
+ *  is a root without children, so it joins the last range instead of having the pool
+ *  sorted again. A range insert signals once all of them are in, one after the other.
+ */
+void Scene::AddTransform(entt::registry &, entt::entity e)
+{
+    hierarchy.stale.emplace_back(e);
+    if (hierarchy.dirty)
+    {
+        return;
+    }
+
+    auto view = registry.view<TransformComponent>();
+    if (registry.has<RelationshipComponent>(e) || TransformIndex(view, e) != hierarchy.parents.size())
+    {
+        hierarchy.dirty = true;
+        return;
+    }
+
+    if (hierarchy.levels.size() < 2)
+    {
+        hierarchy.levels = { 0, 0 };
+    }
+    hierarchy.parents.emplace_back(RootNode);
+    hierarchy.changed.emplace_back(0);
+    hierarchy.levels.back()++;
+}
+
+/*
+ * @brief The pool moves its last transform into the place of the one removed. If neither
+ *  is in a hierarchy, the one moved is a root without children, which the range it lands
+ *  in takes as well, so the arrays just do the same.
+ */
+void Scene::RemoveTransform(entt::registry &, entt::entity e)
+{
+    if (hierarchy.dirty)
+    {
+        return;
+    }
+
+    /* A pool cleared at once signals all of its transforms before any of them is gone */
+    auto view = registry.view<TransformComponent>();
+    if (view.size() != hierarchy.parents.size() ||
+        registry.has<RelationshipComponent>(e) || registry.has<RelationshipComponent>(view.data()[view.size() - 1]))
+    {
+        hierarchy.dirty = true;
+        return;
+    }
+
+    hierarchy.parents[TransformIndex(view, e)] = RootNode;
+    hierarchy.parents.pop_back();
+    hierarchy.changed.pop_back();
+
+    auto &levels = hierarchy.levels;
+    if (--levels.back() == levels[levels.size() - 2])
+    {
+        levels.pop_back();
+    }
+}
+
+/*
+ * @brief A link of the hierarchy changed, which is the only thing that sorts the pool
+ *  again. The world matrix of the object is rebuilt, its children follow.
+ */
+void Scene::Invalidate(entt::registry &, entt::entity e)
+{
+    hierarchy.stale.emplace_back(e);
+    hierarchy.dirty = true;
+}
+
+Object Scene::CreateObject(const std::string &name)
+{
+    SLASSERT(Owned() && "The registry belongs to the simulation, Synchronize first");
+
+    auto o = Object{ registry.create(), this };
+
+    o.AddComponent<TransformComponent>();
+    auto &idComponent = o.AddComponent<IDComponent>();
+    o.AddComponent<TagComponent>(name);
+
+    return o;
+}
+
+void Scene::DestroyObject(Object & o)
+{
+    SLASSERT(Owned() && "The registry belongs to the simulation, Synchronize first");
+
+    entt::entity root = o;
+    auto relationship = registry.try_get<RelationshipComponent>(root);
+    if (!relationship)
+    {
+        registry.destroy(root);
+        return;
+    }
+    Unlink(root, *relationship);
+
+    /* The children go along with their parent */
+    std::vector<entt::entity> subtree{ root };
+    for (size_t i = 0; i < subtree.size(); i++)
+    {
+        auto &node = registry.get<RelationshipComponent>(subtree[i]);
+        for (auto child = node.First; child != entt::null; child = registry.get<RelationshipComponent>(child).Next)
+        {
+            subtree.emplace_back(child);
+        }
+    }
+    registry.destroy(subtree.begin(), subtree.end());
+}
+
+/*
+ * @brief Give every entity of the range a copy of each of the components the prototype
+ *  has, one insert per pool.
+ */
+template <class... Components>
+static void CopyComponents(entt::registry &registry, entt::entity prototype, const entt::entity *first, const entt::entity *last)
+{
+    ([&] {
+        if (auto component = registry.try_get<Components>(prototype))
+        {
+            /* Copied out first, the pool it lives in is about to grow */
+            Components value = *component;
+            registry.insert<Components>(first, last, value);
+        }
+    }(), ...);
+}
+
+std::vector<entt::entity> Scene::CreateObjects(size_t count, const Object &prototype)
+{
+    SLASSERT(Owned() && "The registry belongs to the simulation, Synchronize first");
+
+    Reserve(count);
+
+    std::vector<entt::entity> objects(count);
+    registry.create(objects.begin(), objects.end());
+
+    const entt::entity *first = objects.data();
+    const entt::entity *last  = first + count;
+
+    entt::entity source = prototype;
+    bool copy = source != entt::null && registry.valid(source);
+    if (copy && registry.has<TransformComponent>(source))
+    {
+        TransformComponent transform = registry.get<TransformComponent>(source);
+        registry.insert<TransformComponent>(first, last, transform);
+    }
+    else
+    {
+        registry.insert<TransformComponent>(first, last);
+    }
+    registry.insert<IDComponent>(first, last);
+    if (copy && registry.has<TagComponent>(source))
+    {
+        TagComponent tag = registry.get<TagComponent>(source);
+        registry.insert<TagComponent>(first, last, tag);
+    }
+    else
+    {
+        registry.insert<TagComponent>(first, last);
+    }
+
+    if (copy)
+    {
+        CopyComponents<
+            MeshComponent,
+            MaterialComponent,
+            SpriteRendererComponent,
+            CameraComponent,
+            LightComponent,
+            DirectionalLightComponent,
+            ScriptComponent,
+            ColorMixingComponent,
+            FilterComponent
+        >(registry, source, first, last);
+    }
+
+    return objects;
+}
+
+std::vector<entt::entity> Scene::CreateObjects(size_t count)
+{
+    return CreateObjects(count, Object{});
+}
+
+void Scene::Reserve(size_t count)
+{
+    SLASSERT(Owned() && "The registry belongs to the simulation, Synchronize first");
+
+    size_t objects = registry.view<IDComponent>().size() + count;
+    indices.uids.Reserve(objects);
+    indices.uidNodes.reserve(registry.size() + count);
+    indices.tagNodes.reserve(registry.size() + count);
+    changes.nodes.reserve(registry.size() + count);
+    resources.reserve(registry.size() + count);
+    hierarchy.parents.reserve(hierarchy.parents.size() + count);
+    hierarchy.changed.reserve(hierarchy.changed.size() + count);
+    hierarchy.stale.reserve(hierarchy.stale.size() + count);
+}
+
+void Scene::DestroyObjects(std::vector<entt::entity> &objects)
+{
+    SLASSERT(Owned() && "The registry belongs to the simulation, Synchronize first");
+
+    /* Already gone, i.e. destroyed from somewhere else, the registry would destroy it again */
+    objects.erase(std::remove_if(objects.begin(), objects.end(), [&](entt::entity o) -> bool {
+        return !registry.valid(o);
+    }), objects.end());
+
+    /* Only objects in a hierarchy have children to take along, the rest go in one range */
+    auto hierarchical = std::stable_partition(objects.begin(), objects.end(), [&](entt::entity o) -> bool {
+        return !registry.has<RelationshipComponent>(o);
+    });
+
+    for (auto it = hierarchical; it != objects.end(); ++it)
+    {
+        /* Could have gone along with a parent destroyed just before, or be listed twice */
+        if (registry.valid(*it))
+        {
+            Object o{ *it, this };
+            DestroyObject(o);
+        }
+    }
+
+    /* Sorted, a range comes in the order it was created and anything listed twice goes once */
+    std::sort(objects.begin(), hierarchical);
+    auto flat = std::unique(objects.begin(), hierarchical);
+
+    /* Backwards every pool just pops its last element */
+    registry.destroy(std::make_reverse_iterator(flat), objects.rend());
+}
+
+void Scene::SetParent(Object &child, const Object &parent)
+{
+    SLASSERT(Owned() && "The registry belongs to the simulation, Synchronize first");
+
+    entt::entity node     = child;
+    entt::entity ancestor = parent;
+
+    if (ancestor != entt::null && (ancestor == node || IsDescendant(ancestor, node)))
+    {
+        LOG::WARN("Unable to attach an object to itself or to one of its children.");
+        return;
+    }
+
+    /* Add all the components first, emplacing could move the ones already looked up */
+    if (!registry.has<RelationshipComponent>(node))
+    {
+        registry.emplace<RelationshipComponent>(node);
+    }
+    if (ancestor != entt::null && !registry.has<RelationshipComponent>(ancestor))
+    {
+        registry.emplace<RelationshipComponent>(ancestor);
+    }
+
+    auto &relationship = registry.get<RelationshipComponent>(node);
+    Unlink(node, relationship);
+
+    if (ancestor != entt::null)
+    {
+        auto &parentRelationship = registry.get<RelationshipComponent>(ancestor);
+        if (parentRelationship.First != entt::null)
+        {
+            registry.get<RelationshipComponent>(parentRelationship.First).Previous = node;
+        }
+        relationship.Parent = ancestor;
+        relationship.Next   = parentRelationship.First;
+        parentRelationship.First = node;
+        parentRelationship.Children++;
+
+        Touch(registry, relationship.Next);
+        Touch(registry, ancestor);
+    }
+
+    Touch(registry, node);
+    hierarchy.stale.emplace_back(node);
+    hierarchy.dirty = true;
+}
+
+void Scene::Unlink(entt::entity entity, RelationshipComponent &relationship)
+{
+    if (relationship.Parent == entt::null)
+    {
+        return;
+    }
+
+    auto &parent = registry.get<RelationshipComponent>(relationship.Parent);
+    if (parent.First == entity)
+    {
+        parent.First = relationship.Next;
+    }
+    if (relationship.Previous != entt::null)
+    {
+        registry.get<RelationshipComponent>(relationship.Previous).Next = relationship.Next;
+    }
+    if (relationship.Next != entt::null)
+    {
+        registry.get<RelationshipComponent>(relationship.Next).Previous = relationship.Previous;
+    }
+    parent.Children--;
+
+    Touch(registry, relationship.Parent);
+    Touch(registry, relationship.Previous);
+    Touch(registry, relationship.Next);
+    Touch(registry, entity);
+
+    relationship.Parent   = entt::null;
+    relationship.Previous = entt::null;
+    relationship.Next     = entt::null;
+}
+
+bool Scene::IsDescendant(entt::entity entity, entt::entity ancestor)
+{
+    for (auto relationship = registry.try_get<RelationshipComponent>(entity); relationship && relationship->Parent != entt::null;
+        relationship = registry.try_get<RelationshipComponent>(relationship->Parent))
+    {
+        if (relationship->Parent == ancestor)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void Scene::SetViewportSize(const Vector2 &size)
+{
+    viewportSize = size;
+    renderTarget->Resize(size);
+}
+
+Object Scene::PrimaryCameraObject()
+{
+    auto o = FindPrimaryCamera();
+    return o == entt::null ? Object{} : Object{ o, this };
+}
+
+entt::entity Scene::FindPrimaryCamera()
+{
+    /* Primary is a plain field, so the cached camera could have given it up in the meantime */
+    auto cached = primaryCamera.entity;
+    if (!primaryCamera.dirty && (cached == entt::null || registry.get<CameraComponent>(cached).Primary))
+    {
+        return cached;
+    }
+
+    primaryCamera.entity = entt::null;
+    primaryCamera.dirty  = false;
+
+    auto view = registry.view<CameraComponent>();
+    for (auto o : view)
+    {
+        if (view.get<CameraComponent>(o).Primary)
+        {
+            primaryCamera.entity = o;
+            break;
+        }
+    }
+    return primaryCamera.entity;
+}
+
+void Scene::InvalidateCamera(entt::registry &, entt::entity)
+{
+    primaryCamera.dirty = true;
+}
+
+Object Scene::FindObjectByUID(uint64_t uid)
+{
+    auto o = indices.uids.Find(uid);
+    return o ? Object{ *o, this } : Object{};
+}
+
+std::vector<Object> Scene::FindObjectsByTag(const std::string &tag)
+{
+    std::vector<Object> objects;
+
+    auto id = indices.tagIds.Find(tag);
+    if (!id)
+    {
+        return objects;
+    }
+
+    auto &list = indices.tags[*id];
+    objects.reserve(list.Count);
+    for (auto o = list.First; o != entt::null; o = indices.tagNodes[EntityIndex(o)].Next)
+    {
+        objects.emplace_back(o, this);
+    }
+    return objects;
+}
+
+/*
+ * @brief Random rather than counted, so objects keep their UID across scenes and saves
+ *  without any two of them ever having to agree on a counter.
+ */
+uint64_t Scene::GenerateUID()
+{
+    static thread_local std::mt19937_64 engine{ std::random_device{}() ^ uint64_t(std::chrono::steady_clock::now().time_since_epoch().count()) };
+
+    uint64_t uid = 0;
+    while (!uid || indices.uids.Contains(uid))
+    {
+        uid = engine();
+    }
+    return uid;
+}
+
+/*
+ * @brief Objects come without a UID from CreateObject and friends and get one here. One
+ *  that is already taken, e.g. by a copied component, is replaced as well.
+ */
+void Scene::IndexUID(entt::registry &, entt::entity o)
+{
+    auto &id = registry.get<IDComponent>(o);
+    if (!id.uid || indices.uids.Contains(id.uid))
+    {
+        if (id.uid)
+        {
+            LOG::WARN("UID {0} is already taken, the object gets a new one.", id.uid);
+        }
+        id.uid = GenerateUID();
+    }
+    indices.uids.Emplace(id.uid, o);
+
+    size_t index = EntityIndex(o);
+    if (index >= indices.uidNodes.size())
+    {
+        indices.uidNodes.resize(index + 1, UIDNode{ 0, 0 });
+    }
+    indices.uidNodes[index] = UIDNode{ id.uid, ++changes.version };
+}
+
+/*
+ * @brief Only a UID that was in the last file saved is a removal for the next delta, one
+ *  that came and went since was never written.
+ */
+void Scene::UnindexUID(entt::registry &, entt::entity o)
+{
+    size_t index = EntityIndex(o);
+    if (index < indices.uidNodes.size() && indices.uidNodes[index].UID)
+    {
+        auto &node = indices.uidNodes[index];
+        indices.uids.Erase(node.UID);
+        if (node.Version <= changes.saved)
+        {
+            changes.set.Removed.emplace_back(node.UID);
+        }
+        node = UIDNode{ 0, 0 };
+    }
+}
+
+/*
+ * @brief Files know an object by its UID, so once it was saved it stays. Until then it may
+ *  be replaced, i.e. for an object created through Commands. Replacing the component with
+ *  an equal one is not a change at all.
+ */
+void Scene::ReindexUID(entt::registry &, entt::entity o)
+{
+    size_t index = EntityIndex(o);
+    if (index >= indices.uidNodes.size() || !indices.uidNodes[index].UID)
+    {
+        IndexUID(registry, o);
+        return;
+    }
+
+    auto &id   = registry.get<IDComponent>(o);
+    auto &node = indices.uidNodes[index];
+    if (id.uid == node.UID)
+    {
+        return;
+    }
+
+    if (node.Version <= changes.saved || !id.uid || indices.uids.Contains(id.uid))
+    {
+        LOG::WARN("UID {0} cannot be taken, the object keeps {1}.", id.uid, node.UID);
+        id.uid = node.UID;
+        return;
+    }
+
+    indices.uids.Erase(node.UID);
+    indices.uids.Emplace(id.uid, o);
+    node.UID = id.uid;
+}
+
+void Scene::IndexTag(entt::registry &, entt::entity o)
+{
+    const auto &tag = registry.get<TagComponent>(o).Tag;
+
+    auto [id, inserted] = indices.tagIds.Emplace(tag, uint32_t(indices.tags.size()));
+    if (inserted)
+    {
+        indices.tags.emplace_back(TagList{ entt::null, 0 });
+    }
+    auto &list = indices.tags[*id];
+
+    size_t index = EntityIndex(o);
+    if (index >= indices.tagNodes.size())
+    {
+        indices.tagNodes.resize(index + 1, TagNode{ NoTag, entt::null, entt::null });
+    }
+    auto &node = indices.tagNodes[index];
+    node = TagNode{ *id, entt::null, list.First };
+    if (list.First != entt::null)
+    {
+        indices.tagNodes[EntityIndex(list.First)].Previous = o;
+    }
+    list.First = o;
+    list.Count++;
+}
+
+void Scene::UnindexTag(entt::registry &, entt::entity o)
+{
+    size_t index = EntityIndex(o);
+    if (index >= indices.tagNodes.size() || indices.tagNodes[index].Tag == NoTag)
+    {
+        return;
+    }
+
+    auto &node = indices.tagNodes[index];
+    auto &list = indices.tags[node.Tag];
+    if (node.Previous != entt::null)
+    {
+        indices.tagNodes[EntityIndex(node.Previous)].Next = node.Next;
+    }
+    else
+    {
+        list.First = node.Next;
+    }
+    if (node.Next != entt::null)
+    {
+        indices.tagNodes[EntityIndex(node.Next)].Previous = node.Previous;
+    }
+    list.Count--;
+
+    node = TagNode{ NoTag, entt::null, entt::null };
+}
+
+void Scene::ReindexTag(entt::registry &registry, entt::entity o)
+{
+    UnindexTag(registry, o);
+    IndexTag(registry, o);
+}
+
+void Scene::Touch(entt::registry &, entt::entity o)
+{
+    if (o == entt::null)
+    {
+        return;
+    }
+
+    size_t index = EntityIndex(o);
+    if (index >= changes.nodes.size())
+    {
+        changes.nodes.resize(index + 1, ChangeNode{ entt::null, 0 });
+    }
+
+    auto &node = changes.nodes[index];
+    if (node.Entity != o || node.Version <= changes.saved)
+    {
+        changes.set.Changed.emplace_back(o);
+    }
+    node = ChangeNode{ o, ++changes.version };
+}
+
+Scene::HeldResources &Scene::Held(entt::entity entity)
+{
+    size_t index = EntityIndex(entity);
+    if (index >= resources.size())
+    {
+        resources.resize(index + 1);
+    }
+    return resources[index];
+}
+
+void Scene::ResetChanges(const std::string &baseline)
+{
+    /* Transforms written in place since the last update are part of the baseline as well */
+    UpdateTransforms();
+
+    changes.set.Changed.clear();
+    changes.set.Removed.clear();
+    changes.set.Baseline = baseline;
+    changes.saved = changes.version;
 }
 
 }
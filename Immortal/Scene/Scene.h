@@ -13,6 +13,18 @@
 #include "Render/RenderTarget.h"
 #include "Render/Pipeline.h"
 
+#include "Physics/DynamicTree.h"
+
+#include "Framework/FlatHashMap.h"
+#include "Framework/FrameAllocator.h"
+
+#include "EntityCommandBuffer.h"
+
+#include "Framework/Async.h"
+
+#include <thread>
+#include <typeinfo>
+
 namespace Immortal
 {
 
@@ -20,11 +32,10 @@ struct Resolution
 {
     operator std::string()
     {
-        return std::string{
-            std::to_string(Width) +
-            std::string{ "x" } +
-            std::to_string(Height)
-        };
+        /* Fits in the small string buffer, so there is nothing to allocate */
+        char buffer[24];
+        int size = snprintf(buffer, sizeof(buffer), "%ux%u", Width, Height);
+        return std::string{ buffer, size_t(size) };
     }
 
     uint32_t Width;
@@ -90,9 +101,126 @@ struct LightEnvironment
     Light lights[LightNumbers];
 };
 
+/*
+ * @brief The part of a frame the render passes need, copied out of the registry at the
+ *  end of the simulation. Drawing only reads the packet, so the registry is free to move
+ *  on to the next frame while it does.
+ */
+struct RenderPacket
+{
+    struct SpriteProxy
+    {
+        Matrix4 Transform;
+        Handle<Immortal::Texture> Texture;
+        Vector4 Color;
+        float TilingFactor;
+        int EntityID;
+    };
+
+    struct MeshProxy
+    {
+        Matrix4 Transform;
+        Handle<Immortal::Mesh> Mesh;
+        int EntityID;
+    };
+
+    struct CameraProxy
+    {
+        Matrix4 ViewProjection;
+        Matrix4 Projection;
+        Matrix4 View;
+    };
+
+    /*
+     * @brief How long the instances of one type of script took to update.
+     */
+    struct ScriptTiming
+    {
+        const char *Type;
+        uint32_t Instances;
+        bool Parallel;
+        float Milliseconds;
+    };
+
+    /*
+     * @brief Start over on fresh frame memory, the storage of an earlier frame may be
+     *  recycled already. The proxies are trivially destructible, so dropping them never
+     *  reads it.
+     */
+    void Clear()
+    {
+        Sprites = FrameVector<SpriteProxy>{};
+        Meshes  = FrameVector<MeshProxy>{};
+        CulledSprites = 0;
+        CulledMeshes  = 0;
+        Frame = FrameAllocator::Frame();
+    }
+
+    /*
+     * @brief Whether the proxies were extracted too long ago to be drawn.
+     */
+    bool Expired() const
+    {
+        return FrameAllocator::Frame() - Frame >= FrameAllocator::FramesInFlight;
+    }
+
+    CameraProxy Camera;
+
+    FrameVector<SpriteProxy> Sprites;
+
+    FrameVector<MeshProxy> Meshes;
+
+    uint32_t CulledSprites{ 0 };
+
+    uint32_t CulledMeshes{ 0 };
+
+    /* Filled by the scripts before the rest is extracted, so Clear leaves them be */
+    std::vector<ScriptTiming> Scripts;
+
+    /* Whether no primary camera was found and the observer camera was used instead */
+    bool Observed{ true };
+
+    /* The frame of the frame memory the proxies live in */
+    uint64_t Frame{ 0 };
+};
+
+static_assert(std::is_trivially_destructible_v<RenderPacket::SpriteProxy> && std::is_trivially_destructible_v<RenderPacket::MeshProxy>,
+    "The proxies are dropped without touching the frame memory they live in");
+
 class Object;
+class GameObject;
+struct RelationshipComponent;
+struct TransformComponent;
 class IMMORTAL_API Scene
 {
+public:
+    /*
+     * @brief What changed since the scene was last saved or loaded, for saving only that.
+     *  A change is a saved component being added, patched or removed through the registry,
+     *  or a link of the hierarchy moved by the scene. Fields written directly count once
+     *  the component is patched, i.e. registry.patch<TransformComponent>(o) after a move.
+     */
+    struct ChangeSet
+    {
+        /* The entities changed, the ones destroyed since and repeats included */
+        std::vector<entt::entity> Changed;
+
+        /* The UIDs of the objects destroyed that were saved before */
+        std::vector<uint64_t> Removed;
+
+        /* The file the changes are relative to, empty if there is none */
+        std::string Baseline;
+    };
+
+    /* Transforms per job of the update passes, small enough to balance, large enough to pay for the job */
+    static constexpr size_t TransformGrain = 1024;
+
+    /* The parent index of the transforms at the top of the hierarchy */
+    static constexpr uint32_t RootNode = ~0u;
+
+    /* Instances per job of the thread safe scripts, which do a lot more than a transform */
+    static constexpr size_t ScriptGrain = 64;
+
 public:
     Scene(const std::string &debugName="Untitled", bool isEditorScene = false);
 
@@ -102,20 +230,136 @@ public:
 
     void OnEvent();
 
+    /*
+     * @brief Draw the frame simulated during the last call, while the next one is simulated
+     *  on the pool. The scripts that are not thread safe run here, on the calling thread,
+     *  before the rest is handed over. Between two calls the registry belongs to the
+     *  simulation, anything else that touches it has to Synchronize first.
+     */
     void OnRenderRuntime();
 
     void OnRenderEditor(const EditorCamera &editorCamera);
 
+    /*
+     * @brief Wait for the frame being simulated ahead, if any.
+     */
+    void Synchronize();
+
+    /*
+     * @brief The command buffer of the calling thread, for changes that have to wait for
+     *  the next sync point, i.e. from inside a view or a system running on the pool.
+     */
+    EntityCommandBuffer &Commands()
+    {
+        return commands.Local();
+    }
+
+    /*
+     * @brief The sync point. Runs after the scripts of every simulated frame and before
+     *  every editor frame, anything else that calls it has to own the registry.
+     */
+    void ApplyCommands();
+
     Object CreateObject(const std::string &name = "");
 
     void DestroyObject(Object &e);
 
+    /*
+     * @brief Create count objects at once, one pool after the other instead of one entity
+     *  after the other. Each gets what CreateObject gives it, plus a copy of the components
+     *  of the prototype, if there is one, except its place in the hierarchy.
+     */
+    std::vector<entt::entity> CreateObjects(size_t count, const Object &prototype);
+
+    std::vector<entt::entity> CreateObjects(size_t count);
+
+    /*
+     * @brief Make room in the indices for count more objects, so that adding many at once,
+     *  i.e. when loading, does not rehash over and over.
+     */
+    void Reserve(size_t count);
+
+    /*
+     * @brief Destroy every object of the range once, with their children like DestroyObject.
+     *  Takes Objects or entities, repeats and ones already gone included.
+     */
+    template <class It>
+    void DestroyObjects(It first, It last)
+    {
+        std::vector<entt::entity> objects(first, last);
+        DestroyObjects(objects);
+    }
+
+    void DestroyObjects(std::vector<entt::entity> &objects);
+
     void SetViewportSize(const Vector::Vector2 &size);
 
+    /*
+     * @brief Attach child to parent, or make it a root again if parent is an empty
+     *  Object. Takes constant time, the breadth first order of the transforms is only
+     *  rebuilt once on the next UpdateTransforms.
+     */
+    void SetParent(Object &child, const Object &parent);
+
+    /*
+     * @brief Rebuild the cached matrices of the transforms that have changed and
+     *  propagate the world matrices down the hierarchy, one level after the other. Run
+     *  once before rendering, so that the render passes only ever read clean caches.
+     */
+    void UpdateTransforms();
+
+    /*
+     * @brief Spatial queries over the world bounds of the objects, i.e. the bounds of their
+     *  mesh or sprite, as of the last UpdateTransforms. Objects without either are a point.
+     */
+    bool Raycast(const Vector3 &origin, const Vector3 &direction, float maxDistance, Physics::RaycastHit &hit) const;
+
+    std::vector<Object> Overlap(const BoundingBox &box);
+
+    std::vector<Object> Overlap(const Vector3 &center, float radius);
+
+    std::vector<Object> Nearest(const Vector3 &point, size_t count);
+
+    /*
+     * @brief The first camera marked Primary. Cached until a CameraComponent comes, goes or
+     *  is patched, so flip Primary through registry.patch to have it noticed right away.
+     */
     Object PrimaryCameraObject();
 
+    /*
+     * @brief Lookups in constant time through indices the registry keeps up to date. Tags
+     *  are indexed when the TagComponent is added, replaced or patched, not when the
+     *  string is written to directly.
+     */
+    Object FindObjectByUID(uint64_t uid);
+
+    std::vector<Object> FindObjectsByTag(const std::string &tag);
+
+    /*
+     * @brief The objects changed since the last reset. Transforms written in place only
+     *  count once UpdateTransforms has seen them, the rest as soon as they are signaled.
+     */
+    const ChangeSet &Changes() const
+    {
+        return changes.set;
+    }
+
+    /*
+     * @brief Bumped on every change, so a save can tell whether there is anything to do.
+     */
+    uint64_t Version() const
+    {
+        return changes.version;
+    }
+
+    /*
+     * @brief Start counting changes over, after the scene was saved to or loaded from baseline.
+     */
+    void ResetChanges(const std::string &baseline);
+
     auto &Registry()
     {
+        SLASSERT(Owned() && "The registry belongs to the simulation, Synchronize first");
         return registry;
     }
 
@@ -134,6 +378,84 @@ public:
         return renderTarget;
     }
 
+    /*
+     * @brief How long each type of script took in the frame drawn last, for the profiler.
+     */
+    const std::vector<RenderPacket::ScriptTiming> &ScriptTimings() const
+    {
+        return pipeline.packets[pipeline.front ^ 1].Scripts;
+    }
+
+private:
+    void AddTransform(entt::registry &registry, entt::entity entity);
+
+    void RemoveTransform(entt::registry &registry, entt::entity entity);
+
+    void Invalidate(entt::registry &registry, entt::entity entity);
+
+    void Unlink(entt::entity entity, RelationshipComponent &relationship);
+
+    bool IsDescendant(entt::entity entity, entt::entity ancestor);
+
+    void SortHierarchy();
+
+    void UpdateSpatial();
+
+    void PlaceProxy(entt::entity entity, const TransformComponent &transform);
+
+    void RefreshBounds(entt::registry &registry, entt::entity entity);
+
+    void RemoveProxy(entt::registry &registry, entt::entity entity);
+
+    void IndexUID(entt::registry &registry, entt::entity entity);
+
+    void UnindexUID(entt::registry &registry, entt::entity entity);
+
+    void ReindexUID(entt::registry &registry, entt::entity entity);
+
+    void IndexTag(entt::registry &registry, entt::entity entity);
+
+    void UnindexTag(entt::registry &registry, entt::entity entity);
+
+    void ReindexTag(entt::registry &registry, entt::entity entity);
+
+    void InvalidateCamera(entt::registry &registry, entt::entity entity);
+
+    template <class... Components>
+    void TrackChanges();
+
+    void Touch(entt::registry &registry, entt::entity entity);
+
+    template <class... Components>
+    void CountResources();
+
+    template <class T>
+    void RetainResources(entt::registry &registry, entt::entity entity);
+
+    template <class T>
+    void ReleaseResources(entt::registry &registry, entt::entity entity);
+
+    template <class... Components>
+    void RecountResources();
+
+    struct HeldResources;
+
+    HeldResources &Held(entt::entity entity);
+
+    entt::entity FindPrimaryCamera();
+
+    uint64_t GenerateUID();
+
+    bool Owned() const;
+
+    void UpdateScripts(std::vector<RenderPacket::ScriptTiming> &timings, bool threadSafe);
+
+    void Simulate(RenderPacket &packet, const RenderPacket::CameraProxy &observer);
+
+    void Extract(RenderPacket &packet, const RenderPacket::CameraProxy &camera);
+
+    void Draw(const RenderPacket &packet);
+
 private:
     std::string debugName;
 
@@ -167,6 +489,138 @@ private:
 
     Vector2 viewportSize{ 0.0f, 0.0f };
 
+    /*
+     * @brief The transform pool is kept sorted breadth first, so every level of the
+     *  hierarchy is one contiguous range of it and parents always come before their
+     *  children. parents holds the index of the parent of each transform in the pool
+     *  and levels the first index of each level. Only a change of a link sorts it again.
+     *  Transforms outside of any hierarchy are roots without children, which any range
+     *  can take, so they come and go at the end of the last one like they do in the pool.
+     *  stale holds the transforms whose world matrix has to be rebuilt whatever their own
+     *  one did, i.e. the new ones and the ones whose parent changed.
+     */
+    struct {
+        std::vector<uint32_t> parents;
+        std::vector<size_t> levels;
+        std::vector<uint8_t> changed;
+        std::vector<entt::entity> stale;
+        bool dirty{ true };
+    } hierarchy;
+
+    /*
+     * @brief The tree over the world bounds, with the proxy of every object by entity id,
+     *  and the objects to refresh the bounds of whatever their transform did.
+     */
+    struct {
+        Physics::DynamicTree tree;
+        std::vector<int32_t> proxies;
+        std::vector<entt::entity> stale;
+    } spatial;
+
+    /*
+     * @brief UID to entity, and tag to the entities carrying it as a list threaded through
+     *  the nodes, one per entity id, so unlinking one never searches. Tags are interned and
+     *  the node remembers what the entity was indexed under, for when it changes. The UID
+     *  node keeps the change version the UID was indexed at, only a UID indexed before the
+     *  last save is in the file a removal would be recorded against.
+     */
+    struct UIDNode
+    {
+        uint64_t UID;
+        uint64_t Version;
+    };
+
+    struct TagNode
+    {
+        uint32_t Tag;
+        entt::entity Previous;
+        entt::entity Next;
+    };
+
+    struct TagList
+    {
+        entt::entity First;
+        size_t Count;
+    };
+
+    struct {
+        FlatHashMap<uint64_t, entt::entity> uids;
+        FlatHashMap<std::string, uint32_t> tagIds;
+        std::vector<TagList> tags;
+        std::vector<UIDNode> uidNodes;
+        std::vector<TagNode> tagNodes;
+    } indices;
+
+    struct {
+        entt::entity entity{ entt::null };
+        bool dirty{ true };
+    } primaryCamera;
+
+    /*
+     * @brief One node per entity id, with the entity it was last changed as and the version
+     *  of that change. An entity only goes into the change set on its first change since
+     *  the last reset, so the set grows with the edits, not with the scene.
+     */
+    struct ChangeNode
+    {
+        entt::entity Entity;
+        uint64_t Version;
+    };
+
+    struct {
+        ChangeSet set;
+        std::vector<ChangeNode> nodes;
+        uint64_t version{ 0 };
+        uint64_t saved{ 0 };
+    } changes;
+
+    /*
+     * @brief The resources each entity id holds a count of in the tables, as of the last
+     *  signal of its components or the last Extract, which catches up with handles written
+     *  without a signal. Counting against these instead of the components keeps Retain and
+     *  Release balanced either way.
+     */
+    struct HeldResources
+    {
+        Handle<Immortal::Texture> Sprite;
+        Handle<Immortal::Mesh> Mesh;
+        std::array<Handle<Immortal::Texture>, 4> Material;
+    };
+
+    std::vector<HeldResources> resources;
+
+    EntityCommandQueue commands;
+
+    /*
+     * @brief The instances of the scripts ready to run, gathered by type every frame. The
+     *  groups stay around once a type has been seen, so gathering does not allocate.
+     */
+    struct ScriptGroup
+    {
+        const std::type_info *Type;
+        bool ThreadSafe;
+        std::vector<GameObject *> Instances;
+    };
+
+    struct {
+        FlatHashMap<const std::type_info *, size_t> types;
+        std::vector<ScriptGroup> groups;
+    } scripts;
+
+    /*
+     * @brief The packet of the frame to draw and the one being simulated ahead. The
+     *  observer is the view of the observer camera handed over to the simulation.
+     */
+    struct {
+        RenderPacket packets[2];
+        size_t front{ 0 };
+        bool primed{ false };
+        RenderPacket::CameraProxy observer;
+        WaitGroup simulation;
+        std::thread::id owner;
+        bool synchronizing{ false };
+    } pipeline;
+
 private:
     ObserverCamera observerCamera;
 };
@@ -34,11 +34,27 @@ public:
         return Vector::Degrees(perspectiveFOV);
     }
 
+    /* In radians, as it is kept, so that saving and loading gives back the same float */
+    void SetPerspectiveFOV(float radians)
+    {
+        perspectiveFOV = radians;
+    }
+
+    float PerspectiveFOV() const
+    {
+        return perspectiveFOV;
+    }
+
     void SetPerspectiveNearClip(float nearClip)
     {
         perspectiveNear = nearClip;
     }
 
+    float PerspectiveNearClip() const
+    {
+        return perspectiveNear;
+    }
+
     float &PerspectiveNearClip()
     {
         return perspectiveNear;
@@ -49,6 +65,11 @@ public:
         perspectiveFar = farClip;
     }
 
+    float PerspectiveFarClip() const
+    {
+        return perspectiveFar;
+    }
+
     float &PerspectiveFarClip()
     {
         return perspectiveFar;
@@ -74,6 +95,11 @@ public:
         orthographicNear = nearClip;
     }
 
+    float OrthographicNearClip() const
+    {
+        return orthographicNear;
+    }
+
     float &OrthographicNearClip()
     {
         return orthographicNear;
@@ -84,6 +110,11 @@ public:
         orthographicFar = farClip;
     }
 
+    float OrthographicFarClip() const
+    {
+        return orthographicFar;
+    }
+
     float &OrthographicFarClip()
     {
         return orthographicFar;
@@ -0,0 +1,566 @@
+#include "impch.h"
+#include "JsonStream.h"
+
+#include <charconv>
+#include <cmath>
+
+namespace Immortal
+{
+
+JsonWriter::JsonWriter(const std::string &filepath, size_t lineDepth) :
+    file{ fopen(filepath.c_str(), "wb") },
+    buffer{ new char[BufferSize] },
+    lineDepth{ lineDepth }
+{
+
+}
+
+JsonWriter::~JsonWriter()
+{
+    if (file)
+    {
+        Flush();
+        fclose(file);
+    }
+}
+
+void JsonWriter::Separate()
+{
+    if (keyed)
+    {
+        keyed = false;
+        return;
+    }
+    if (empty.empty())
+    {
+        return;
+    }
+
+    if (!empty.back())
+    {
+        Put(',');
+    }
+    empty.back() = false;
+
+    if (empty.size() <= lineDepth)
+    {
+        Put('\n');
+        for (size_t i = 0; i < empty.size(); i++)
+        {
+            Put('\t');
+        }
+    }
+    else
+    {
+        Put(' ');
+    }
+}
+
+void JsonWriter::Begin(char bracket)
+{
+    Separate();
+    Put(bracket);
+    empty.push_back(true);
+}
+
+void JsonWriter::End(char bracket)
+{
+    bool none = empty.back();
+    empty.pop_back();
+
+    if (!none && empty.size() < lineDepth)
+    {
+        Put('\n');
+        for (size_t i = 0; i < empty.size(); i++)
+        {
+            Put('\t');
+        }
+    }
+    else if (!none)
+    {
+        Put(' ');
+    }
+    Put(bracket);
+
+    if (empty.empty())
+    {
+        Put('\n');
+    }
+}
+
+void JsonWriter::BeginObject()
+{
+    Begin('{');
+}
+
+void JsonWriter::EndObject()
+{
+    End('}');
+}
+
+void JsonWriter::BeginArray()
+{
+    Begin('[');
+}
+
+void JsonWriter::EndArray()
+{
+    End(']');
+}
+
+void JsonWriter::Key(std::string_view key)
+{
+    Separate();
+    PutString(key);
+    Put(": ");
+    keyed = true;
+}
+
+void JsonWriter::Value(std::string_view value)
+{
+    Separate();
+    PutString(value);
+}
+
+/* The shortest text that reads back as the same float */
+void JsonWriter::Value(float value)
+{
+    Separate();
+    if (!std::isfinite(value))
+    {
+        Put("0");
+        return;
+    }
+    char text[32];
+    auto result = std::to_chars(text, text + sizeof(text), value);
+    Put(std::string_view{ text, size_t(result.ptr - text) });
+}
+
+void JsonWriter::Value(uint64_t value)
+{
+    Separate();
+    char text[24];
+    auto result = std::to_chars(text, text + sizeof(text), value);
+    Put(std::string_view{ text, size_t(result.ptr - text) });
+}
+
+void JsonWriter::Value(bool value)
+{
+    Separate();
+    Put(value ? "true" : "false");
+}
+
+void JsonWriter::Value(const Vector3 &value)
+{
+    BeginArray();
+    Value(value.x);
+    Value(value.y);
+    Value(value.z);
+    EndArray();
+}
+
+void JsonWriter::Value(const Vector4 &value)
+{
+    BeginArray();
+    Value(value.x);
+    Value(value.y);
+    Value(value.z);
+    Value(value.w);
+    EndArray();
+}
+
+void JsonWriter::Put(std::string_view text)
+{
+    while (!text.empty())
+    {
+        if (used == BufferSize)
+        {
+            Drain();
+        }
+        size_t count = std::min(text.size(), BufferSize - used);
+        memcpy(buffer.get() + used, text.data(), count);
+        used += count;
+        size += count;
+        text.remove_prefix(count);
+    }
+}
+
+void JsonWriter::PutString(std::string_view text)
+{
+    static const char hex[] = "0123456789abcdef";
+
+    Put('"');
+    size_t plain = 0;
+    for (size_t i = 0; i < text.size(); i++)
+    {
+        unsigned char c = text[i];
+        if (c >= 0x20 && c != '"' && c != '\\')
+        {
+            continue;
+        }
+
+        Put(text.substr(plain, i - plain));
+        plain = i + 1;
+        switch (c)
+        {
+        case '"':  Put("\\\""); break;
+        case '\\': Put("\\\\"); break;
+        case '\n': Put("\\n");  break;
+        case '\r': Put("\\r");  break;
+        case '\t': Put("\\t");  break;
+        default:
+            Put("\\u00");
+            Put(hex[c >> 4]);
+            Put(hex[c & 0xF]);
+            break;
+        }
+    }
+    Put(text.substr(plain));
+    Put('"');
+}
+
+void JsonWriter::Drain()
+{
+    if (file && used && fwrite(buffer.get(), 1, used, file) != used)
+    {
+        failed = true;
+    }
+    used = 0;
+}
+
+bool JsonWriter::Flush()
+{
+    Drain();
+    if (file && fflush(file) != 0)
+    {
+        failed = true;
+    }
+    return bool(*this);
+}
+
+JsonReader::JsonReader(const std::string &filepath) :
+    file{ fopen(filepath.c_str(), "rb") },
+    buffer{ new char[BufferSize] }
+{
+
+}
+
+JsonReader::~JsonReader()
+{
+    if (file)
+    {
+        fclose(file);
+    }
+}
+
+bool JsonReader::Fill()
+{
+    if (!file)
+    {
+        return false;
+    }
+    available = fread(buffer.get(), 1, BufferSize, file);
+    position  = 0;
+    size += available;
+    return available > 0;
+}
+
+JsonReader::Token JsonReader::Next()
+{
+    if (hasPeeked)
+    {
+        hasPeeked = false;
+        return peeked;
+    }
+    return Scan();
+}
+
+JsonReader::Token JsonReader::Peek()
+{
+    if (!hasPeeked)
+    {
+        peeked    = Scan();
+        hasPeeked = true;
+    }
+    return peeked;
+}
+
+JsonReader::Token JsonReader::Scan()
+{
+    while (position < available || Fill())
+    {
+        char c = buffer[position++];
+        switch (c)
+        {
+        case '\n':
+            line++;
+            [[fallthrough]];
+        case ' ':
+        case '\t':
+        case '\r':
+        case ',':
+        case ':':
+            continue;
+
+        case '{': return Token::BeginObject;
+        case '}': return Token::EndObject;
+        case '[': return Token::BeginArray;
+        case ']': return Token::EndArray;
+        case '"': return ScanString();
+
+        default:
+            return ScanLiteral(c);
+        }
+    }
+    return Token::End;
+}
+
+JsonReader::Token JsonReader::ScanString()
+{
+    text.clear();
+    while (true)
+    {
+        /* Take the plain run up to the next quote or escape in one go */
+        size_t start = position;
+        while (position < available && buffer[position] != '"' && buffer[position] != '\\')
+        {
+            position++;
+        }
+        text.append(buffer.get() + start, position - start);
+
+        int c = Get();
+        if (c == '"')
+        {
+            return Token::String;
+        }
+        if (c == '\\')
+        {
+            if (!ScanEscape())
+            {
+                return Token::Error;
+            }
+            continue;
+        }
+        if (c == EOF)
+        {
+            return Token::Error;
+        }
+        /* The buffer ran out in the middle of the run */
+        text.push_back(char(c));
+    }
+}
+
+bool JsonReader::ScanEscape()
+{
+    auto hex4 = [this](uint32_t &code) -> bool {
+        code = 0;
+        for (int i = 0; i < 4; i++)
+        {
+            int c = Get();
+            uint32_t digit;
+            if (c >= '0' && c <= '9')
+            {
+                digit = c - '0';
+            }
+            else if (c >= 'a' && c <= 'f')
+            {
+                digit = c - 'a' + 10;
+            }
+            else if (c >= 'A' && c <= 'F')
+            {
+                digit = c - 'A' + 10;
+            }
+            else
+            {
+                return false;
+            }
+            code = (code << 4) | digit;
+        }
+        return true;
+    };
+
+    int c = Get();
+    switch (c)
+    {
+    case '"':  text.push_back('"');  return true;
+    case '\\': text.push_back('\\'); return true;
+    case '/':  text.push_back('/');  return true;
+    case 'b':  text.push_back('\b'); return true;
+    case 'f':  text.push_back('\f'); return true;
+    case 'n':  text.push_back('\n'); return true;
+    case 'r':  text.push_back('\r'); return true;
+    case 't':  text.push_back('\t'); return true;
+    case 'u':
+        break;
+    default:
+        return false;
+    }
+
+    uint32_t code;
+    if (!hex4(code))
+    {
+        return false;
+    }
+    if (code >= 0xD800 && code < 0xDC00)
+    {
+        uint32_t low;
+        if (Get() != '\\' || Get() != 'u' || !hex4(low) || low < 0xDC00 || low >= 0xE000)
+        {
+            return false;
+        }
+        code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+    }
+
+    /* As UTF-8 */
+    if (code < 0x80)
+    {
+        text.push_back(char(code));
+    }
+    else if (code < 0x800)
+    {
+        text.push_back(char(0xC0 | (code >> 6)));
+        text.push_back(char(0x80 | (code & 0x3F)));
+    }
+    else if (code < 0x10000)
+    {
+        text.push_back(char(0xE0 | (code >> 12)));
+        text.push_back(char(0x80 | ((code >> 6) & 0x3F)));
+        text.push_back(char(0x80 | (code & 0x3F)));
+    }
+    else
+    {
+        text.push_back(char(0xF0 | (code >> 18)));
+        text.push_back(char(0x80 | ((code >> 12) & 0x3F)));
+        text.push_back(char(0x80 | ((code >> 6) & 0x3F)));
+        text.push_back(char(0x80 | (code & 0x3F)));
+    }
+    return true;
+}
+
+/* Numbers, true, false and null */
+static inline bool IsLiteral(char c)
+{
+    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '-' || c == '+' || c == '.';
+}
+
+JsonReader::Token JsonReader::ScanLiteral(int first)
+{
+    text.assign(1, char(first));
+    while (position < available || Fill())
+    {
+        size_t start = position;
+        while (position < available && IsLiteral(buffer[position]))
+        {
+            position++;
+        }
+        text.append(buffer.get() + start, position - start);
+        if (position < available)
+        {
+            break;
+        }
+    }
+
+    if (text == "true")
+    {
+        return Token::True;
+    }
+    if (text == "false")
+    {
+        return Token::False;
+    }
+    if (text == "null")
+    {
+        return Token::Null;
+    }
+    if (first == '-' || (first >= '0' && first <= '9'))
+    {
+        return Token::Number;
+    }
+    return Token::Error;
+}
+
+bool JsonReader::Skip()
+{
+    size_t depth = 0;
+    do
+    {
+        switch (Next())
+        {
+        case Token::BeginObject:
+        case Token::BeginArray:
+            depth++;
+            break;
+
+        case Token::EndObject:
+        case Token::EndArray:
+            if (depth == 0)
+            {
+                return false;
+            }
+            depth--;
+            break;
+
+        case Token::End:
+        case Token::Error:
+            return false;
+
+        default:
+            break;
+        }
+    } while (depth > 0);
+
+    return true;
+}
+
+bool JsonReader::Read(std::string &value)
+{
+    if (Next() != Token::String)
+    {
+        return false;
+    }
+    value = text;
+    return true;
+}
+
+bool JsonReader::Read(float &value)
+{
+    if (Next() != Token::Number)
+    {
+        return false;
+    }
+    auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+    return result.ec == std::errc{};
+}
+
+bool JsonReader::Read(uint64_t &value)
+{
+    if (Next() != Token::Number)
+    {
+        return false;
+    }
+    auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+    return result.ec == std::errc{};
+}
+
+bool JsonReader::Read(bool &value)
+{
+    Token token = Next();
+    value = token == Token::True;
+    return token == Token::True || token == Token::False;
+}
+
+bool JsonReader::Read(Vector3 &value)
+{
+    return Next() == Token::BeginArray &&
+        Read(value.x) && Read(value.y) && Read(value.z) &&
+        Next() == Token::EndArray;
+}
+
+bool JsonReader::Read(Vector4 &value)
+{
+    return Next() == Token::BeginArray &&
+        Read(value.x) && Read(value.y) && Read(value.z) && Read(value.w) &&
+        Next() == Token::EndArray;
+}
+
+}
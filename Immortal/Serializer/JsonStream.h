@@ -0,0 +1,303 @@
+#pragma once
+
+#include "Core.h"
+
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Immortal
+{
+
+/*
+ * @brief Writes JSON straight to a file through a fixed buffer, one value at a time, so
+ *  the memory it takes does not depend on how much is written. Containers down to
+ *  lineDepth put each element on a line of its own, deeper ones stay on the line of
+ *  their parent, which keeps diffs of the output down to what changed.
+ */
+class JsonWriter
+{
+public:
+    static constexpr size_t BufferSize = 64 * 1024;
+
+public:
+    JsonWriter(const std::string &filepath, size_t lineDepth = 1);
+
+    ~JsonWriter();
+
+    JsonWriter(const JsonWriter &) = delete;
+
+    JsonWriter &operator=(const JsonWriter &) = delete;
+
+    explicit operator bool() const
+    {
+        return file && !failed;
+    }
+
+    void BeginObject();
+
+    void EndObject();
+
+    void BeginArray();
+
+    void EndArray();
+
+    void Key(std::string_view key);
+
+    void Value(std::string_view value);
+
+    void Value(const char *value)
+    {
+        Value(std::string_view{ value ? value : "" });
+    }
+
+    void Value(float value);
+
+    void Value(uint64_t value);
+
+    void Value(bool value);
+
+    void Value(const Vector3 &value);
+
+    void Value(const Vector4 &value);
+
+    /*
+     * @brief Write out what is left in the buffer. Returns whether everything made it to the file.
+     */
+    bool Flush();
+
+    /*
+     * @brief Bytes written so far, buffered or not.
+     */
+    uint64_t Size() const
+    {
+        return size;
+    }
+
+private:
+    void Separate();
+
+    void Begin(char bracket);
+
+    void End(char bracket);
+
+    void Put(char c)
+    {
+        if (used == BufferSize)
+        {
+            Drain();
+        }
+        buffer[used++] = c;
+        size++;
+    }
+
+    void Put(std::string_view text);
+
+    void PutString(std::string_view text);
+
+    void Drain();
+
+private:
+    FILE *file{ nullptr };
+
+    std::unique_ptr<char[]> buffer;
+
+    size_t used{ 0 };
+
+    uint64_t size{ 0 };
+
+    size_t lineDepth;
+
+    /* One bit per open container: whether it has no element yet */
+    std::vector<bool> empty;
+
+    /* The value that follows a key goes on the same line */
+    bool keyed{ false };
+
+    bool failed{ false };
+};
+
+/*
+ * @brief Reads JSON from a file one token at a time through a fixed buffer, without ever
+ *  building a tree, so the memory it takes is bounded by the longest string of the file.
+ *  The caller walks the structure as the tokens come in with Members and Elements, and
+ *  skips whatever it does not know. Commas and colons are taken as whitespace.
+ */
+class JsonReader
+{
+public:
+    static constexpr size_t BufferSize = 64 * 1024;
+
+    enum class Token
+    {
+        BeginObject,
+        EndObject,
+        BeginArray,
+        EndArray,
+        String,
+        Number,
+        True,
+        False,
+        Null,
+        End,
+        Error
+    };
+
+public:
+    JsonReader(const std::string &filepath);
+
+    ~JsonReader();
+
+    JsonReader(const JsonReader &) = delete;
+
+    JsonReader &operator=(const JsonReader &) = delete;
+
+    explicit operator bool() const
+    {
+        return file != nullptr;
+    }
+
+    Token Next();
+
+    Token Peek();
+
+    /*
+     * @brief The unescaped text of the last String, or the literal of the last Number.
+     */
+    const std::string &Text() const
+    {
+        return text;
+    }
+
+    /*
+     * @brief Call member with the key of every member of the object that comes next. It
+     *  has to consume the value, i.e. with Read or Skip.
+     */
+    template <class Callback>
+    bool Members(Callback &&member)
+    {
+        if (Next() != Token::BeginObject)
+        {
+            return false;
+        }
+        while (true)
+        {
+            Token token = Next();
+            if (token == Token::EndObject)
+            {
+                return true;
+            }
+            if (token != Token::String)
+            {
+                return false;
+            }
+            std::string key = text;
+            if (!member(key))
+            {
+                return false;
+            }
+        }
+    }
+
+    /*
+     * @brief Call element for every element of the array that comes next. It has to
+     *  consume the element.
+     */
+    template <class Callback>
+    bool Elements(Callback &&element)
+    {
+        if (Next() != Token::BeginArray)
+        {
+            return false;
+        }
+        while (true)
+        {
+            Token token = Peek();
+            if (token == Token::EndArray)
+            {
+                Next();
+                return true;
+            }
+            if (token == Token::End || token == Token::Error || !element())
+            {
+                return false;
+            }
+        }
+    }
+
+    /*
+     * @brief Consume the next value, however deep it goes.
+     */
+    bool Skip();
+
+    bool Read(std::string &value);
+
+    bool Read(float &value);
+
+    bool Read(uint64_t &value);
+
+    bool Read(bool &value);
+
+    bool Read(Vector3 &value);
+
+    bool Read(Vector4 &value);
+
+    /*
+     * @brief Bytes read from the file so far.
+     */
+    uint64_t Size() const
+    {
+        return size;
+    }
+
+    /*
+     * @brief The line the reader is at, for error messages.
+     */
+    uint64_t Line() const
+    {
+        return line;
+    }
+
+private:
+    int Get()
+    {
+        if (position == available && !Fill())
+        {
+            return EOF;
+        }
+        return static_cast<unsigned char>(buffer[position++]);
+    }
+
+    bool Fill();
+
+    Token Scan();
+
+    Token ScanString();
+
+    Token ScanLiteral(int first);
+
+    bool ScanEscape();
+
+private:
+    FILE *file{ nullptr };
+
+    std::unique_ptr<char[]> buffer;
+
+    size_t position{ 0 };
+
+    size_t available{ 0 };
+
+    uint64_t size{ 0 };
+
+    uint64_t line{ 1 };
+
+    std::string text;
+
+    Token peeked;
+
+    bool hasPeeked{ false };
+};
+
+}
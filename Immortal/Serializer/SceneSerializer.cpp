@@ -2,11 +2,1956 @@
 #include "SceneSerializer.h"
 
 #include <fstream>
+#include <iterator>
 #include "Scene/Object.h"
+#include "Scene/GameObject.h"
+#include "Framework/FlatHashMap.h"
+#include "Framework/MappedFile.h"
+#include "Framework/Timer.h"
+#include "JsonStream.h"
 
 namespace Immortal
 {
 
+/*
+ * @brief The binary scene format. A header, the directory of the chunks, the string and
+ *  asset tables, then one chunk per component type: the slots of the objects that have
+ *  one and their components, back to back. Every block starts aligned, so a mapped file
+ *  is read in place. The slots are left out when they are just 0, 1, 2..., which is the
+ *  case for most pools. Strings and assets are referred to by their index in the tables.
+ *
+ *  Saving only what changed appends a delta to the file, laid out the same way with its
+ *  offsets from where it starts. Its objects are the ones changed, whose components all
+ *  come along, then the ones they only refer to, which come with just their ID. A chunk
+ *  of UIDs lists the objects destroyed. Loading applies the deltas in order over the
+ *  base, and saving everything again folds them back in.
+ */
+namespace Binary
+{
+
+/* "ISCN" */
+static constexpr uint32_t Magic = 0x4E435349;
+
+/* "ISCD" */
+static constexpr uint32_t DeltaMagic = 0x44435349;
+
+static constexpr uint32_t Version = 2;
+
+/* Deltas a file takes before it is saved whole again, so loading never has many to apply */
+static constexpr uint32_t MaxDeltas = 32;
+
+static constexpr uint64_t Alignment = 16;
+
+/* No object, no string, no asset */
+static constexpr uint32_t None = ~0u;
+
+/* Stable across builds, unlike the type ids of entt */
+enum class ChunkType : uint32_t
+{
+	ID,
+	Transform,
+	Relationship,
+	Tag,
+	Mesh,
+	Material,
+	Light,
+	Scene,
+	SpriteRenderer,
+	Camera,
+	DirectionalLight,
+	Script,
+	NativeScript,
+	ColorMixing,
+	Removed
+};
+
+enum class AssetType : uint32_t
+{
+	Texture,
+	Mesh
+};
+
+struct Header
+{
+	uint32_t Magic;
+	uint32_t Version;
+	uint64_t Objects;
+	uint32_t Chunks;
+	uint32_t Strings;
+	uint32_t Assets;
+	uint32_t Referenced;
+	uint64_t Directory;
+	uint64_t StringTable;
+	uint64_t StringData;
+	uint64_t AssetTable;
+	uint64_t Size;
+};
+
+struct Chunk
+{
+	uint32_t Type;
+	uint32_t Stride;
+	uint64_t Count;
+	uint64_t Slots;
+	uint64_t Data;
+};
+
+struct String
+{
+	uint64_t Offset;
+	uint64_t Size;
+};
+
+struct Asset
+{
+	AssetType Type;
+	uint32_t Path;
+};
+
+/* Without the cached matrices, they are rebuilt on the next UpdateTransforms */
+struct TransformRecord
+{
+	Vector3 Position;
+	Vector3 Rotation;
+	Vector3 Scale;
+};
+
+struct RelationshipRecord
+{
+	uint32_t Parent;
+	uint32_t First;
+	uint32_t Previous;
+	uint32_t Next;
+	uint64_t Children;
+};
+
+struct MaterialRecord
+{
+	Vector3 AlbedoColor;
+	float Metalness;
+	float Roughness;
+	uint32_t AlbedoMap;
+	uint32_t NormalMap;
+	uint32_t MetalnessMap;
+	uint32_t RoughnessMap;
+};
+
+struct SpriteRecord
+{
+	uint32_t Texture;
+	Vector4 Color;
+	float TilingFactor;
+};
+
+struct CameraRecord
+{
+	uint32_t Type;
+	float PerspectiveFOV;
+	float PerspectiveNear;
+	float PerspectiveFar;
+	float OrthographicSize;
+	float OrthographicNear;
+	float OrthographicFar;
+	uint32_t Primary;
+};
+
+static inline uint64_t Align(uint64_t offset)
+{
+	return (offset + Alignment - 1) & ~(Alignment - 1);
+}
+
+}
+
+static inline size_t EntityIndex(entt::entity e)
+{
+	using Traits = entt::entt_traits<std::underlying_type_t<entt::entity>>;
+	return size_t(entt::to_integral(e) & Traits::entity_mask);
+}
+
+template <class... Components>
+struct ComponentList
+{
+	template <class Callback>
+	static void Each(Callback &&callback)
+	{
+		(callback(static_cast<Components *>(nullptr)), ...);
+	}
+};
+
+/*
+ * @brief How a component is written to and read from its chunk. Plain data is its own
+ *  record and goes through as it lies in the pool, the rest is turned into a record
+ *  that refers to strings, assets and objects by index.
+ */
+template <class T>
+struct Codec;
+
+/*
+ * @brief An iterator over the results of a function applied to another one, for inserting
+ *  whole pools straight from the records of a chunk without a vector in between.
+ */
+template <class It, class Function>
+class MapIterator
+{
+public:
+	using iterator_category = std::forward_iterator_tag;
+	using value_type        = std::decay_t<std::invoke_result_t<const Function &, decltype(*std::declval<It>())>>;
+	using difference_type   = std::ptrdiff_t;
+	using pointer           = void;
+	using reference         = value_type;
+
+public:
+	MapIterator(It it, const Function &function) :
+		it{ it }, function{ &function }
+	{
+
+	}
+
+	value_type operator*() const
+	{
+		return (*function)(*it);
+	}
+
+	MapIterator &operator++()
+	{
+		++it;
+		return *this;
+	}
+
+	MapIterator operator++(int)
+	{
+		MapIterator copy = *this;
+		++it;
+		return copy;
+	}
+
+	bool operator==(const MapIterator &other) const
+	{
+		return it == other.it;
+	}
+
+	bool operator!=(const MapIterator &other) const
+	{
+		return it != other.it;
+	}
+
+private:
+	It it;
+
+	const Function *function;
+};
+
+class BinaryWriter
+{
+public:
+	struct Block
+	{
+		Binary::Chunk Chunk;
+		std::vector<uint32_t> Slots;
+		std::vector<uint8_t> Data;
+	};
+
+public:
+	/*
+	 * @brief Objects are the entities with an ID. They get their slots in the order of the
+	 *  transform pool, the largest one, so that its chunk goes without a slot list.
+	 */
+	BinaryWriter(entt::registry &registry) :
+		registry{ registry }
+	{
+		slots.assign(registry.size(), Binary::None);
+
+		auto assign = [&](entt::entity o) {
+			auto &slot = slots[EntityIndex(o)];
+			if (slot == Binary::None)
+			{
+				slot = objects++;
+			}
+		};
+
+		auto transforms = registry.view<TransformComponent>();
+		for (size_t i = 0; i < transforms.size(); i++)
+		{
+			if (registry.has<IDComponent>(transforms.data()[i]))
+			{
+				assign(transforms.data()[i]);
+			}
+		}
+
+		auto ids = registry.view<IDComponent>();
+		for (size_t i = 0; i < ids.size(); i++)
+		{
+			assign(ids.data()[i]);
+		}
+		written = objects;
+	}
+
+	/*
+	 * @brief A delta of the objects changed, the ones destroyed since or without an ID left
+	 *  out, then the objects they link to. Nothing here is the size of the scene, the slots
+	 *  are kept in a hash map instead.
+	 */
+	BinaryWriter(entt::registry &registry, const std::vector<entt::entity> &changed) :
+		registry{ registry },
+		delta{ true }
+	{
+		auto assign = [&](entt::entity o) {
+			auto [slot, inserted] = deltaSlots.Emplace(uint32_t(EntityIndex(o)), objects);
+			if (inserted)
+			{
+				entities.emplace_back(o);
+				objects++;
+			}
+		};
+
+		for (auto o : changed)
+		{
+			if (registry.valid(o) && registry.has<IDComponent>(o))
+			{
+				assign(o);
+			}
+		}
+		written = objects;
+
+		for (uint32_t i = 0; i < written; i++)
+		{
+			if (auto relationship = registry.try_get<RelationshipComponent>(entities[i]))
+			{
+				for (auto link : { relationship->Parent, relationship->First, relationship->Previous, relationship->Next })
+				{
+					if (link != entt::null)
+					{
+						assign(link);
+					}
+				}
+			}
+		}
+	}
+
+	uint32_t Slot(entt::entity o) const
+	{
+		if (o == entt::null)
+		{
+			return Binary::None;
+		}
+		size_t index = EntityIndex(o);
+		if (delta)
+		{
+			auto slot = deltaSlots.Find(uint32_t(index));
+			return slot ? *slot : Binary::None;
+		}
+		return index < slots.size() ? slots[index] : Binary::None;
+	}
+
+	uint32_t String(const std::string &string)
+	{
+		auto [index, inserted] = stringIndices.Emplace(string, uint32_t(strings.size()));
+		if (inserted)
+		{
+			strings.emplace_back(Binary::String{ stringData.size(), string.size() });
+			stringData.append(string);
+		}
+		return *index;
+	}
+
+	/*
+	 * @brief Textures are saved by path. The ones without, like the white texture everything
+	 *  starts out with, come back as the white texture.
+	 */
+	uint32_t Texture(Handle<Immortal::Texture> texture)
+	{
+		auto resource = texture.Get();
+		if (!resource || !resource->Path())
+		{
+			return Binary::None;
+		}
+		return Asset(textureIndices, texture.Value(), Binary::AssetType::Texture, resource->Path());
+	}
+
+	uint32_t Mesh(Handle<Immortal::Mesh> mesh)
+	{
+		auto resource = mesh.Get();
+		if (!resource || resource->Path().empty())
+		{
+			return Binary::None;
+		}
+		return Asset(meshIndices, mesh.Value(), Binary::AssetType::Mesh, resource->Path());
+	}
+
+	/*
+	 * @brief The chunk of a component type, in the order of its pool, or of the slots for a
+	 *  delta. Every object of a delta has its ID written, the ones only linked to nothing else.
+	 */
+	template <class T>
+	void Write()
+	{
+		using Record = typename Codec<T>::Record;
+
+		auto view = registry.view<T>();
+		if (view.empty())
+		{
+			return;
+		}
+
+		size_t bound = !delta ? view.size() : std::is_same_v<T, IDComponent> ? objects : written;
+
+		Block block{};
+		block.Slots.reserve(bound);
+		block.Data.resize(bound * sizeof(Record));
+
+		bool sequential = true;
+		auto add = [&](uint32_t slot, const T &component) {
+			sequential &= slot == block.Slots.size();
+			Record record = Codec<T>::Encode(component, *this);
+			memcpy(block.Data.data() + block.Slots.size() * sizeof(Record), &record, sizeof(Record));
+			block.Slots.emplace_back(slot);
+		};
+
+		if (delta)
+		{
+			for (uint32_t slot = 0; slot < bound; slot++)
+			{
+				if (auto component = registry.try_get<T>(entities[slot]))
+				{
+					add(slot, *component);
+				}
+			}
+		}
+		else
+		{
+			auto components = view.raw();
+			for (size_t i = 0; i < view.size(); i++)
+			{
+				uint32_t slot = Slot(view.data()[i]);
+				if (slot != Binary::None)
+				{
+					add(slot, components[i]);
+				}
+			}
+		}
+
+		size_t count = block.Slots.size();
+		if (!count)
+		{
+			return;
+		}
+		block.Data.resize(count * sizeof(Record));
+		if (sequential)
+		{
+			block.Slots.clear();
+		}
+
+		block.Chunk.Type   = uint32_t(Codec<T>::Type);
+		block.Chunk.Stride = uint32_t(sizeof(Record));
+		block.Chunk.Count  = count;
+		blocks.emplace_back(std::move(block));
+	}
+
+	/*
+	 * @brief The chunk of the objects destroyed, by UID.
+	 */
+	void Remove(const std::vector<uint64_t> &uids)
+	{
+		if (uids.empty())
+		{
+			return;
+		}
+
+		Block block{};
+		block.Data.resize(uids.size() * sizeof(uint64_t));
+		memcpy(block.Data.data(), uids.data(), block.Data.size());
+
+		block.Chunk.Type   = uint32_t(Binary::ChunkType::Removed);
+		block.Chunk.Stride = uint32_t(sizeof(uint64_t));
+		block.Chunk.Count  = uids.size();
+		blocks.emplace_back(std::move(block));
+	}
+
+	/*
+	 * @brief Write the scene to the file, or a delta to its end, starting aligned.
+	 */
+	bool Save(const std::string &filepath)
+	{
+		Binary::Header header{};
+		header.Magic      = delta ? Binary::DeltaMagic : Binary::Magic;
+		header.Version    = Binary::Version;
+		header.Objects    = objects;
+		header.Chunks     = uint32_t(blocks.size());
+		header.Strings    = uint32_t(strings.size());
+		header.Assets     = uint32_t(assets.size());
+		header.Referenced = objects - written;
+
+		uint64_t offset = sizeof(Binary::Header);
+		header.Directory   = Binary::Align(offset);
+		offset             = header.Directory + blocks.size() * sizeof(Binary::Chunk);
+		header.StringTable = Binary::Align(offset);
+		offset             = header.StringTable + strings.size() * sizeof(Binary::String);
+		header.AssetTable  = Binary::Align(offset);
+		offset             = header.AssetTable + assets.size() * sizeof(Binary::Asset);
+		for (auto &block : blocks)
+		{
+			if (!block.Slots.empty())
+			{
+				block.Chunk.Slots = Binary::Align(offset);
+				offset = block.Chunk.Slots + block.Slots.size() * sizeof(uint32_t);
+			}
+			block.Chunk.Data = Binary::Align(offset);
+			offset = block.Chunk.Data + block.Data.size();
+		}
+		header.StringData = Binary::Align(offset);
+		header.Size       = header.StringData + stringData.size();
+
+		std::fstream stream{ filepath, std::ios::binary | std::ios::out | (delta ? std::ios::in : std::ios::trunc) };
+		if (!stream)
+		{
+			return false;
+		}
+
+		static const char zeros[Binary::Alignment]{};
+		if (delta)
+		{
+			stream.seekp(0, std::ios::end);
+			uint64_t end = uint64_t(stream.tellp());
+			stream.write(zeros, std::streamsize(Binary::Align(end) - end));
+		}
+
+		uint64_t position = 0;
+		auto write = [&](uint64_t at, const void *data, size_t size) {
+			stream.write(zeros, std::streamsize(at - position));
+			stream.write(reinterpret_cast<const char *>(data), std::streamsize(size));
+			position = at + size;
+		};
+
+		std::vector<Binary::Chunk> directory;
+		directory.reserve(blocks.size());
+		for (auto &block : blocks)
+		{
+			directory.emplace_back(block.Chunk);
+		}
+
+		write(0, &header, sizeof(header));
+		write(header.Directory, directory.data(), directory.size() * sizeof(Binary::Chunk));
+		write(header.StringTable, strings.data(), strings.size() * sizeof(Binary::String));
+		write(header.AssetTable, assets.data(), assets.size() * sizeof(Binary::Asset));
+		for (auto &block : blocks)
+		{
+			if (!block.Slots.empty())
+			{
+				write(block.Chunk.Slots, block.Slots.data(), block.Slots.size() * sizeof(uint32_t));
+			}
+			write(block.Chunk.Data, block.Data.data(), block.Data.size());
+		}
+		write(header.StringData, stringData.data(), stringData.size());
+
+		return bool(stream);
+	}
+
+	uint32_t Objects() const
+	{
+		return objects;
+	}
+
+	/*
+	 * @brief The objects written with their components, the rest of a delta is only linked to.
+	 */
+	uint32_t Written() const
+	{
+		return written;
+	}
+
+private:
+	uint32_t Asset(FlatHashMap<uint32_t, uint32_t> &indices, uint32_t handle, Binary::AssetType type, const std::string &path)
+	{
+		auto [index, inserted] = indices.Emplace(handle, uint32_t(assets.size()));
+		if (inserted)
+		{
+			assets.emplace_back(Binary::Asset{ type, String(path) });
+		}
+		return *index;
+	}
+
+private:
+	entt::registry &registry;
+
+	bool delta{ false };
+
+	std::vector<uint32_t> slots;
+
+	FlatHashMap<uint32_t, uint32_t> deltaSlots;
+
+	/* The object of each slot of a delta */
+	std::vector<entt::entity> entities;
+
+	uint32_t objects{ 0 };
+
+	uint32_t written{ 0 };
+
+	std::vector<Block> blocks;
+
+	FlatHashMap<std::string, uint32_t> stringIndices;
+
+	std::vector<Binary::String> strings;
+
+	std::string stringData;
+
+	FlatHashMap<uint32_t, uint32_t> textureIndices;
+
+	FlatHashMap<uint32_t, uint32_t> meshIndices;
+
+	std::vector<Binary::Asset> assets;
+};
+
+/*
+ * @brief The assets loaded so far by path, shared by the base of a file and its deltas so
+ *  that each is only loaded once.
+ */
+struct AssetCache
+{
+	FlatHashMap<std::string, Handle<Immortal::Texture>> Textures;
+	FlatHashMap<std::string, Handle<Immortal::Mesh>> Meshes;
+};
+
+class BinaryReader
+{
+public:
+	/*
+	 * @brief Reads the base of the file, or the delta that starts at origin.
+	 */
+	BinaryReader(const MappedFile &file, AssetCache &cache, uint64_t origin = 0) :
+		file{ file },
+		cache{ cache },
+		origin{ origin }
+	{
+
+	}
+
+	/*
+	 * @brief Check every offset, size and index the loading goes by, so that a broken file
+	 *  is turned down before the scene is touched.
+	 */
+	template <class Components>
+	bool Validate(uint32_t magic = Binary::Magic)
+	{
+		header = At<Binary::Header>(0);
+		if (!header || header->Magic != magic || header->Version != Binary::Version)
+		{
+			LOG::WARN("Not a scene of version {0}", Binary::Version);
+			return false;
+		}
+
+		directory = At<Binary::Chunk>(header->Directory, header->Chunks);
+		strings   = At<Binary::String>(header->StringTable, header->Strings);
+		assets    = At<Binary::Asset>(header->AssetTable, header->Assets);
+
+		/* Every object takes up at least its ID, more of them than bytes is a broken count */
+		uint64_t size = file.Size() - origin;
+		if (!directory || !strings || !assets || header->Size > size || header->Objects > header->Size ||
+			header->Referenced > header->Objects || header->StringData > header->Size)
+		{
+			LOG::WARN("The tables of the scene are out of the file");
+			return false;
+		}
+
+		uint64_t stringData = header->Size - header->StringData;
+		for (uint32_t i = 0; i < header->Strings; i++)
+		{
+			if (strings[i].Offset > stringData || strings[i].Size > stringData - strings[i].Offset)
+			{
+				LOG::WARN("String {0} is out of the file", i);
+				return false;
+			}
+		}
+
+		for (uint32_t i = 0; i < header->Chunks; i++)
+		{
+			auto &chunk = directory[i];
+			bool known = false;
+			bool valid = true;
+			Components::Each([&](auto *type) {
+				using T      = std::remove_pointer_t<decltype(type)>;
+				using Record = typename Codec<T>::Record;
+				if (chunk.Type != uint32_t(Codec<T>::Type))
+				{
+					return;
+				}
+				uint64_t bound = std::is_same_v<T, IDComponent> ? header->Objects : header->Objects - header->Referenced;
+				known = true;
+				valid = chunk.Stride == sizeof(Record) && chunk.Count <= bound && At<Record>(chunk.Data, chunk.Count);
+			});
+			if (chunk.Type == uint32_t(Binary::ChunkType::Removed))
+			{
+				known = true;
+				valid = magic == Binary::DeltaMagic && chunk.Stride == sizeof(uint64_t) && !chunk.Slots && At<uint64_t>(chunk.Data, chunk.Count);
+			}
+			if (!known)
+			{
+				LOG::WARN("Skipping chunk of unknown type {0}", chunk.Type);
+				continue;
+			}
+			if (!valid || (chunk.Slots && !ValidSlots(chunk)))
+			{
+				LOG::WARN("Chunk of type {0} is broken or was saved by an incompatible build", chunk.Type);
+				return false;
+			}
+		}
+
+		/* The objects of a delta are found by their UIDs, so every one of them needs its ID */
+		if (magic == Binary::DeltaMagic && header->Objects && !UIDs())
+		{
+			LOG::WARN("The IDs of the objects of a delta are missing");
+			return false;
+		}
+
+		return true;
+	}
+
+	/*
+	 * @brief Load every asset once, however many components refer to it.
+	 */
+	void Resolve()
+	{
+		white = Render::Preset()->WhiteTextureHandle;
+		textures.resize(header->Assets, white);
+		meshes.resize(header->Assets);
+		for (uint32_t i = 0; i < header->Assets; i++)
+		{
+			std::string path = String(assets[i].Path);
+			if (path.empty())
+			{
+				continue;
+			}
+			if (assets[i].Type == Binary::AssetType::Texture)
+			{
+				auto [texture, inserted] = cache.Textures.Emplace(path, white);
+				if (inserted)
+				{
+					*texture = Handle<Immortal::Texture>{ std::shared_ptr<Immortal::Texture>{ Render::Create<Immortal::Texture>(path) } };
+				}
+				textures[i] = *texture;
+			}
+			else if (assets[i].Type == Binary::AssetType::Mesh)
+			{
+				auto [mesh, inserted] = cache.Meshes.Emplace(path, Handle<Immortal::Mesh>{});
+				if (inserted)
+				{
+					*mesh = Handle<Immortal::Mesh>{ std::make_shared<Immortal::Mesh>(path) };
+				}
+				meshes[i] = *mesh;
+			}
+		}
+	}
+
+	/*
+	 * @brief Create every object in one go, then fill the pools one chunk at a time.
+	 */
+	template <class Components>
+	void Load(entt::registry &registry)
+	{
+		objects.resize(header->Objects);
+		registry.create(objects.begin(), objects.end());
+
+		for (uint32_t i = 0; i < header->Chunks; i++)
+		{
+			Components::Each([&](auto *type) {
+				using T = std::remove_pointer_t<decltype(type)>;
+				if (directory[i].Type == uint32_t(Codec<T>::Type))
+				{
+					Read<T>(registry, directory[i]);
+				}
+			});
+		}
+	}
+
+	/*
+	 * @brief Apply a delta. The objects it destroys go first, then each object it has, found
+	 *  by UID or created, drops its components for the ones of the delta. The objects it
+	 *  only links to are looked up. A removed object is detached from its parent before it
+	 *  goes, but not from its children: they are removed as well or were moved elsewhere,
+	 *  which the delta has their links for.
+	 */
+	template <class Components>
+	void Apply(Scene &scene)
+	{
+		auto &registry = scene.Registry();
+
+		for (uint32_t i = 0; i < header->Chunks; i++)
+		{
+			auto &chunk = directory[i];
+			if (chunk.Type != uint32_t(Binary::ChunkType::Removed))
+			{
+				continue;
+			}
+			auto uids = At<uint64_t>(chunk.Data, chunk.Count);
+			for (uint64_t k = 0; k < chunk.Count; k++)
+			{
+				entt::entity o = scene.FindObjectByUID(uids[k]);
+				if (o != entt::null)
+				{
+					if (registry.has<RelationshipComponent>(o))
+					{
+						Object object{ o, &scene };
+						scene.SetParent(object, Object{});
+					}
+					registry.destroy(o);
+				}
+			}
+		}
+
+		auto ids = UIDs();
+		uint64_t written = header->Objects - header->Referenced;
+		objects.resize(header->Objects);
+		for (uint64_t slot = 0; slot < header->Objects; slot++)
+		{
+			entt::entity o = scene.FindObjectByUID(ids[slot].uid);
+			if (slot >= written)
+			{
+				objects[slot] = o;
+				continue;
+			}
+			if (o == entt::null)
+			{
+				o = registry.create();
+				registry.emplace<IDComponent>(o, ids[slot]);
+			}
+			else
+			{
+				Components::Each([&](auto *type) {
+					using T = std::remove_pointer_t<decltype(type)>;
+					if constexpr (!std::is_same_v<T, IDComponent>)
+					{
+						registry.remove_if_exists<T>(o);
+					}
+				});
+			}
+			objects[slot] = o;
+		}
+
+		for (uint32_t i = 0; i < header->Chunks; i++)
+		{
+			Components::Each([&](auto *type) {
+				using T = std::remove_pointer_t<decltype(type)>;
+				if constexpr (!std::is_same_v<T, IDComponent>)
+				{
+					if (directory[i].Type == uint32_t(Codec<T>::Type))
+					{
+						Read<T>(registry, directory[i]);
+					}
+				}
+			});
+		}
+	}
+
+	entt::entity Object(uint32_t slot) const
+	{
+		return slot < objects.size() ? objects[slot] : entt::null;
+	}
+
+	std::string String(uint32_t index) const
+	{
+		if (index >= header->Strings)
+		{
+			return std::string{};
+		}
+		auto &string = strings[index];
+		return std::string{ reinterpret_cast<const char *>(file.Data() + origin + header->StringData + string.Offset), size_t(string.Size) };
+	}
+
+	Handle<Immortal::Texture> Texture(uint32_t index) const
+	{
+		return index < textures.size() ? textures[index] : white;
+	}
+
+	Handle<Immortal::Mesh> Mesh(uint32_t index) const
+	{
+		return index < meshes.size() ? meshes[index] : Handle<Immortal::Mesh>{};
+	}
+
+	uint64_t Objects() const
+	{
+		return header->Objects;
+	}
+
+	/*
+	 * @brief Bytes from the origin to the end of the base or the delta.
+	 */
+	uint64_t Size() const
+	{
+		return header->Size;
+	}
+
+private:
+	template <class T>
+	const T *At(uint64_t offset, uint64_t count = 1) const
+	{
+		return offset <= file.Size() - origin ? file.At<T>(origin + offset, count) : nullptr;
+	}
+
+	/*
+	 * @brief The ID of every object in order, nullptr if the chunk is not there. A chunk
+	 *  with slots has some missing.
+	 */
+	const IDComponent *UIDs() const
+	{
+		for (uint32_t i = 0; i < header->Chunks; i++)
+		{
+			auto &chunk = directory[i];
+			if (chunk.Type == uint32_t(Binary::ChunkType::ID) && !chunk.Slots && chunk.Count == header->Objects)
+			{
+				return At<IDComponent>(chunk.Data, chunk.Count);
+			}
+		}
+		return nullptr;
+	}
+
+	/*
+	 * @brief Slots of components only go to objects that are written, not to the ones a
+	 *  delta only links to.
+	 */
+	bool ValidSlots(const Binary::Chunk &chunk) const
+	{
+		auto slots = At<uint32_t>(chunk.Slots, chunk.Count);
+		if (!slots)
+		{
+			return false;
+		}
+		for (uint64_t i = 0; i < chunk.Count; i++)
+		{
+			if (slots[i] >= header->Objects - header->Referenced)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	/*
+	 * @brief Insert the whole pool at once. Plain data goes from the mapped file to the pool
+	 *  in one copy, the rest is decoded on the way in.
+	 */
+	template <class T>
+	void Read(entt::registry &registry, const Binary::Chunk &chunk)
+	{
+		using Record = typename Codec<T>::Record;
+
+		const Record *first = At<Record>(chunk.Data, chunk.Count);
+		const Record *last  = first + chunk.Count;
+
+		auto insert = [&](auto entities, auto end) {
+			if constexpr (std::is_same_v<Record, T>)
+			{
+				registry.insert<T>(entities, end, first, last);
+			}
+			else
+			{
+				auto decode = [this](const Record &record) -> T {
+					return Codec<T>::Decode(record, *this);
+				};
+				registry.insert<T>(entities, end, MapIterator{ first, decode }, MapIterator{ last, decode });
+			}
+		};
+
+		if (!chunk.Slots)
+		{
+			insert(objects.data(), objects.data() + chunk.Count);
+		}
+		else
+		{
+			auto slots = At<uint32_t>(chunk.Slots, chunk.Count);
+			auto object = [this](uint32_t slot) -> entt::entity {
+				return objects[slot];
+			};
+			insert(MapIterator{ slots, object }, MapIterator{ slots + chunk.Count, object });
+		}
+	}
+
+private:
+	const MappedFile &file;
+
+	AssetCache &cache;
+
+	uint64_t origin;
+
+	const Binary::Header *header{ nullptr };
+
+	const Binary::Chunk *directory{ nullptr };
+
+	const Binary::String *strings{ nullptr };
+
+	const Binary::Asset *assets{ nullptr };
+
+	std::vector<entt::entity> objects;
+
+	Handle<Immortal::Texture> white;
+
+	std::vector<Handle<Immortal::Texture>> textures;
+
+	std::vector<Handle<Immortal::Mesh>> meshes;
+};
+
+template <class T, Binary::ChunkType U>
+struct PlainCodec
+{
+	static_assert(std::is_trivially_copyable_v<T>, "Only plain data goes through as it is");
+
+	static constexpr Binary::ChunkType Type = U;
+
+	using Record = T;
+
+	static Record Encode(const T &component, BinaryWriter &writer)
+	{
+		return component;
+	}
+};
+
+template <>
+struct Codec<IDComponent> : PlainCodec<IDComponent, Binary::ChunkType::ID> {};
+
+template <>
+struct Codec<LightComponent> : PlainCodec<LightComponent, Binary::ChunkType::Light> {};
+
+template <>
+struct Codec<SceneComponent> : PlainCodec<SceneComponent, Binary::ChunkType::Scene> {};
+
+template <>
+struct Codec<DirectionalLightComponent> : PlainCodec<DirectionalLightComponent, Binary::ChunkType::DirectionalLight> {};
+
+template <>
+struct Codec<ColorMixingComponent> : PlainCodec<ColorMixingComponent, Binary::ChunkType::ColorMixing> {};
+
+template <>
+struct Codec<TransformComponent>
+{
+	static constexpr Binary::ChunkType Type = Binary::ChunkType::Transform;
+
+	using Record = Binary::TransformRecord;
+
+	static Record Encode(const TransformComponent &transform, BinaryWriter &writer)
+	{
+		return Record{ transform.Position, transform.Rotation, transform.Scale };
+	}
+
+	static TransformComponent Decode(const Record &record, const BinaryReader &reader)
+	{
+		TransformComponent transform;
+		transform.Set(record.Position, record.Rotation, record.Scale);
+		return transform;
+	}
+};
+
+template <>
+struct Codec<RelationshipComponent>
+{
+	static constexpr Binary::ChunkType Type = Binary::ChunkType::Relationship;
+
+	using Record = Binary::RelationshipRecord;
+
+	static Record Encode(const RelationshipComponent &relationship, BinaryWriter &writer)
+	{
+		return Record{
+			writer.Slot(relationship.Parent),
+			writer.Slot(relationship.First),
+			writer.Slot(relationship.Previous),
+			writer.Slot(relationship.Next),
+			relationship.Children
+		};
+	}
+
+	static RelationshipComponent Decode(const Record &record, const BinaryReader &reader)
+	{
+		RelationshipComponent relationship;
+		relationship.Parent   = reader.Object(record.Parent);
+		relationship.First    = reader.Object(record.First);
+		relationship.Previous = reader.Object(record.Previous);
+		relationship.Next     = reader.Object(record.Next);
+		relationship.Children = size_t(record.Children);
+		return relationship;
+	}
+};
+
+template <>
+struct Codec<TagComponent>
+{
+	static constexpr Binary::ChunkType Type = Binary::ChunkType::Tag;
+
+	using Record = uint32_t;
+
+	static Record Encode(const TagComponent &tag, BinaryWriter &writer)
+	{
+		return writer.String(tag.Tag);
+	}
+
+	static TagComponent Decode(const Record &record, const BinaryReader &reader)
+	{
+		return TagComponent{ reader.String(record) };
+	}
+};
+
+template <>
+struct Codec<ScriptComponent>
+{
+	static constexpr Binary::ChunkType Type = Binary::ChunkType::Script;
+
+	using Record = uint32_t;
+
+	static Record Encode(const ScriptComponent &script, BinaryWriter &writer)
+	{
+		return writer.String(script.Name);
+	}
+
+	static ScriptComponent Decode(const Record &record, const BinaryReader &reader)
+	{
+		return ScriptComponent{ reader.String(record) };
+	}
+};
+
+/* Only the module, it is loaded again when the scene runs */
+template <>
+struct Codec<NativeScriptComponent>
+{
+	static constexpr Binary::ChunkType Type = Binary::ChunkType::NativeScript;
+
+	using Record = uint32_t;
+
+	static Record Encode(const NativeScriptComponent &script, BinaryWriter &writer)
+	{
+		return writer.String(script.Module);
+	}
+
+	static NativeScriptComponent Decode(const Record &record, const BinaryReader &reader)
+	{
+		return NativeScriptComponent{ reader.String(record) };
+	}
+};
+
+template <>
+struct Codec<MeshComponent>
+{
+	static constexpr Binary::ChunkType Type = Binary::ChunkType::Mesh;
+
+	using Record = uint32_t;
+
+	static Record Encode(const MeshComponent &mesh, BinaryWriter &writer)
+	{
+		return writer.Mesh(mesh.Mesh);
+	}
+
+	static MeshComponent Decode(const Record &record, const BinaryReader &reader)
+	{
+		return MeshComponent{ reader.Mesh(record) };
+	}
+};
+
+template <>
+struct Codec<MaterialComponent>
+{
+	static constexpr Binary::ChunkType Type = Binary::ChunkType::Material;
+
+	using Record = Binary::MaterialRecord;
+
+	static Record Encode(const MaterialComponent &material, BinaryWriter &writer)
+	{
+		return Record{
+			material.AlbedoColor,
+			material.Metalness,
+			material.Roughness,
+			writer.Texture(material.AlbedoMap),
+			writer.Texture(material.NormalMap),
+			writer.Texture(material.MetalnessMap),
+			writer.Texture(material.RoughnessMap)
+		};
+	}
+
+	static MaterialComponent Decode(const Record &record, const BinaryReader &reader)
+	{
+		MaterialComponent material;
+		material.AlbedoColor  = record.AlbedoColor;
+		material.Metalness    = record.Metalness;
+		material.Roughness    = record.Roughness;
+		material.AlbedoMap    = reader.Texture(record.AlbedoMap);
+		material.NormalMap    = reader.Texture(record.NormalMap);
+		material.MetalnessMap = reader.Texture(record.MetalnessMap);
+		material.RoughnessMap = reader.Texture(record.RoughnessMap);
+		return material;
+	}
+};
+
+template <>
+struct Codec<SpriteRendererComponent>
+{
+	static constexpr Binary::ChunkType Type = Binary::ChunkType::SpriteRenderer;
+
+	using Record = Binary::SpriteRecord;
+
+	static Record Encode(const SpriteRendererComponent &sprite, BinaryWriter &writer)
+	{
+		return Record{ writer.Texture(sprite.Texture), sprite.Color, sprite.TilingFactor };
+	}
+
+	static SpriteRendererComponent Decode(const Record &record, const BinaryReader &reader)
+	{
+		SpriteRendererComponent sprite{ reader.Texture(record.Texture), record.Color };
+		sprite.TilingFactor = record.TilingFactor;
+		return sprite;
+	}
+};
+
+/* The projection is not saved, it is built again for the viewport it ends up in */
+template <>
+struct Codec<CameraComponent>
+{
+	static constexpr Binary::ChunkType Type = Binary::ChunkType::Camera;
+
+	using Record = Binary::CameraRecord;
+
+	static Record Encode(const CameraComponent &camera, BinaryWriter &writer)
+	{
+		auto &c = camera.Camera;
+		return Record{
+			uint32_t(c.Type()),
+			c.PerspectiveFOV(),
+			c.PerspectiveNearClip(),
+			c.PerspectiveFarClip(),
+			c.OrthographicSize(),
+			c.OrthographicNearClip(),
+			c.OrthographicFarClip(),
+			uint32_t(camera.Primary)
+		};
+	}
+
+	static CameraComponent Decode(const Record &record, const BinaryReader &reader)
+	{
+		CameraComponent camera;
+		auto &c = camera.Camera;
+		c.SetProjectionType(SceneCamera::ProjectionType(record.Type));
+		c.SetPerspectiveFOV(record.PerspectiveFOV);
+		c.SetPerspectiveNearClip(record.PerspectiveNear);
+		c.SetPerspectiveFarClip(record.PerspectiveFar);
+		c.SetOrthographicSize(record.OrthographicSize);
+		c.SetOrthographicNearClip(record.OrthographicNear);
+		c.SetOrthographicFarClip(record.OrthographicFar);
+		camera.Primary = record.Primary != 0;
+		return camera;
+	}
+};
+
+/*
+ * @brief Everything saved along with a scene. Filters and the meta pointer are not, they
+ *  have no fixed size and no meaning outside of the running process respectively.
+ */
+using SerializedComponents = ComponentList<
+	IDComponent,
+	TransformComponent,
+	RelationshipComponent,
+	TagComponent,
+	MeshComponent,
+	MaterialComponent,
+	LightComponent,
+	SceneComponent,
+	SpriteRendererComponent,
+	CameraComponent,
+	DirectionalLightComponent,
+	ScriptComponent,
+	NativeScriptComponent,
+	ColorMixingComponent
+>;
+
+/*
+ * @brief Everything a snapshot copies, which has to be every component an object can
+ *  have: the pools are emptied one by one on restore, not entity by entity.
+ */
+using RuntimeComponents = ComponentList<
+	IDComponent,
+	TransformComponent,
+	RelationshipComponent,
+	TagComponent,
+	MeshComponent,
+	MaterialComponent,
+	LightComponent,
+	SceneComponent,
+	SpriteRendererComponent,
+	CameraComponent,
+	DirectionalLightComponent,
+	ScriptComponent,
+	NativeScriptComponent,
+	MetaComponent,
+	ColorMixingComponent,
+	FilterComponent
+>;
+
+/*
+ * @brief What a restored object gets of a component of the snapshot. A plain copy, but for
+ *  native scripts, whose instance is shared by the copies and the one of play mode once
+ *  it starts. They come back unloaded, without one.
+ */
+template <class T>
+static inline T Restored(const T &component)
+{
+	return component;
+}
+
+static inline NativeScriptComponent Restored(const NativeScriptComponent &component)
+{
+	return NativeScriptComponent{ component.Module };
+}
+
+/*
+ * @brief Count the resources a component of the snapshot refers to, or give the counts
+ *  up, so whatever play mode destroys the last user of is still there to restore.
+ */
+template <class T>
+static inline void CountResources(const T &, bool)
+{
+
+}
+
+template <class T>
+static inline void Count(Handle<T> handle, bool retain)
+{
+	auto &table = ResourceTable<T>::Instance();
+	retain ? table.Retain(handle) : table.Release(handle);
+}
+
+static inline void CountResources(const SpriteRendererComponent &component, bool retain)
+{
+	Count(component.Texture, retain);
+}
+
+static inline void CountResources(const MeshComponent &component, bool retain)
+{
+	Count(component.Mesh, retain);
+}
+
+static inline void CountResources(const MaterialComponent &component, bool retain)
+{
+	Count(component.AlbedoMap, retain);
+	Count(component.NormalMap, retain);
+	Count(component.MetalnessMap, retain);
+	Count(component.RoughnessMap, retain);
+}
+
+/*
+ * @brief One pool as it lies in the registry, packed order included, so that the transforms
+ *  come back sorted the way the hierarchy had them.
+ */
+template <class T>
+class SnapshotPool : public SceneSnapshot::Pool
+{
+public:
+	SnapshotPool(entt::registry &registry)
+	{
+		auto view = registry.view<T>();
+		entities.assign(view.data(), view.data() + view.size());
+		components.assign(view.raw(), view.raw() + view.size());
+		for (auto &component : components)
+		{
+			CountResources(component, true);
+		}
+	}
+
+	virtual ~SnapshotPool() override
+	{
+		for (auto &component : components)
+		{
+			CountResources(component, false);
+		}
+	}
+
+	virtual void Restore(entt::registry &registry) const override
+	{
+		auto restored = [](const T &component) -> T { return Restored(component); };
+		registry.insert<T>(entities.begin(), entities.end(), MapIterator{ components.begin(), restored }, MapIterator{ components.end(), restored });
+	}
+
+private:
+	std::vector<entt::entity> entities;
+
+	std::vector<T> components;
+};
+
+/* The version of the text format */
+static constexpr uint64_t TextVersion = 1;
+
+/*
+ * @brief What the text codecs share while a scene is written or read. Objects refer to
+ *  each other by UID and to assets by path. The links of the hierarchy are only resolved
+ *  once every object is there.
+ */
+class TextContext
+{
+public:
+	struct Links
+	{
+		entt::entity Object;
+		uint64_t Parent;
+		uint64_t First;
+		uint64_t Previous;
+		uint64_t Next;
+	};
+
+public:
+	TextContext(Scene &scene) :
+		scene{ scene },
+		registry{ scene.Registry() }
+	{
+
+	}
+
+	uint64_t UID(entt::entity o) const
+	{
+		auto id = o == entt::null ? nullptr : registry.try_get<IDComponent>(o);
+		return id ? id->uid : 0;
+	}
+
+	std::string_view Path(Handle<Immortal::Texture> texture) const
+	{
+		auto resource = texture.Get();
+		return resource && resource->Path() ? resource->Path() : std::string_view{};
+	}
+
+	std::string_view Path(Handle<Immortal::Mesh> mesh) const
+	{
+		auto resource = mesh.Get();
+		return resource ? std::string_view{ resource->Path() } : std::string_view{};
+	}
+
+	/*
+	 * @brief Every path is loaded once, however many components refer to it. Textures
+	 *  without one are the white texture.
+	 */
+	Handle<Immortal::Texture> Texture(const std::string &path)
+	{
+		if (path.empty())
+		{
+			return Render::Preset()->WhiteTextureHandle;
+		}
+		auto [texture, inserted] = textures.Emplace(path);
+		if (inserted)
+		{
+			*texture = Handle<Immortal::Texture>{ std::shared_ptr<Immortal::Texture>{ Render::Create<Immortal::Texture>(path) } };
+		}
+		return *texture;
+	}
+
+	Handle<Immortal::Mesh> Mesh(const std::string &path)
+	{
+		if (path.empty())
+		{
+			return Handle<Immortal::Mesh>{};
+		}
+		auto [mesh, inserted] = meshes.Emplace(path);
+		if (inserted)
+		{
+			*mesh = Handle<Immortal::Mesh>{ std::make_shared<Immortal::Mesh>(path) };
+		}
+		return *mesh;
+	}
+
+	void Link(const Links &links)
+	{
+		pending.emplace_back(links);
+	}
+
+	void Resolve()
+	{
+		for (auto &links : pending)
+		{
+			auto relationship = registry.try_get<RelationshipComponent>(links.Object);
+			if (!relationship)
+			{
+				continue;
+			}
+			relationship->Parent   = Find(links.Parent);
+			relationship->First    = Find(links.First);
+			relationship->Previous = Find(links.Previous);
+			relationship->Next     = Find(links.Next);
+		}
+		pending.clear();
+	}
+
+public:
+	/* The object being read */
+	entt::entity Object{ entt::null };
+
+private:
+	entt::entity Find(uint64_t uid)
+	{
+		return uid ? entt::entity(scene.FindObjectByUID(uid)) : entt::null;
+	}
+
+private:
+	Scene &scene;
+
+	entt::registry &registry;
+
+	FlatHashMap<std::string, Handle<Immortal::Texture>> textures;
+
+	FlatHashMap<std::string, Handle<Immortal::Mesh>> meshes;
+
+	std::vector<Links> pending;
+};
+
+/*
+ * @brief How a component is written to and read from the text format, as the value of a
+ *  member of its object named after it.
+ */
+template <class T>
+struct TextCodec;
+
+/*
+ * @brief Components that are a JSON object with a member per field, where every field is
+ *  a plain value. The codec lists them once in Fields, for either direction.
+ */
+template <class T>
+struct FieldCodec
+{
+	static void Write(JsonWriter &writer, const T &component, TextContext &context)
+	{
+		writer.BeginObject();
+		TextCodec<T>::Fields(component, [&](const char *name, const auto &value) {
+			writer.Key(name);
+			writer.Value(value);
+		});
+		writer.EndObject();
+	}
+
+	/* Members it does not know, i.e. from a newer build, are skipped */
+	static bool Read(JsonReader &reader, T &component, TextContext &context)
+	{
+		return reader.Members([&](const std::string &key) -> bool {
+			bool found = false;
+			bool read  = true;
+			TextCodec<T>::Fields(component, [&](const char *name, auto &value) {
+				if (!found && key == name)
+				{
+					found = true;
+					read  = reader.Read(value);
+				}
+			});
+			return found ? read : reader.Skip();
+		});
+	}
+};
+
+/*
+ * @brief Components without anything to save but their presence.
+ */
+template <class T>
+struct EmptyCodec
+{
+	static void Write(JsonWriter &writer, const T &component, TextContext &context)
+	{
+		writer.BeginObject();
+		writer.EndObject();
+	}
+
+	static bool Read(JsonReader &reader, T &component, TextContext &context)
+	{
+		return reader.Skip();
+	}
+};
+
+template <>
+struct TextCodec<IDComponent>
+{
+	static constexpr const char *Name = "ID";
+
+	static void Write(JsonWriter &writer, const IDComponent &id, TextContext &context)
+	{
+		writer.Value(id.uid);
+	}
+
+	static bool Read(JsonReader &reader, IDComponent &id, TextContext &context)
+	{
+		return reader.Read(id.uid);
+	}
+};
+
+template <>
+struct TextCodec<TagComponent>
+{
+	static constexpr const char *Name = "Tag";
+
+	static void Write(JsonWriter &writer, const TagComponent &tag, TextContext &context)
+	{
+		writer.Value(tag.Tag);
+	}
+
+	static bool Read(JsonReader &reader, TagComponent &tag, TextContext &context)
+	{
+		return reader.Read(tag.Tag);
+	}
+};
+
+template <>
+struct TextCodec<ScriptComponent>
+{
+	static constexpr const char *Name = "Script";
+
+	static void Write(JsonWriter &writer, const ScriptComponent &script, TextContext &context)
+	{
+		writer.Value(script.Name);
+	}
+
+	static bool Read(JsonReader &reader, ScriptComponent &script, TextContext &context)
+	{
+		return reader.Read(script.Name);
+	}
+};
+
+template <>
+struct TextCodec<NativeScriptComponent>
+{
+	static constexpr const char *Name = "NativeScript";
+
+	static void Write(JsonWriter &writer, const NativeScriptComponent &script, TextContext &context)
+	{
+		writer.Value(script.Module);
+	}
+
+	static bool Read(JsonReader &reader, NativeScriptComponent &script, TextContext &context)
+	{
+		return reader.Read(script.Module);
+	}
+};
+
+template <>
+struct TextCodec<MeshComponent>
+{
+	static constexpr const char *Name = "Mesh";
+
+	static void Write(JsonWriter &writer, const MeshComponent &mesh, TextContext &context)
+	{
+		writer.Value(context.Path(mesh.Mesh));
+	}
+
+	static bool Read(JsonReader &reader, MeshComponent &mesh, TextContext &context)
+	{
+		std::string path;
+		if (!reader.Read(path))
+		{
+			return false;
+		}
+		mesh.Mesh = context.Mesh(path);
+		return true;
+	}
+};
+
+template <>
+struct TextCodec<TransformComponent> : FieldCodec<TransformComponent>
+{
+	static constexpr const char *Name = "Transform";
+
+	template <class Component, class Visitor>
+	static void Fields(Component &transform, Visitor &&field)
+	{
+		field("Position", transform.Position);
+		field("Rotation", transform.Rotation);
+		field("Scale",    transform.Scale);
+	}
+};
+
+template <>
+struct TextCodec<DirectionalLightComponent> : FieldCodec<DirectionalLightComponent>
+{
+	static constexpr const char *Name = "DirectionalLight";
+
+	template <class Component, class Visitor>
+	static void Fields(Component &light, Visitor &&field)
+	{
+		field("Radiance",    light.Radiance);
+		field("Intensity",   light.Intensity);
+		field("CastShadows", light.CastShadows);
+		field("SoftShadows", light.SoftShadows);
+		field("LightSize",   light.LightSize);
+	}
+};
+
+template <>
+struct TextCodec<ColorMixingComponent> : FieldCodec<ColorMixingComponent>
+{
+	static constexpr const char *Name = "ColorMixing";
+
+	template <class Component, class Visitor>
+	static void Fields(Component &mixing, Visitor &&field)
+	{
+		field("RGBA",             mixing.RGBA);
+		field("HSL",              mixing.HSL);
+		field("ColorTemperature", mixing.WhiteBalance.ColorTemperature);
+		field("Hue",              mixing.WhiteBalance.Hue);
+		field("White",            mixing.Gradation.White);
+		field("Black",            mixing.Gradation.Black);
+		field("Exposure",         mixing.Exposure);
+		field("Contrast",         mixing.Contrast);
+		field("Hightlights",      mixing.Hightlights);
+		field("Shadow",           mixing.Shadow);
+		field("Vividness",        mixing.Vividness);
+	}
+};
+
+template <>
+struct TextCodec<LightComponent> : EmptyCodec<LightComponent>
+{
+	static constexpr const char *Name = "Light";
+};
+
+template <>
+struct TextCodec<SceneComponent> : EmptyCodec<SceneComponent>
+{
+	static constexpr const char *Name = "Scene";
+};
+
+template <>
+struct TextCodec<RelationshipComponent>
+{
+	static constexpr const char *Name = "Relationship";
+
+	static void Write(JsonWriter &writer, const RelationshipComponent &relationship, TextContext &context)
+	{
+		writer.BeginObject();
+		writer.Key("Parent");
+		writer.Value(context.UID(relationship.Parent));
+		writer.Key("First");
+		writer.Value(context.UID(relationship.First));
+		writer.Key("Previous");
+		writer.Value(context.UID(relationship.Previous));
+		writer.Key("Next");
+		writer.Value(context.UID(relationship.Next));
+		writer.Key("Children");
+		writer.Value(uint64_t(relationship.Children));
+		writer.EndObject();
+	}
+
+	static bool Read(JsonReader &reader, RelationshipComponent &relationship, TextContext &context)
+	{
+		TextContext::Links links{ context.Object, 0, 0, 0, 0 };
+		uint64_t children = 0;
+		bool read = reader.Members([&](const std::string &key) -> bool {
+			if (key == "Parent")
+			{
+				return reader.Read(links.Parent);
+			}
+			if (key == "First")
+			{
+				return reader.Read(links.First);
+			}
+			if (key == "Previous")
+			{
+				return reader.Read(links.Previous);
+			}
+			if (key == "Next")
+			{
+				return reader.Read(links.Next);
+			}
+			if (key == "Children")
+			{
+				return reader.Read(children);
+			}
+			return reader.Skip();
+		});
+		relationship.Children = size_t(children);
+		context.Link(links);
+		return read;
+	}
+};
+
+template <>
+struct TextCodec<MaterialComponent>
+{
+	static constexpr const char *Name = "Material";
+
+	static void Write(JsonWriter &writer, const MaterialComponent &material, TextContext &context)
+	{
+		writer.BeginObject();
+		writer.Key("AlbedoColor");
+		writer.Value(material.AlbedoColor);
+		writer.Key("Metalness");
+		writer.Value(material.Metalness);
+		writer.Key("Roughness");
+		writer.Value(material.Roughness);
+		writer.Key("AlbedoMap");
+		writer.Value(context.Path(material.AlbedoMap));
+		writer.Key("NormalMap");
+		writer.Value(context.Path(material.NormalMap));
+		writer.Key("MetalnessMap");
+		writer.Value(context.Path(material.MetalnessMap));
+		writer.Key("RoughnessMap");
+		writer.Value(context.Path(material.RoughnessMap));
+		writer.EndObject();
+	}
+
+	static bool Read(JsonReader &reader, MaterialComponent &material, TextContext &context)
+	{
+		auto map = [&](Handle<Immortal::Texture> &texture) -> bool {
+			std::string path;
+			if (!reader.Read(path))
+			{
+				return false;
+			}
+			texture = context.Texture(path);
+			return true;
+		};
+
+		return reader.Members([&](const std::string &key) -> bool {
+			if (key == "AlbedoColor")
+			{
+				return reader.Read(material.AlbedoColor);
+			}
+			if (key == "Metalness")
+			{
+				return reader.Read(material.Metalness);
+			}
+			if (key == "Roughness")
+			{
+				return reader.Read(material.Roughness);
+			}
+			if (key == "AlbedoMap")
+			{
+				return map(material.AlbedoMap);
+			}
+			if (key == "NormalMap")
+			{
+				return map(material.NormalMap);
+			}
+			if (key == "MetalnessMap")
+			{
+				return map(material.MetalnessMap);
+			}
+			if (key == "RoughnessMap")
+			{
+				return map(material.RoughnessMap);
+			}
+			return reader.Skip();
+		});
+	}
+};
+
+template <>
+struct TextCodec<SpriteRendererComponent>
+{
+	static constexpr const char *Name = "SpriteRenderer";
+
+	static void Write(JsonWriter &writer, const SpriteRendererComponent &sprite, TextContext &context)
+	{
+		writer.BeginObject();
+		writer.Key("Texture");
+		writer.Value(context.Path(sprite.Texture));
+		writer.Key("Color");
+		writer.Value(sprite.Color);
+		writer.Key("TilingFactor");
+		writer.Value(sprite.TilingFactor);
+		writer.EndObject();
+	}
+
+	static bool Read(JsonReader &reader, SpriteRendererComponent &sprite, TextContext &context)
+	{
+		return reader.Members([&](const std::string &key) -> bool {
+			if (key == "Texture")
+			{
+				std::string path;
+				if (!reader.Read(path))
+				{
+					return false;
+				}
+				sprite.Texture = context.Texture(path);
+				return true;
+			}
+			if (key == "Color")
+			{
+				return reader.Read(sprite.Color);
+			}
+			if (key == "TilingFactor")
+			{
+				return reader.Read(sprite.TilingFactor);
+			}
+			return reader.Skip();
+		});
+	}
+};
+
+template <>
+struct TextCodec<CameraComponent>
+{
+	static constexpr const char *Name = "Camera";
+
+	static void Write(JsonWriter &writer, const CameraComponent &camera, TextContext &context)
+	{
+		auto &c = camera.Camera;
+		writer.BeginObject();
+		writer.Key("Type");
+		writer.Value(c.Type() == SceneCamera::ProjectionType::Orthographic ? "Orthographic" : "Perspective");
+		writer.Key("PerspectiveFOV");
+		writer.Value(c.PerspectiveFOV());
+		writer.Key("PerspectiveNear");
+		writer.Value(c.PerspectiveNearClip());
+		writer.Key("PerspectiveFar");
+		writer.Value(c.PerspectiveFarClip());
+		writer.Key("OrthographicSize");
+		writer.Value(c.OrthographicSize());
+		writer.Key("OrthographicNear");
+		writer.Value(c.OrthographicNearClip());
+		writer.Key("OrthographicFar");
+		writer.Value(c.OrthographicFarClip());
+		writer.Key("Primary");
+		writer.Value(camera.Primary);
+		writer.EndObject();
+	}
+
+	static bool Read(JsonReader &reader, CameraComponent &camera, TextContext &context)
+	{
+		auto &c = camera.Camera;
+		auto set = [&](void (SceneCamera::*setter)(float)) -> bool {
+			float value;
+			if (!reader.Read(value))
+			{
+				return false;
+			}
+			(c.*setter)(value);
+			return true;
+		};
+
+		return reader.Members([&](const std::string &key) -> bool {
+			if (key == "Type")
+			{
+				std::string type;
+				if (!reader.Read(type))
+				{
+					return false;
+				}
+				c.SetProjectionType(type == "Orthographic" ? SceneCamera::ProjectionType::Orthographic : SceneCamera::ProjectionType::Perspective);
+				return true;
+			}
+			if (key == "PerspectiveFOV")
+			{
+				return set(&SceneCamera::SetPerspectiveFOV);
+			}
+			if (key == "PerspectiveNear")
+			{
+				return set(&SceneCamera::SetPerspectiveNearClip);
+			}
+			if (key == "PerspectiveFar")
+			{
+				return set(&SceneCamera::SetPerspectiveFarClip);
+			}
+			if (key == "OrthographicSize")
+			{
+				return set(&SceneCamera::SetOrthographicSize);
+			}
+			if (key == "OrthographicNear")
+			{
+				return set(&SceneCamera::SetOrthographicNearClip);
+			}
+			if (key == "OrthographicFar")
+			{
+				return set(&SceneCamera::SetOrthographicFarClip);
+			}
+			if (key == "Primary")
+			{
+				return reader.Read(camera.Primary);
+			}
+			return reader.Skip();
+		});
+	}
+};
 
 SceneSerializer::SceneSerializer(const std::shared_ptr<Scene> &scene)
 	: mScene(scene)
@@ -14,25 +1959,399 @@ SceneSerializer::SceneSerializer(const std::shared_ptr<Scene> &scene)
 
 }
 
+static inline bool IsText(const std::string &filepath)
+{
+	static const std::string extension = ".json";
+	return filepath.size() >= extension.size() && filepath.compare(filepath.size() - extension.size(), extension.size(), extension) == 0;
+}
+
 void SceneSerializer::Serialize(const std::string & filepath)
 {
-		
+	/* The registry belongs to the simulation while a frame is ahead */
+	mScene->Synchronize();
+
+	if (!(IsText(filepath) ? SerializeText(filepath) : SerializeBinary(filepath)))
+	{
+		LOG::WARN("Failed to write scene to {0}", filepath);
+		return;
+	}
+	mScene->ResetChanges(filepath);
+}
+
+/*
+ * @brief Whether another delta can go at the end of the file: it is a sound binary scene
+ *  with less than MaxDeltas deltas, which add up to less than the base. Only the headers
+ *  are read.
+ */
+static bool Appendable(const std::string &filepath)
+{
+	MappedFile file{ filepath };
+	auto base = file.At<Binary::Header>(0);
+	if (!base || base->Magic != Binary::Magic || base->Version != Binary::Version || base->Size > file.Size())
+	{
+		return false;
+	}
+
+	uint32_t deltas = 0;
+	for (uint64_t offset = Binary::Align(base->Size); offset < file.Size(); deltas++)
+	{
+		auto delta = file.At<Binary::Header>(offset);
+		if (!delta || delta->Magic != Binary::DeltaMagic || delta->Size > file.Size() - offset)
+		{
+			return false;
+		}
+		offset = Binary::Align(offset + delta->Size);
+	}
+
+	return deltas < Binary::MaxDeltas && file.Size() - base->Size < base->Size;
 }
 
-void SceneSerializer::SerializeRuntime(const std::string & filepath)
+void SceneSerializer::SerializeDelta(const std::string &filepath)
 {
-	SLASSERT(false && "SceneSerializer::SerializeRuntime: Not Implemented");
+	mScene->Synchronize();
+
+	/* Transforms written in place since the last frame only show up in the changes after an update */
+	mScene->UpdateTransforms();
+
+	auto &changes = mScene->Changes();
+	if (IsText(filepath) || changes.Baseline != filepath || !Appendable(filepath))
+	{
+		Serialize(filepath);
+		return;
+	}
+	if (changes.Changed.empty() && changes.Removed.empty())
+	{
+		return;
+	}
+
+	if (!SerializeChanges(filepath))
+	{
+		LOG::WARN("Failed to write the changes to {0}", filepath);
+		return;
+	}
+	mScene->ResetChanges(filepath);
 }
 
+/*
+ * @brief Only touches the objects changed, the file is opened to write at its end.
+ */
+bool SceneSerializer::SerializeChanges(const std::string &filepath)
+{
+	Timer timer;
+	timer.Start();
+
+	auto &changes = mScene->Changes();
+	BinaryWriter writer{ mScene->Registry(), changes.Changed };
+	writer.Remove(changes.Removed);
+	SerializedComponents::Each([&](auto *type) {
+		writer.Write<std::remove_pointer_t<decltype(type)>>();
+	});
+
+	if (!writer.Save(filepath))
+	{
+		return false;
+	}
+	LOG::INFO("Saved {0} changed and {1} destroyed objects to {2} in {3} ms", writer.Written(), changes.Removed.size(), filepath, timer.Stop());
+	return true;
+}
+
+bool SceneSerializer::SerializeBinary(const std::string &filepath)
+{
+	Timer timer;
+	timer.Start();
+
+	BinaryWriter writer{ mScene->Registry() };
+	SerializedComponents::Each([&](auto *type) {
+		writer.Write<std::remove_pointer_t<decltype(type)>>();
+	});
+
+	if (!writer.Save(filepath))
+	{
+		return false;
+	}
+	LOG::INFO("Saved {0} objects to {1} in {2} ms", writer.Objects(), filepath, timer.Stop());
+	return true;
+}
+
+/*
+ * @brief One object after the other, in the order of the ID pool, which only changes when
+ *  objects are destroyed, so that saving again gives a small diff. Every component goes
+ *  on a line of its own.
+ */
+bool SceneSerializer::SerializeText(const std::string &filepath)
+{
+	Timer timer;
+	timer.Start();
+
+	JsonWriter writer{ filepath, 3 };
+	if (!writer)
+	{
+		return false;
+	}
+
+	auto &registry = mScene->Registry();
+	TextContext context{ *mScene };
+	auto ids = registry.view<IDComponent>();
+
+	writer.BeginObject();
+	writer.Key("Version");
+	writer.Value(TextVersion);
+	writer.Key("Count");
+	writer.Value(uint64_t(ids.size()));
+	writer.Key("Objects");
+	writer.BeginArray();
+	for (size_t i = 0; i < ids.size(); i++)
+	{
+		entt::entity o = ids.data()[i];
+		writer.BeginObject();
+		SerializedComponents::Each([&](auto *type) {
+			using T = std::remove_pointer_t<decltype(type)>;
+			if (auto component = registry.try_get<T>(o))
+			{
+				writer.Key(TextCodec<T>::Name);
+				TextCodec<T>::Write(writer, *component, context);
+			}
+		});
+		writer.EndObject();
+	}
+	writer.EndArray();
+	writer.EndObject();
+
+	if (!writer.Flush())
+	{
+		return false;
+	}
+
+	double milliseconds = timer.Stop();
+	LOG::INFO("Saved {0} objects to {1} in {2} ms, {3} MB/s", ids.size(), filepath, milliseconds, writer.Size() / 1000.0 / std::max(milliseconds, 0.001));
+	return true;
+}
+
+std::unique_ptr<SceneSnapshot> SceneSerializer::SerializeRuntime()
+{
+	Timer timer;
+	timer.Start();
+
+	mScene->Synchronize();
+
+	auto &registry = mScene->Registry();
+	auto snapshot = std::make_unique<SceneSnapshot>();
+
+	/* All of the identifiers, the free ones too, for the versions to carry on where they were */
+	snapshot->entities.assign(registry.data(), registry.data() + registry.size());
+	snapshot->objects = registry.view<IDComponent>().size();
+
+	RuntimeComponents::Each([&](auto *type) {
+		using T = std::remove_pointer_t<decltype(type)>;
+		snapshot->pools.emplace_back(std::make_unique<SnapshotPool<T>>(registry));
+	});
+
+	LOG::INFO("Took a snapshot of {0} objects in {1} ms", snapshot->objects, timer.Stop());
+	return snapshot;
+}
+
+/*
+ * @brief Replace the objects of the scene with the ones of the file, which is either format.
+ */
 bool SceneSerializer::Deserialize(const std::string & filepath)
 {
-	return false;
+	MappedFile file{ filepath };
+	if (!file)
+	{
+		LOG::WARN("Failed to open scene {0}", filepath);
+		return false;
+	}
+
+	auto magic = file.At<uint32_t>(0);
+	bool loaded = magic && *magic == Binary::Magic ? DeserializeBinary(file, filepath) : DeserializeText(filepath);
+	if (!loaded)
+	{
+		LOG::WARN("Failed to load scene {0}", filepath);
+		return false;
+	}
+	mScene->ResetChanges(filepath);
+	return true;
+}
+
+void SceneSerializer::Clear()
+{
+	mScene->Synchronize();
+
+	auto &registry = mScene->Registry();
+	auto ids = registry.view<IDComponent>();
+	std::vector<entt::entity> objects{ ids.begin(), ids.end() };
+	mScene->DestroyObjects(objects);
+}
+
+/*
+ * @brief Nothing is parsed, the file is mapped and every pool is inserted in one go,
+ *  straight from its chunk. The deltas are applied over it after that, up to the first
+ *  one that is broken, i.e. cut off by a crash while it was written.
+ */
+bool SceneSerializer::DeserializeBinary(const MappedFile &file, const std::string &filepath)
+{
+	Timer timer;
+	timer.Start();
+
+	AssetCache cache;
+	BinaryReader reader{ file, cache };
+	if (!reader.Validate<SerializedComponents>())
+	{
+		return false;
+	}
+	reader.Resolve();
+
+	Clear();
+	mScene->Reserve(size_t(reader.Objects()));
+	reader.Load<SerializedComponents>(mScene->Registry());
+
+	size_t deltas = 0;
+	for (uint64_t offset = Binary::Align(reader.Size()); offset < file.Size(); deltas++)
+	{
+		BinaryReader delta{ file, cache, offset };
+		if (!delta.Validate<SerializedComponents>(Binary::DeltaMagic))
+		{
+			LOG::WARN("Leaving out the changes saved to {0} from byte {1} on, they are broken", filepath, offset);
+			break;
+		}
+		delta.Resolve();
+		delta.Apply<SerializedComponents>(*mScene);
+		offset = Binary::Align(offset + delta.Size());
+	}
+
+	LOG::INFO("Loaded {0} objects and {1} deltas from {2} in {3} ms", mScene->Registry().view<IDComponent>().size(), deltas, filepath, timer.Stop());
+	return true;
+}
+
+/*
+ * @brief Objects and components are created as their tokens come in, nothing but the
+ *  object being read is held on to. A file that breaks off halfway leaves the objects
+ *  read up to there.
+ */
+bool SceneSerializer::DeserializeText(const std::string &filepath)
+{
+	Timer timer;
+	timer.Start();
+
+	JsonReader reader{ filepath };
+	if (!reader || reader.Peek() != JsonReader::Token::BeginObject)
+	{
+		return false;
+	}
+
+	Clear();
+
+	auto &registry = mScene->Registry();
+	TextContext context{ *mScene };
+	size_t objects = 0;
+
+	auto object = [&]() -> bool {
+		entt::entity o = registry.create();
+		context.Object = o;
+		objects++;
+
+		bool read = reader.Members([&](const std::string &key) -> bool {
+			bool found = false;
+			bool read  = true;
+			SerializedComponents::Each([&](auto *type) {
+				using T = std::remove_pointer_t<decltype(type)>;
+				if (found || key != TextCodec<T>::Name)
+				{
+					return;
+				}
+				found = true;
+
+				T component;
+				read = TextCodec<T>::Read(reader, component, context);
+				if (read)
+				{
+					registry.emplace_or_replace<T>(o, std::move(component));
+				}
+			});
+			return found ? read : reader.Skip();
+		});
+
+		/* Every object has these, whether the file says so or not */
+		if (!registry.has<TransformComponent>(o))
+		{
+			registry.emplace<TransformComponent>(o);
+		}
+		if (!registry.has<IDComponent>(o))
+		{
+			registry.emplace<IDComponent>(o);
+		}
+		return read;
+	};
+
+	bool read = reader.Members([&](const std::string &key) -> bool {
+		if (key == "Version")
+		{
+			uint64_t version = 0;
+			if (!reader.Read(version) || version > TextVersion)
+			{
+				LOG::WARN("Scene text version {0} is newer than {1}", version, TextVersion);
+				return false;
+			}
+			return true;
+		}
+		if (key == "Count")
+		{
+			uint64_t count = 0;
+			if (!reader.Read(count))
+			{
+				return false;
+			}
+			mScene->Reserve(size_t(count));
+			registry.reserve<TransformComponent, IDComponent, TagComponent>(size_t(count));
+			return true;
+		}
+		if (key == "Objects")
+		{
+			return reader.Elements(object);
+		}
+		return reader.Skip();
+	});
+	context.Resolve();
+
+	if (!read)
+	{
+		LOG::WARN("Broken scene text at line {0} of {1}", reader.Line(), filepath);
+		return false;
+	}
+
+	double milliseconds = timer.Stop();
+	LOG::INFO("Loaded {0} objects from {1} in {2} ms, {3} MB/s", objects, filepath, milliseconds, reader.Size() / 1000.0 / std::max(milliseconds, 0.001));
+	return true;
 }
 
-bool SceneSerializer::DeserializeRuntime(const std::string & filepath)
+/*
+ * @brief Empty every pool in one go, hand the registry the identifiers of the snapshot and
+ *  insert the pools back. The indices of the scene follow through the usual signals.
+ */
+void SceneSerializer::DeserializeRuntime(const SceneSnapshot &snapshot)
 {
-	SLASSERT(false && "SceneSerializer::DeserializeRuntime: Not Implemented");
-	return false;
+	Timer timer;
+	timer.Start();
+
+	mScene->Synchronize();
+
+	/* Whatever play mode left queued refers to entities about to go */
+	mScene->ApplyCommands();
+
+	auto &registry = mScene->Registry();
+	RuntimeComponents::Each([&](auto *type) {
+		registry.clear<std::remove_pointer_t<decltype(type)>>();
+	});
+
+	registry.assign(snapshot.entities.begin(), snapshot.entities.end());
+	mScene->Reserve(snapshot.objects);
+
+	for (auto &pool : snapshot.pools)
+	{
+		pool->Restore(registry);
+	}
+
+	LOG::INFO("Restored a snapshot of {0} objects in {1} ms", snapshot.objects, timer.Stop());
 }
 
-}
\ No newline at end of file
+}
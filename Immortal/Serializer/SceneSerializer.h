@@ -7,17 +7,86 @@
 namespace Immortal
 {
 
+class MappedFile;
+
+/*
+ * @brief Every component pool of a scene copied into memory, with the ids of the entities
+ *  they belong to, i.e. to go back to the editor after play mode. Meshes and textures are
+ *  shared with the scene through their handles, only the components themselves are copied.
+ */
+class IMMORTAL_API SceneSnapshot
+{
+public:
+    struct Pool
+    {
+        virtual ~Pool() = default;
+
+        virtual void Restore(entt::registry &registry) const = 0;
+    };
+
+public:
+    /*
+     * @brief Objects in the snapshot.
+     */
+    size_t Size() const
+    {
+        return objects;
+    }
+
+private:
+    friend class SceneSerializer;
+
+    std::vector<entt::entity> entities;
+
+    std::vector<std::unique_ptr<Pool>> pools;
+
+    size_t objects{ 0 };
+};
+
 class IMMORTAL_API SceneSerializer
 {
 public:
     SceneSerializer(const std::shared_ptr<Scene> &scene);
     ~SceneSerializer() = default;
-        
+
+    /*
+     * @brief Save in the binary format, or as JSON, for source control, if the file ends
+     *  in .json. Loading tells the two apart by what is in the file.
+     */
     void Serialize(const std::string &filepath);
-    void SerializeRuntime(const std::string &filepath);
+
+    /*
+     * @brief Append what changed since the scene was last saved to or loaded from filepath
+     *  to its end, for autosaves that take as long as the edits, not the scene. Saves it
+     *  all again instead when filepath is another file or text, or when the deltas it
+     *  has taken add up to enough that loading would suffer.
+     */
+    void SerializeDelta(const std::string &filepath);
+
+    /*
+     * @brief Take a snapshot of the scene as it is, without going through a file, and put
+     *  it back later with the same entity ids, so that anything holding on to an entity
+     *  from before still finds it. The snapshot can be restored any number of times.
+     */
+    std::unique_ptr<SceneSnapshot> SerializeRuntime();
 
     bool Deserialize(const std::string &filepath);
-    bool DeserializeRuntime(const std::string& filepath);
+
+    void DeserializeRuntime(const SceneSnapshot &snapshot);
+
+private:
+    bool SerializeBinary(const std::string &filepath);
+
+    bool SerializeText(const std::string &filepath);
+
+    bool SerializeChanges(const std::string &filepath);
+
+    bool DeserializeBinary(const MappedFile &file, const std::string &filepath);
+
+    bool DeserializeText(const std::string &filepath);
+
+    /* Destroy the objects of the scene before loading others */
+    void Clear();
 
 private:
     std::shared_ptr<Scene> mScene;
@@ -0,0 +1,54 @@
+#include "impch.h"
+#include "Futex.h"
+
+#ifdef WINDOWS
+#pragma comment(lib, "Synchronization.lib")
+#else
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace Immortal
+{
+
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "The futex word has to be a plain 32-bit word");
+
+#ifdef WINDOWS
+void Futex::Wait(std::atomic<uint32_t> &word, uint32_t expected)
+{
+    WaitOnAddress(&word, &expected, sizeof(expected), INFINITE);
+}
+
+void Futex::WakeOne(std::atomic<uint32_t> &word)
+{
+    WakeByAddressSingle(&word);
+}
+
+void Futex::WakeAll(std::atomic<uint32_t> &word)
+{
+    WakeByAddressAll(&word);
+}
+#else
+static inline long Syscall(std::atomic<uint32_t> &word, int operation, uint32_t value)
+{
+    return syscall(SYS_futex, reinterpret_cast<uint32_t *>(&word), operation | FUTEX_PRIVATE_FLAG, value, nullptr, nullptr, 0);
+}
+
+void Futex::Wait(std::atomic<uint32_t> &word, uint32_t expected)
+{
+    Syscall(word, FUTEX_WAIT, expected);
+}
+
+void Futex::WakeOne(std::atomic<uint32_t> &word)
+{
+    Syscall(word, FUTEX_WAKE, 1);
+}
+
+void Futex::WakeAll(std::atomic<uint32_t> &word)
+{
+    Syscall(word, FUTEX_WAKE, INT32_MAX);
+}
+#endif
+
+}
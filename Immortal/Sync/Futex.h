@@ -0,0 +1,44 @@
+#pragma once
+
+#include "Core.h"
+
+#include <atomic>
+
+namespace Immortal
+{
+
+/*
+ * @brief Park threads directly on a 32-bit word. Backed by WaitOnAddress on Windows and
+ *  by futex on Linux, so nothing is allocated per waiter and an uncontended wake up
+ *  never enters the kernel as long as the caller keeps track of its sleepers.
+ */
+class IMMORTAL_API Futex
+{
+public:
+    /*
+     * @brief Block while the word still holds the expected value. Spurious returns are
+     *  allowed, callers always check their condition again in a loop.
+     */
+    static void Wait(std::atomic<uint32_t> &word, uint32_t expected);
+
+    static void WakeOne(std::atomic<uint32_t> &word);
+
+    static void WakeAll(std::atomic<uint32_t> &word);
+
+    /*
+     * @brief Tell the core that we are in a spin loop.
+     */
+    static inline void Pause()
+    {
+#if defined(_MSC_VER)
+        YieldProcessor();
+#elif defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#endif
+    }
+
+public:
+    static constexpr int SpinCount = 128;
+};
+
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include "Futex.h"
+
+namespace Immortal
+{
+
+/*
+ * @brief A single use count down. Threads waiting on it are released once the count
+ *  reaches zero, the count itself is the futex word.
+ */
+class Latch
+{
+public:
+    explicit Latch(uint32_t count) :
+        count{ count }
+    {
+
+    }
+
+    void CountDown(uint32_t n = 1)
+    {
+        if (count.fetch_sub(n, std::memory_order_acq_rel) == n)
+        {
+            Futex::WakeAll(count);
+        }
+    }
+
+    bool TryWait() const
+    {
+        return count.load(std::memory_order_acquire) == 0;
+    }
+
+    void Wait()
+    {
+        uint32_t value = count.load(std::memory_order_acquire);
+        for (int i = 0; value != 0 && i < Futex::SpinCount; i++)
+        {
+            Futex::Pause();
+            value = count.load(std::memory_order_acquire);
+        }
+        while (value != 0)
+        {
+            Futex::Wait(count, value);
+            value = count.load(std::memory_order_acquire);
+        }
+    }
+
+    void ArriveAndWait(uint32_t n = 1)
+    {
+        CountDown(n);
+        Wait();
+    }
+
+private:
+    std::atomic<uint32_t> count;
+};
+
+/*
+ * @brief A reusable rendezvous for a fixed number of threads. The last thread to arrive
+ *  opens the next phase and releases the others.
+ */
+class ThreadBarrier
+{
+public:
+    explicit ThreadBarrier(uint32_t count) :
+        expected{ count }
+    {
+
+    }
+
+    void ArriveAndWait()
+    {
+        uint32_t current = phase.load(std::memory_order_acquire);
+        if (arrived.fetch_add(1, std::memory_order_acq_rel) + 1 == expected)
+        {
+            arrived.store(0, std::memory_order_relaxed);
+            phase.fetch_add(1, std::memory_order_release);
+            Futex::WakeAll(phase);
+            return;
+        }
+
+        for (int i = 0; i < Futex::SpinCount; i++)
+        {
+            if (phase.load(std::memory_order_acquire) != current)
+            {
+                return;
+            }
+            Futex::Pause();
+        }
+        while (phase.load(std::memory_order_acquire) == current)
+        {
+            Futex::Wait(phase, current);
+        }
+    }
+
+private:
+    uint32_t expected;
+
+    std::atomic<uint32_t> arrived{ 0 };
+
+    std::atomic<uint32_t> phase{ 0 };
+};
+
+}
@@ -0,0 +1,168 @@
+#pragma once
+
+#include "Futex.h"
+
+namespace Immortal
+{
+
+/*
+ * @brief A mutex that spins for a short while before it parks. Most critical sections
+ *  of the engine are a handful of instructions, so the lock is usually released before
+ *  a sleep would even have started. The lowercase members make it work with
+ *  std::lock_guard and std::unique_lock.
+ */
+class Mutex
+{
+public:
+    enum State : uint32_t
+    {
+        Unlocked  = 0,
+        Locked    = 1,
+        Contended = 2
+    };
+
+public:
+    bool try_lock()
+    {
+        uint32_t expected = Unlocked;
+        return state.compare_exchange_strong(expected, Locked, std::memory_order_acquire, std::memory_order_relaxed);
+    }
+
+    void lock()
+    {
+        if (try_lock())
+        {
+            return;
+        }
+
+        for (int i = 0; i < Futex::SpinCount; i++)
+        {
+            if (state.load(std::memory_order_relaxed) == Unlocked && try_lock())
+            {
+                return;
+            }
+            Futex::Pause();
+        }
+
+        /* Whoever ends up owning the lock after a sleep has to assume there are sleepers left */
+        while (state.exchange(Contended, std::memory_order_acquire) != Unlocked)
+        {
+            Futex::Wait(state, Contended);
+        }
+    }
+
+    void unlock()
+    {
+        if (state.exchange(Unlocked, std::memory_order_release) == Contended)
+        {
+            Futex::WakeOne(state);
+        }
+    }
+
+private:
+    std::atomic<uint32_t> state{ Unlocked };
+};
+
+/*
+ * @brief A reader-writer lock for data that is read all the time and rarely changed,
+ *  like registries and asset tables. Readers only touch one atomic word. A waiting
+ *  writer holds off new readers, so writers could not be starved. The lowercase
+ *  members make it work with std::unique_lock and std::shared_lock.
+ */
+class RWLock
+{
+public:
+    static constexpr uint32_t Writer  = 1u << 31;
+    static constexpr uint32_t Parked  = 1u << 30;
+    static constexpr uint32_t Readers = Parked - 1;
+
+public:
+    void lock_shared()
+    {
+        for (int i = 0; ; i++)
+        {
+            uint32_t value = state.load(std::memory_order_relaxed);
+            if (!(value & Writer))
+            {
+                if (state.compare_exchange_weak(value, value + 1, std::memory_order_acquire, std::memory_order_relaxed))
+                {
+                    return;
+                }
+                continue;
+            }
+            if (i < Futex::SpinCount)
+            {
+                Futex::Pause();
+                continue;
+            }
+            if (!(value & Parked) && !state.compare_exchange_weak(value, value | Parked, std::memory_order_relaxed))
+            {
+                continue;
+            }
+            Futex::Wait(state, value | Parked);
+        }
+    }
+
+    bool try_lock_shared()
+    {
+        uint32_t value = state.load(std::memory_order_relaxed);
+        return !(value & Writer) && state.compare_exchange_strong(value, value + 1, std::memory_order_acquire, std::memory_order_relaxed);
+    }
+
+    void unlock_shared()
+    {
+        uint32_t value = state.fetch_sub(1, std::memory_order_release) - 1;
+        if ((value & Writer) && !(value & Readers))
+        {
+            /* The last reader out lets the waiting writer in */
+            Futex::WakeAll(state);
+        }
+    }
+
+    void lock()
+    {
+        writer.lock();
+        uint32_t value = state.fetch_or(Writer, std::memory_order_acquire) | Writer;
+        for (int i = 0; (value & Readers) && i < Futex::SpinCount; i++)
+        {
+            Futex::Pause();
+            value = state.load(std::memory_order_acquire);
+        }
+        while (value & Readers)
+        {
+            Futex::Wait(state, value);
+            value = state.load(std::memory_order_acquire);
+        }
+    }
+
+    bool try_lock()
+    {
+        if (!writer.try_lock())
+        {
+            return false;
+        }
+        uint32_t expected = state.load(std::memory_order_relaxed) & Parked;
+        if (state.compare_exchange_strong(expected, expected | Writer, std::memory_order_acquire, std::memory_order_relaxed))
+        {
+            return true;
+        }
+        writer.unlock();
+        return false;
+    }
+
+    void unlock()
+    {
+        if (state.fetch_and(~(Writer | Parked), std::memory_order_release) & Parked)
+        {
+            Futex::WakeAll(state);
+        }
+        writer.unlock();
+    }
+
+private:
+    std::atomic<uint32_t> state{ 0 };
+
+    Mutex writer;
+};
+
+}
@@ -0,0 +1,328 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <new>
+#include <type_traits>
+
+namespace Immortal
+{
+
+/*
+ * @brief Indices written by different threads are kept on their own cache lines, so the
+ *  producer and the consumer do not keep stealing the line from each other.
+ */
+static constexpr size_t CacheLineSize = 64;
+
+static inline size_t RoundUpToPowerOfTwo(size_t value)
+{
+    size_t result = 2;
+    while (result < value)
+    {
+        result <<= 1;
+    }
+    return result;
+}
+
+/*
+ * @brief Bounded single producer, single consumer ring. Each side keeps a private copy
+ *  of the other side's index and only reloads it when the ring looks full or empty.
+ */
+template <class T>
+class SPSCQueue
+{
+public:
+    using Storage = std::aligned_storage_t<sizeof(T), alignof(T)>;
+
+public:
+    explicit SPSCQueue(size_t capacity) :
+        mask{ RoundUpToPowerOfTwo(capacity) - 1 },
+        slots{ new Storage[mask + 1] }
+    {
+
+    }
+
+    ~SPSCQueue()
+    {
+        for (size_t i = head.load(std::memory_order_relaxed); i != tail.load(std::memory_order_relaxed); i++)
+        {
+            std::launder(reinterpret_cast<T *>(&slots[i & mask]))->~T();
+        }
+    }
+
+    SPSCQueue(const SPSCQueue &) = delete;
+
+    SPSCQueue &operator=(const SPSCQueue &) = delete;
+
+    template <class... Args>
+    bool Push(Args &&... args)
+    {
+        size_t position = tail.load(std::memory_order_relaxed);
+        if (position - headCache > mask)
+        {
+            headCache = head.load(std::memory_order_acquire);
+            if (position - headCache > mask)
+            {
+                return false;
+            }
+        }
+        new (&slots[position & mask]) T(std::forward<Args>(args)...);
+        tail.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool Pop(T &value)
+    {
+        size_t position = head.load(std::memory_order_relaxed);
+        if (position == tailCache)
+        {
+            tailCache = tail.load(std::memory_order_acquire);
+            if (position == tailCache)
+            {
+                return false;
+            }
+        }
+        T *slot = std::launder(reinterpret_cast<T *>(&slots[position & mask]));
+        value = std::move(*slot);
+        slot->~T();
+        head.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    size_t Capacity() const
+    {
+        return mask + 1;
+    }
+
+    /*
+     * @brief Only a snapshot while the other side is still running.
+     */
+    size_t Size() const
+    {
+        return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+    }
+
+private:
+    size_t mask;
+
+    std::unique_ptr<Storage[]> slots;
+
+    alignas(CacheLineSize) std::atomic<size_t> head{ 0 };
+
+    size_t tailCache{ 0 };
+
+    alignas(CacheLineSize) std::atomic<size_t> tail{ 0 };
+
+    size_t headCache{ 0 };
+};
+
+/*
+ * @brief Bounded multi producer, multi consumer ring (Dmitry Vyukov's design). Every
+ *  cell carries a sequence number telling whether it is ready to be written or read in
+ *  the current lap, so producers and consumers only contend on their own index.
+ */
+template <class T>
+class MPMCQueue
+{
+public:
+    struct alignas(CacheLineSize) Cell
+    {
+        std::atomic<size_t> sequence;
+        std::aligned_storage_t<sizeof(T), alignof(T)> storage;
+    };
+
+public:
+    explicit MPMCQueue(size_t capacity) :
+        mask{ RoundUpToPowerOfTwo(capacity) - 1 },
+        cells{ new Cell[mask + 1] }
+    {
+        for (size_t i = 0; i <= mask; i++)
+        {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    ~MPMCQueue()
+    {
+        for (size_t i = dequeuePosition.load(std::memory_order_relaxed); i != enqueuePosition.load(std::memory_order_relaxed); i++)
+        {
+            std::launder(reinterpret_cast<T *>(&cells[i & mask].storage))->~T();
+        }
+    }
+
+    MPMCQueue(const MPMCQueue &) = delete;
+
+    MPMCQueue &operator=(const MPMCQueue &) = delete;
+
+    template <class... Args>
+    bool Push(Args &&... args)
+    {
+        Cell *cell = nullptr;
+        size_t position = enqueuePosition.load(std::memory_order_relaxed);
+        while (true)
+        {
+            cell = &cells[position & mask];
+            size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            intptr_t difference = intptr_t(sequence) - intptr_t(position);
+            if (difference == 0)
+            {
+                if (enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+            else if (difference < 0)
+            {
+                return false;
+            }
+            else
+            {
+                position = enqueuePosition.load(std::memory_order_relaxed);
+            }
+        }
+        new (&cell->storage) T(std::forward<Args>(args)...);
+        cell->sequence.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool Pop(T &value)
+    {
+        Cell *cell = nullptr;
+        size_t position = dequeuePosition.load(std::memory_order_relaxed);
+        while (true)
+        {
+            cell = &cells[position & mask];
+            size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            intptr_t difference = intptr_t(sequence) - intptr_t(position + 1);
+            if (difference == 0)
+            {
+                if (dequeuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+            else if (difference < 0)
+            {
+                return false;
+            }
+            else
+            {
+                position = dequeuePosition.load(std::memory_order_relaxed);
+            }
+        }
+        T *slot = std::launder(reinterpret_cast<T *>(&cell->storage));
+        value = std::move(*slot);
+        slot->~T();
+        cell->sequence.store(position + mask + 1, std::memory_order_release);
+        return true;
+    }
+
+    size_t Capacity() const
+    {
+        return mask + 1;
+    }
+
+private:
+    size_t mask;
+
+    std::unique_ptr<Cell[]> cells;
+
+    alignas(CacheLineSize) std::atomic<size_t> enqueuePosition{ 0 };
+
+    alignas(CacheLineSize) std::atomic<size_t> dequeuePosition{ 0 };
+};
+
+/*
+ * @brief The link of an element of a MPSCQueue, to be derived from by the element type.
+ */
+struct MPSCNode
+{
+    std::atomic<MPSCNode *> next{ nullptr };
+};
+
+/*
+ * @brief Unbounded intrusive multi producer, single consumer queue (Dmitry Vyukov's
+ *  design). Push is a single exchange and never fails, nothing is allocated since the
+ *  link lives in the element. Pop could report empty for a moment while a producer is
+ *  between its two steps, the element shows up on the next Pop.
+ */
+template <class T>
+class MPSCQueue
+{
+public:
+    static_assert(std::is_base_of_v<MPSCNode, T>, "The element of a MPSCQueue has to derive from MPSCNode");
+
+public:
+    MPSCQueue() :
+        head{ &stub },
+        tail{ &stub }
+    {
+
+    }
+
+    MPSCQueue(const MPSCQueue &) = delete;
+
+    MPSCQueue &operator=(const MPSCQueue &) = delete;
+
+    void Push(T *element)
+    {
+        Link(element);
+    }
+
+    T *Pop()
+    {
+        MPSCNode *node = tail;
+        MPSCNode *next = node->next.load(std::memory_order_acquire);
+        if (node == &stub)
+        {
+            if (!next)
+            {
+                return nullptr;
+            }
+            tail = next;
+            node = next;
+            next = next->next.load(std::memory_order_acquire);
+        }
+        if (next)
+        {
+            tail = next;
+            return static_cast<T *>(node);
+        }
+        if (node != head.load(std::memory_order_acquire))
+        {
+            return nullptr;
+        }
+
+        /* The last element could only be handed out with the stub behind it */
+        Link(&stub);
+        next = node->next.load(std::memory_order_acquire);
+        if (next)
+        {
+            tail = next;
+            return static_cast<T *>(node);
+        }
+        return nullptr;
+    }
+
+    bool Empty() const
+    {
+        return tail == &stub && !stub.next.load(std::memory_order_acquire);
+    }
+
+private:
+    void Link(MPSCNode *node)
+    {
+        node->next.store(nullptr, std::memory_order_relaxed);
+        MPSCNode *previous = head.exchange(node, std::memory_order_acq_rel);
+        previous->next.store(node, std::memory_order_release);
+    }
+
+private:
+    alignas(CacheLineSize) std::atomic<MPSCNode *> head;
+
+    alignas(CacheLineSize) MPSCNode *tail;
+
+    MPSCNode stub;
+};
+
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "Futex.h"
+
+#include <cstring>
+#include <thread>
+#include <type_traits>
+
+namespace Immortal
+{
+
+/*
+ * @brief Publish a small value, e.g. per-frame statistics, to any number of readers
+ *  without ever blocking the writer. Readers retry when a store happened in between.
+ *  The value is kept in atomic words, so the torn copies a reader throws away are not
+ *  data races.
+ */
+template <class T>
+class SeqLock
+{
+public:
+    static_assert(std::is_trivially_copyable_v<T>, "SeqLock only supports trivially copyable types");
+
+    static constexpr size_t WordCount = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+public:
+    SeqLock(const T &value = T{})
+    {
+        Write(value);
+    }
+
+    void Store(const T &value)
+    {
+        uint32_t current = sequence.load(std::memory_order_relaxed);
+        while ((current & 1) || !sequence.compare_exchange_weak(current, current + 1, std::memory_order_acquire, std::memory_order_relaxed))
+        {
+            Futex::Pause();
+            current = sequence.load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_release);
+
+        Write(value);
+
+        sequence.store(current + 2, std::memory_order_release);
+    }
+
+    T Load() const
+    {
+        uint64_t buffer[WordCount];
+        for (int spins = 0; ; spins++)
+        {
+            uint32_t before = sequence.load(std::memory_order_acquire);
+            if (before & 1)
+            {
+                /* The writer may have been preempted halfway, give it the core back */
+                spins < Futex::SpinCount ? Futex::Pause() : std::this_thread::yield();
+                continue;
+            }
+            for (size_t i = 0; i < WordCount; i++)
+            {
+                buffer[i] = words[i].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (sequence.load(std::memory_order_relaxed) == before)
+            {
+                break;
+            }
+        }
+
+        T value;
+        memcpy(&value, buffer, sizeof(T));
+        return value;
+    }
+
+private:
+    void Write(const T &value)
+    {
+        uint64_t buffer[WordCount]{};
+        memcpy(buffer, &value, sizeof(T));
+        for (size_t i = 0; i < WordCount; i++)
+        {
+            words[i].store(buffer[i], std::memory_order_relaxed);
+        }
+    }
+
+private:
+    std::atomic<uint32_t> sequence{ 0 };
+
+    std::atomic<uint64_t> words[WordCount];
+};
+
+}
@@ -0,0 +1,134 @@
+#pragma once
+
+#include "Futex.h"
+
+namespace Immortal
+{
+
+/*
+ * @brief A signal threads could wait for. A manual reset signal stays signaled until
+ *  Reset and releases every waiter, an auto reset signal releases one waiter and resets
+ *  itself. Set only enters the kernel when somebody is actually sleeping.
+ */
+class Signal
+{
+public:
+    explicit Signal(bool manualReset = true, bool signaled = false) :
+        manualReset{ manualReset },
+        state{ signaled ? 1u : 0u }
+    {
+
+    }
+
+    void Set()
+    {
+        state.store(1, std::memory_order_seq_cst);
+        if (sleepers.load(std::memory_order_seq_cst) > 0)
+        {
+            manualReset ? Futex::WakeAll(state) : Futex::WakeOne(state);
+        }
+    }
+
+    void Reset()
+    {
+        state.store(0, std::memory_order_relaxed);
+    }
+
+    bool TryWait()
+    {
+        if (manualReset)
+        {
+            return state.load(std::memory_order_acquire) == 1;
+        }
+        uint32_t expected = 1;
+        return state.compare_exchange_strong(expected, 0, std::memory_order_acquire);
+    }
+
+    void Wait()
+    {
+        for (int i = 0; i < Futex::SpinCount; i++)
+        {
+            if (TryWait())
+            {
+                return;
+            }
+            Futex::Pause();
+        }
+
+        sleepers.fetch_add(1, std::memory_order_seq_cst);
+        while (!TryWait())
+        {
+            Futex::Wait(state, 0);
+        }
+        sleepers.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+private:
+    bool manualReset;
+
+    std::atomic<uint32_t> state;
+
+    std::atomic<uint32_t> sleepers{ 0 };
+};
+
+/*
+ * @brief A counting semaphore for CPU threads. Not to be confused with Semaphore, which
+ *  is the handle of a GPU semaphore.
+ */
+class CountingSemaphore
+{
+public:
+    explicit CountingSemaphore(uint32_t count = 0) :
+        count{ count }
+    {
+
+    }
+
+    void Release(uint32_t n = 1)
+    {
+        count.fetch_add(n, std::memory_order_seq_cst);
+        if (sleepers.load(std::memory_order_seq_cst) > 0)
+        {
+            n == 1 ? Futex::WakeOne(count) : Futex::WakeAll(count);
+        }
+    }
+
+    bool TryAcquire()
+    {
+        uint32_t value = count.load(std::memory_order_relaxed);
+        while (value > 0)
+        {
+            if (count.compare_exchange_weak(value, value - 1, std::memory_order_acquire))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void Acquire()
+    {
+        for (int i = 0; i < Futex::SpinCount; i++)
+        {
+            if (TryAcquire())
+            {
+                return;
+            }
+            Futex::Pause();
+        }
+
+        sleepers.fetch_add(1, std::memory_order_seq_cst);
+        while (!TryAcquire())
+        {
+            Futex::Wait(count, 0);
+        }
+        sleepers.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<uint32_t> count;
+
+    std::atomic<uint32_t> sleepers{ 0 };
+};
+
+}
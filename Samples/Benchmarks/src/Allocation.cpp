@@ -0,0 +1,77 @@
+#include "Benchmark.h"
+#include "Framework/Async.h"
+
+#include <atomic>
+#include <new>
+
+using namespace Immortal;
+
+/*
+ * @brief Every heap allocation of the process, on any thread, goes through here while the
+ *  benchmarks run. Over-aligned ones are not counted, nothing on the way of a submit
+ *  makes one.
+ */
+static std::atomic<uint64_t> allocations{ 0 };
+
+void *operator new(size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void *pointer = malloc(size ? size : 1))
+    {
+        return pointer;
+    }
+    throw std::bad_alloc{};
+}
+
+void operator delete(void *pointer) noexcept
+{
+    free(pointer);
+}
+
+void operator delete(void *pointer, size_t) noexcept
+{
+    free(pointer);
+}
+
+/*
+ * @brief Heap allocations per submitted task once the pools have warmed up, i.e. in the
+ *  second frame onwards. Dispatch is expected to take none, Execute still pays for the
+ *  future.
+ */
+BENCHMARK(AllocationsPerSubmit)
+{
+    constexpr int count = 100000;
+    Async::threadPool.reset(new ThreadPool{ 4 });
+
+    auto measure = [&](const char *name, auto &&submit) {
+        submit();
+
+        uint64_t before = allocations.load();
+        Timer timer;
+        timer.Start();
+        submit();
+        double ms = timer.Stop();
+
+        Benchmark::Report(name, double(allocations.load() - before) / count, "allocations/task");
+        Benchmark::Report(name, ms * 1e6 / count, "ns/task");
+    };
+
+    measure("Dispatch", [&] {
+        WaitGroup waitGroup;
+        for (int i = 0; i < count; i++)
+        {
+            Async::Dispatch([i] { (void)i; }, waitGroup);
+        }
+        waitGroup.Wait();
+    });
+
+    measure("Execute", [&] {
+        for (int i = 0; i < count; i++)
+        {
+            Async::Execute([i] { (void)i; });
+        }
+        Async::Wait();
+    });
+
+    Async::threadPool.reset();
+}
@@ -0,0 +1,129 @@
+#pragma once
+
+#include "Core.h"
+#include "Framework/Timer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+namespace Immortal
+{
+class Application;
+}
+
+namespace Benchmark
+{
+
+using Immortal::Timer;
+
+/*
+ * @brief A scene needs a render device for its buffers and render target, so the scene
+ *  benchmarks ask for the engine first. The first call sets up an OpenGL application
+ *  whose loop never runs.
+ */
+Immortal::Application &Engine();
+
+/*
+ * @brief A benchmark registered by name. The runner goes through all of them, or only
+ *  the ones whose name starts with one of the arguments.
+ */
+struct Case
+{
+    const char *Name;
+    void (*Run)();
+};
+
+inline std::vector<Case> &Cases()
+{
+    static std::vector<Case> cases;
+    return cases;
+}
+
+struct Registrar
+{
+    Registrar(const char *name, void (*run)())
+    {
+        Cases().emplace_back(Case{ name, run });
+    }
+};
+
+/*
+ * @brief The best of a few runs in milliseconds. The first run warms up the caches and
+ *  the pools and is not counted.
+ */
+template <class F>
+static inline double Measure(F &&func, int repeats = 5)
+{
+    func();
+
+    double best = 0;
+    for (int i = 0; i < repeats; i++)
+    {
+        Timer timer;
+        timer.Start();
+        func();
+        double elapsed = timer.Stop<Timer::Milliseconds>();
+        best = i == 0 ? elapsed : std::min(best, elapsed);
+    }
+    return best;
+}
+
+/*
+ * @brief The given thread counts and the hardware one, in order. Counts above the hardware
+ *  one are kept, they show what oversubscription costs.
+ */
+static inline std::vector<int> ThreadCounts(std::initializer_list<int> counts = { 1, 4, 16 })
+{
+    std::vector<int> result{ counts };
+    result.emplace_back(std::max(1, int(std::thread::hardware_concurrency())));
+
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+    return result;
+}
+
+/*
+ * @brief Run func(index) on that many threads at once and return the milliseconds from
+ *  the start signal to the last one finishing.
+ */
+template <class F>
+static inline double Concurrently(int threads, F &&func)
+{
+    std::atomic<bool> start{ false };
+    std::vector<std::thread> pool;
+    for (int i = 0; i < threads; i++)
+    {
+        pool.emplace_back([&, i] {
+            while (!start.load(std::memory_order_acquire))
+            {
+                std::this_thread::yield();
+            }
+            func(i);
+        });
+    }
+
+    Timer timer;
+    timer.Start();
+    start.store(true, std::memory_order_release);
+    for (auto &thread : pool)
+    {
+        thread.join();
+    }
+    return timer.Stop();
+}
+
+static inline void Report(const char *name, double value, const char *unit)
+{
+    printf("    %-48s %14.2f %s\n", name, value, unit);
+}
+
+}
+
+#define BENCHMARK(name) \
+    static void name(); \
+    static Benchmark::Registrar name##Registrar{ #name, name }; \
+    static void name()
@@ -0,0 +1,43 @@
+#include "Benchmark.h"
+#include "Framework/Application.h"
+#include "Framework/Async.h"
+#include "Render/Render.h"
+
+using namespace Immortal;
+
+Application &Benchmark::Engine()
+{
+    static std::unique_ptr<Application> application = [] {
+        Render::Set(Render::Type::OpenGL);
+        return std::make_unique<Application>(Window::Description{ "Benchmarks", 1280, 720 });
+    }();
+
+    /* The scheduler benchmarks replace the pool with their own ones */
+    if (!Async::threadPool)
+    {
+        Async::Setup();
+    }
+    return *application;
+}
+
+int main(int argc, char **argv)
+{
+    LOG::Setup();
+
+    for (auto &c : Benchmark::Cases())
+    {
+        bool selected = argc < 2;
+        for (int i = 1; i < argc && !selected; i++)
+        {
+            selected = strncmp(c.Name, argv[i], strlen(argv[i])) == 0;
+        }
+
+        if (selected)
+        {
+            printf("%s\n", c.Name);
+            c.Run();
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,239 @@
+#include "Benchmark.h"
+#include "Sync/Mutex.h"
+#include "Sync/SeqLock.h"
+#include "Sync/Signal.h"
+
+#include <condition_variable>
+#include <mutex>
+#include <shared_mutex>
+
+using namespace Immortal;
+
+namespace
+{
+
+/*
+ * @brief The critical section of the lock benchmarks, a few loads and stores like most
+ *  of the ones in the engine.
+ */
+struct alignas(64) Shared
+{
+    uint64_t values[8]{};
+
+    void Write(uint64_t value)
+    {
+        for (auto &v : values)
+        {
+            v += value;
+        }
+    }
+
+    uint64_t Read() const
+    {
+        uint64_t sum = 0;
+        for (auto v : values)
+        {
+            sum += v;
+        }
+        return sum;
+    }
+};
+
+struct Stats
+{
+    uint64_t Frame;
+    float Cpu;
+    float Gpu;
+    uint32_t DrawCalls;
+    uint32_t Triangles;
+};
+
+/*
+ * @brief The std counterpart of CountingSemaphore, there is none before C++20.
+ */
+class StdSemaphore
+{
+public:
+    void Release()
+    {
+        {
+            std::lock_guard<std::mutex> lock{ mutex };
+            count++;
+        }
+        condition.notify_one();
+    }
+
+    void Acquire()
+    {
+        std::unique_lock<std::mutex> lock{ mutex };
+        condition.wait(lock, [this] { return count > 0; });
+        count--;
+    }
+
+private:
+    std::mutex mutex;
+    std::condition_variable condition;
+    uint32_t count{ 0 };
+};
+
+template <class Lock>
+static double Exclusive(int threads, int count)
+{
+    Lock lock;
+    Shared shared;
+    double ms = Benchmark::Concurrently(threads, [&](int) {
+        for (int i = 0; i < count; i++)
+        {
+            std::lock_guard<Lock> guard{ lock };
+            shared.Write(1);
+        }
+    });
+    return threads * count / ms / 1000.0;
+}
+
+/*
+ * @brief One write in every 64 operations, about what a registry sees after loading.
+ */
+template <class Lock>
+static double MostlyRead(int threads, int count)
+{
+    Lock lock;
+    Shared shared;
+    std::atomic<uint64_t> sink{ 0 };
+    double ms = Benchmark::Concurrently(threads, [&](int) {
+        uint64_t sum = 0;
+        for (int i = 0; i < count; i++)
+        {
+            if ((i & 63) == 0)
+            {
+                std::unique_lock<Lock> guard{ lock };
+                shared.Write(1);
+            }
+            else
+            {
+                std::shared_lock<Lock> guard{ lock };
+                sum += shared.Read();
+            }
+        }
+        sink.fetch_add(sum, std::memory_order_relaxed);
+    });
+    return threads * count / ms / 1000.0;
+}
+
+template <class Semaphore>
+static double PingPong(int count)
+{
+    Semaphore ping;
+    Semaphore pong;
+    double ms = Benchmark::Concurrently(2, [&](int index) {
+        for (int i = 0; i < count; i++)
+        {
+            if (index == 0)
+            {
+                ping.Release();
+                pong.Acquire();
+            }
+            else
+            {
+                ping.Acquire();
+                pong.Release();
+            }
+        }
+    });
+    return count / ms / 1000.0;
+}
+
+/*
+ * @brief The readers each reading the stats that many times, while one thread keeps
+ *  publishing them.
+ */
+template <class Publish, class Read>
+static double Publishing(int threads, int count, Publish &&publish, Read &&read)
+{
+    std::atomic<int> reading{ threads };
+    std::atomic<uint64_t> sink{ 0 };
+    double ms = Benchmark::Concurrently(threads + 1, [&](int index) {
+        if (index == 0)
+        {
+            for (uint32_t i = 0; reading.load(std::memory_order_relaxed) > 0; i++)
+            {
+                publish(Stats{ i, 1.0f, 2.0f, i, i * 3 });
+            }
+            return;
+        }
+
+        uint64_t frames = 0;
+        for (int i = 0; i < count; i++)
+        {
+            frames += read().Frame;
+        }
+        sink.fetch_add(frames, std::memory_order_relaxed);
+        reading.fetch_sub(1, std::memory_order_relaxed);
+    });
+    return threads * count / ms / 1000.0;
+}
+
+}
+
+/*
+ * @brief Mutex against std::mutex with every thread hammering the same short critical
+ *  section, the worst case for both.
+ */
+BENCHMARK(ContentionMutex)
+{
+    constexpr int count = 200000;
+    for (auto threads : Benchmark::ThreadCounts({ 1, 2, 4, 16 }))
+    {
+        char name[64];
+        sprintf(name, "Mutex, %d thread(s)", threads);
+        Benchmark::Report(name, Exclusive<Mutex>(threads, count), "Mops/s");
+
+        sprintf(name, "std::mutex, %d thread(s)", threads);
+        Benchmark::Report(name, Exclusive<std::mutex>(threads, count), "Mops/s");
+    }
+}
+
+BENCHMARK(ContentionRWLock)
+{
+    constexpr int count = 200000;
+    for (auto threads : Benchmark::ThreadCounts({ 1, 2, 4, 16 }))
+    {
+        char name[64];
+        sprintf(name, "RWLock, %d thread(s)", threads);
+        Benchmark::Report(name, MostlyRead<RWLock>(threads, count), "Mops/s");
+
+        sprintf(name, "std::shared_mutex, %d thread(s)", threads);
+        Benchmark::Report(name, MostlyRead<std::shared_mutex>(threads, count), "Mops/s");
+    }
+}
+
+/*
+ * @brief Two threads handing a token back and forth, i.e. the latency of a wake up.
+ */
+BENCHMARK(ContentionSemaphore)
+{
+    constexpr int count = 100000;
+    Benchmark::Report("CountingSemaphore", PingPong<CountingSemaphore>(count), "M round trips/s");
+    Benchmark::Report("std::mutex + condition_variable", PingPong<StdSemaphore>(count), "M round trips/s");
+}
+
+BENCHMARK(ContentionSeqLock)
+{
+    constexpr int count = 1000000;
+    for (auto threads : Benchmark::ThreadCounts({ 1, 4, 16 }))
+    {
+        SeqLock<Stats> seqLock;
+        char name[64];
+        sprintf(name, "SeqLock, %d reader(s)", threads);
+        Benchmark::Report(name, Publishing(threads, count,
+            [&](const Stats &stats) { seqLock.Store(stats); },
+            [&] { return seqLock.Load(); }), "M reads/s");
+
+        std::mutex mutex;
+        Stats stats{};
+        sprintf(name, "std::mutex, %d reader(s)", threads);
+        Benchmark::Report(name, Publishing(threads, count,
+            [&](const Stats &value) { std::lock_guard<std::mutex> lock{ mutex }; stats = value; },
+            [&] { std::lock_guard<std::mutex> lock{ mutex }; return stats; }), "M reads/s");
+    }
+}
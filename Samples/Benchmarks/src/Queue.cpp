@@ -0,0 +1,159 @@
+#include "Benchmark.h"
+#include "Sync/Queue.h"
+
+#include <deque>
+#include <mutex>
+
+using namespace Immortal;
+
+namespace
+{
+
+/*
+ * @brief What the queues replace, a deque behind a mutex.
+ */
+template <class T>
+class LockedQueue
+{
+public:
+    bool Push(T value)
+    {
+        std::lock_guard<std::mutex> lock{ mutex };
+        items.emplace_back(value);
+        return true;
+    }
+
+    bool Pop(T &value)
+    {
+        std::lock_guard<std::mutex> lock{ mutex };
+        if (items.empty())
+        {
+            return false;
+        }
+        value = items.front();
+        items.pop_front();
+        return true;
+    }
+
+private:
+    std::mutex mutex;
+    std::deque<T> items;
+};
+
+struct Node : MPSCNode
+{
+    uint64_t Value;
+};
+
+/*
+ * @brief The producers push count values each and the consumers pop until all of them
+ *  are through. Returns pushes and pops per second together.
+ */
+template <class Queue>
+static double Transfer(Queue &queue, int producers, int consumers, int count)
+{
+    uint64_t total = uint64_t(producers) * count;
+
+    std::atomic<uint64_t> popped{ 0 };
+    double ms = Benchmark::Concurrently(producers + consumers, [&](int index) {
+        if (index < producers)
+        {
+            for (int i = 0; i < count; i++)
+            {
+                while (!queue.Push(uint64_t(i)))
+                {
+                    std::this_thread::yield();
+                }
+            }
+            return;
+        }
+
+        uint64_t value;
+        while (popped.load(std::memory_order_relaxed) < total)
+        {
+            if (queue.Pop(value))
+            {
+                popped.fetch_add(1, std::memory_order_relaxed);
+            }
+            else
+            {
+                std::this_thread::yield();
+            }
+        }
+    });
+    return 2.0 * total / ms / 1000.0;
+}
+
+}
+
+BENCHMARK(QueueSPSC)
+{
+    constexpr int count = 1000000;
+
+    SPSCQueue<uint64_t> ring{ 1024 };
+    Benchmark::Report("SPSCQueue, 2 threads", Transfer(ring, 1, 1, count), "Mops/s");
+
+    LockedQueue<uint64_t> locked;
+    Benchmark::Report("std::mutex + std::deque, 2 threads", Transfer(locked, 1, 1, count), "Mops/s");
+}
+
+BENCHMARK(QueueMPMC)
+{
+    constexpr int count = 200000;
+    for (auto threads : { 2, 4, 8, 16, 32 })
+    {
+        char name[64];
+        MPMCQueue<uint64_t> ring{ 1024 };
+        sprintf(name, "MPMCQueue, %d threads", threads);
+        Benchmark::Report(name, Transfer(ring, threads / 2, threads / 2, count), "Mops/s");
+
+        LockedQueue<uint64_t> locked;
+        sprintf(name, "std::mutex + std::deque, %d threads", threads);
+        Benchmark::Report(name, Transfer(locked, threads / 2, threads / 2, count), "Mops/s");
+    }
+}
+
+/*
+ * @brief Every thread but one pushes preallocated nodes, the last one pops them.
+ */
+BENCHMARK(QueueMPSC)
+{
+    constexpr int count = 200000;
+    for (auto threads : { 2, 4, 8, 16, 32 })
+    {
+        int producers = threads - 1;
+        std::vector<Node> nodes(size_t(producers) * count);
+        MPSCQueue<Node> queue;
+
+        double ms = Benchmark::Concurrently(threads, [&](int index) {
+            if (index < producers)
+            {
+                for (int i = 0; i < count; i++)
+                {
+                    queue.Push(&nodes[size_t(index) * count + i]);
+                }
+                return;
+            }
+
+            for (size_t popped = 0; popped < nodes.size(); )
+            {
+                if (queue.Pop())
+                {
+                    popped++;
+                }
+                else
+                {
+                    std::this_thread::yield();
+                }
+            }
+        });
+
+        char name[64];
+        sprintf(name, "MPSCQueue, %d threads", threads);
+        Benchmark::Report(name, 2.0 * nodes.size() / ms / 1000.0, "Mops/s");
+
+        LockedQueue<uint64_t> locked;
+        sprintf(name, "std::mutex + std::deque, %d threads", threads);
+        Benchmark::Report(name, Transfer(locked, producers, 1, count), "Mops/s");
+    }
+}
@@ -0,0 +1,204 @@
+/*
+ * @brief Stress test of the lock-free queues, meant to be built with ThreadSanitizer,
+ *  see IMMORTAL_QUEUE_STRESS_TSAN. Every value has to come out exactly once, and the
+ *  values of one producer in the order they went in, as seen by each consumer. Small
+ *  rings keep the indices wrapping around all the time.
+ */
+#include "Sync/Queue.h"
+
+#include <cstdio>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace Immortal;
+
+namespace
+{
+
+static constexpr uint64_t ProducerShift = 32;
+
+static bool failed = false;
+
+static void Check(bool condition, const char *what)
+{
+    if (!condition && !failed)
+    {
+        failed = true;
+        fprintf(stderr, "QueueStress: %s\n", what);
+    }
+}
+
+template <class F>
+static void Run(int threads, F &&func)
+{
+    std::vector<std::thread> pool;
+    for (int i = 0; i < threads; i++)
+    {
+        pool.emplace_back(func, i);
+    }
+    for (auto &thread : pool)
+    {
+        thread.join();
+    }
+}
+
+/*
+ * @brief The payload owns memory, so a value moved out twice or never destroyed shows up
+ *  as a double free or a leak under the sanitizers.
+ */
+using Payload = std::unique_ptr<uint64_t>;
+
+static void TestSPSC(uint64_t count)
+{
+    SPSCQueue<Payload> queue{ 64 };
+    bool ordered = true;
+
+    Run(2, [&](int index) {
+        if (index == 0)
+        {
+            for (uint64_t i = 0; i < count; i++)
+            {
+                while (!queue.Push(std::make_unique<uint64_t>(i)))
+                {
+                    std::this_thread::yield();
+                }
+            }
+            return;
+        }
+
+        Payload value;
+        for (uint64_t expected = 0; expected < count; )
+        {
+            if (queue.Pop(value))
+            {
+                ordered &= *value == expected++;
+            }
+        }
+    });
+
+    Check(ordered, "SPSCQueue handed out values out of order");
+    Check(queue.Size() == 0, "SPSCQueue is not empty after every value was popped");
+}
+
+static void TestMPMC(int producers, int consumers, uint64_t count)
+{
+    MPMCQueue<Payload> queue{ 64 };
+    std::vector<std::atomic<uint32_t>> seen(producers * count);
+    std::atomic<uint64_t> popped{ 0 };
+    std::atomic<bool> ordered{ true };
+
+    Run(producers + consumers, [&](int index) {
+        if (index < producers)
+        {
+            for (uint64_t i = 0; i < count; i++)
+            {
+                while (!queue.Push(std::make_unique<uint64_t>((uint64_t(index) << ProducerShift) | i)))
+                {
+                    std::this_thread::yield();
+                }
+            }
+            return;
+        }
+
+        std::vector<int64_t> last(producers, -1);
+        Payload value;
+        while (popped.load(std::memory_order_relaxed) < producers * count)
+        {
+            if (!queue.Pop(value))
+            {
+                std::this_thread::yield();
+                continue;
+            }
+
+            uint64_t producer = *value >> ProducerShift;
+            int64_t sequence = int64_t(*value & ((1ull << ProducerShift) - 1));
+            if (sequence <= last[producer])
+            {
+                ordered.store(false, std::memory_order_relaxed);
+            }
+            last[producer] = sequence;
+            seen[producer * count + sequence].fetch_add(1, std::memory_order_relaxed);
+            popped.fetch_add(1, std::memory_order_relaxed);
+        }
+    });
+
+    bool once = true;
+    for (auto &s : seen)
+    {
+        once &= s.load() == 1;
+    }
+    Check(once, "MPMCQueue lost or duplicated a value");
+    Check(ordered.load(), "MPMCQueue reordered the values of a producer");
+}
+
+struct Node : MPSCNode
+{
+    uint64_t Value;
+};
+
+static void TestMPSC(int producers, uint64_t count)
+{
+    std::vector<Node> nodes(producers * count);
+    MPSCQueue<Node> queue;
+    std::vector<uint32_t> seen(nodes.size());
+    bool ordered = true;
+
+    Run(producers + 1, [&](int index) {
+        if (index < producers)
+        {
+            for (uint64_t i = 0; i < count; i++)
+            {
+                Node &node = nodes[index * count + i];
+                node.Value = (uint64_t(index) << ProducerShift) | i;
+                queue.Push(&node);
+            }
+            return;
+        }
+
+        std::vector<int64_t> last(producers, -1);
+        for (uint64_t popped = 0; popped < nodes.size(); )
+        {
+            Node *node = queue.Pop();
+            if (!node)
+            {
+                std::this_thread::yield();
+                continue;
+            }
+
+            uint64_t producer = node->Value >> ProducerShift;
+            int64_t sequence = int64_t(node->Value & ((1ull << ProducerShift) - 1));
+            ordered &= sequence > last[producer];
+            last[producer] = sequence;
+            seen[producer * count + sequence]++;
+            popped++;
+        }
+    });
+
+    bool once = true;
+    for (auto s : seen)
+    {
+        once &= s == 1;
+    }
+    Check(once, "MPSCQueue lost or duplicated a node");
+    Check(ordered, "MPSCQueue reordered the nodes of a producer");
+    Check(queue.Empty(), "MPSCQueue is not empty after every node was popped");
+}
+
+}
+
+int main()
+{
+    /* Much smaller counts than a benchmark, ThreadSanitizer slows everything down a lot */
+    for (int round = 0; round < 4; round++)
+    {
+        TestSPSC(100000);
+        TestMPMC(4, 4, 20000);
+        TestMPMC(1, 7, 20000);
+        TestMPMC(7, 1, 20000);
+        TestMPSC(7, 20000);
+    }
+
+    printf("QueueStress: %s\n", failed ? "failed" : "passed");
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,55 @@
+#include "Benchmark.h"
+#include "Render/Render.h"
+#include "Scene/Component.h"
+#include "Scene/Object.h"
+#include "Scene/Scene.h"
+#include "Serializer/SceneSerializer.h"
+
+#include <cstdio>
+
+using namespace Immortal;
+
+/*
+ * @brief Saving a scene of 1M objects to the binary format and loading it into an empty
+ *  scene. Every object has a transform, an ID and a tag of its own, a third of them a
+ *  sprite, so the string table and the resource table are both in there.
+ */
+BENCHMARK(SceneLoad)
+{
+    Benchmark::Engine();
+
+    constexpr size_t count = 1000000;
+    const std::string path = "Benchmark.scene";
+
+    auto scene = std::make_shared<Scene>("SceneLoad");
+    {
+        auto objects = scene->CreateObjects(count);
+        auto &registry = scene->Registry();
+        for (size_t i = 0; i < count; i++)
+        {
+            registry.get<TransformComponent>(objects[i]).Position = Vector3{ float(i), 1.0f, 2.0f };
+            registry.replace<TagComponent>(objects[i], "Object " + std::to_string(i));
+            if (i % 3 == 0)
+            {
+                registry.emplace<SpriteRendererComponent>(objects[i], Render::Preset()->WhiteTextureHandle, Vector4{ 1.0f, 0.0f, 0.0f, 1.0f });
+            }
+        }
+    }
+
+    Timer timer;
+    timer.Start();
+    SceneSerializer{ scene }.Serialize(path);
+    Benchmark::Report("Save 1M objects", timer.Stop(), "ms");
+
+    auto loaded = std::make_shared<Scene>("SceneLoad");
+    timer.Start();
+    bool succeeded = SceneSerializer{ loaded }.Deserialize(path);
+    Benchmark::Report("Load 1M objects", timer.Stop(), "ms");
+
+    if (!succeeded || loaded->Registry().view<IDComponent>().size() != count)
+    {
+        LOG::WARN("The scene did not come back whole from {0}", path);
+    }
+
+    std::remove(path.c_str());
+}
@@ -0,0 +1,87 @@
+#include "Benchmark.h"
+#include "Framework/Async.h"
+
+using namespace Immortal;
+
+namespace
+{
+
+/*
+ * @brief Busy work the compiler could not fold away.
+ */
+static inline uint64_t Spin(uint64_t iterations)
+{
+    volatile uint64_t value = 0;
+    for (uint64_t i = 0; i < iterations; i++)
+    {
+        value = value + i;
+    }
+    return value;
+}
+
+/*
+ * @brief The iterations of Spin that take about a microsecond on this machine.
+ */
+static uint64_t Microsecond()
+{
+    static uint64_t iterations = [] {
+        constexpr uint64_t trial = 1 << 20;
+        double ms = Benchmark::Measure([] { Spin(trial); }, 3);
+        return std::max<uint64_t>(1, uint64_t(trial / (ms * 1000.0)));
+    }();
+    return iterations;
+}
+
+}
+
+/*
+ * @brief Tasks per second for tasks of about 1us going through Execute and Wait, which
+ *  used to take one lock per task, and through Dispatch, which neither locks nor
+ *  allocates. The submitting thread is not a worker, so the pool has to wake up for
+ *  every batch like it would in a frame.
+ */
+BENCHMARK(SchedulerThroughput)
+{
+    constexpr int count = 100000;
+    uint64_t iterations = Microsecond();
+
+    double serial = Benchmark::Measure([=] {
+        for (int i = 0; i < count; i++)
+        {
+            Spin(iterations);
+        }
+    });
+    Benchmark::Report("Task length", serial * 1000.0 / count, "us");
+    Benchmark::Report("Serial", count / serial * 1000.0, "tasks/s");
+
+    for (auto threads : Benchmark::ThreadCounts())
+    {
+        Async::threadPool.reset(new ThreadPool{ threads });
+
+        double ms = Benchmark::Measure([=] {
+            for (int i = 0; i < count; i++)
+            {
+                Async::Execute([=] { Spin(iterations); });
+            }
+            Async::Wait();
+        });
+
+        char name[64];
+        sprintf(name, "Execute, %d thread(s)", threads);
+        Benchmark::Report(name, count / ms * 1000.0, "tasks/s");
+
+        ms = Benchmark::Measure([=] {
+            WaitGroup waitGroup;
+            for (int i = 0; i < count; i++)
+            {
+                Async::Dispatch([=] { Spin(iterations); }, waitGroup);
+            }
+            waitGroup.Wait();
+        });
+
+        sprintf(name, "Dispatch, %d thread(s)", threads);
+        Benchmark::Report(name, count / ms * 1000.0, "tasks/s");
+    }
+
+    Async::threadPool.reset();
+}
@@ -0,0 +1,184 @@
+#include "Benchmark.h"
+#include "Physics/DynamicTree.h"
+
+#include <cmath>
+#include <random>
+
+using namespace Immortal;
+using namespace Immortal::Physics;
+
+namespace
+{
+
+/*
+ * @brief What a scan over the registry did for a ray, the slab test against every box.
+ */
+static bool Raycast(const std::vector<BoundingBox> &boxes, const Vector3 &origin, const Vector3 &direction, float maxDistance, float &distance)
+{
+    int hit = -1;
+    distance = maxDistance;
+    for (size_t i = 0; i < boxes.size(); i++)
+    {
+        float enter = 0;
+        float exit  = distance;
+        bool inside = true;
+        for (int axis = 0; axis < 3 && inside; axis++)
+        {
+            float inverse = 1.0f / direction[axis];
+            float low = (boxes[i].Min[axis] - origin[axis]) * inverse;
+            float high = (boxes[i].Max[axis] - origin[axis]) * inverse;
+            if (low > high)
+            {
+                std::swap(low, high);
+            }
+            enter  = std::max(enter, low);
+            exit   = std::min(exit, high);
+            inside = enter <= exit;
+        }
+        if (inside)
+        {
+            distance = enter;
+            hit = int(i);
+        }
+    }
+    return hit >= 0;
+}
+
+}
+
+/*
+ * @brief The tree against a scan over every box, for 100k and 1M boxes of 0.4 to 4 units
+ *  scattered over a cube 1000 units wide, i.e. a sparse open world.
+ */
+BENCHMARK(SpatialQuery)
+{
+    constexpr int queries = 200;
+    volatile size_t sink = 0;
+
+    for (size_t count : { 100000, 1000000 })
+    {
+        std::mt19937 random{ 7 };
+        std::uniform_real_distribution<float> position{ -500.0f, 500.0f };
+        std::uniform_real_distribution<float> size{ 0.2f, 2.0f };
+
+        std::vector<BoundingBox> boxes(count);
+        for (auto &box : boxes)
+        {
+            Vector3 center{ position(random), position(random), position(random) };
+            Vector3 extent{ size(random), size(random), size(random) };
+            box = BoundingBox{ center - extent, center + extent };
+        }
+
+        DynamicTree tree;
+        Timer timer;
+        timer.Start();
+        for (size_t i = 0; i < count; i++)
+        {
+            tree.Insert(boxes[i], uint32_t(i));
+        }
+        double build = timer.Stop();
+
+        char name[64];
+        sprintf(name, "%zu boxes, building", count);
+        Benchmark::Report(name, build, "ms");
+
+        std::vector<Vector3> points(queries);
+        std::vector<Vector3> directions(queries);
+        for (int q = 0; q < queries; q++)
+        {
+            points[q] = Vector3{ position(random), position(random), position(random) };
+
+            Vector3 direction{ position(random), position(random), position(random) };
+            float length = std::sqrt(direction[0] * direction[0] + direction[1] * direction[1] + direction[2] * direction[2]);
+            directions[q] = direction * (1.0f / length);
+        }
+
+        auto report = [&](const char *query, double treeMs, double bruteMs) {
+            sprintf(name, "%zu boxes, %s, tree", count, query);
+            Benchmark::Report(name, treeMs * 1000.0 / queries, "us/query");
+            sprintf(name, "%zu boxes, %s, brute force", count, query);
+            Benchmark::Report(name, bruteMs * 1000.0 / queries, "us/query");
+        };
+
+        const Vector3 extent{ 10.0f, 10.0f, 10.0f };
+        report("box overlap", Benchmark::Measure([&] {
+            size_t found = 0;
+            for (auto &point : points)
+            {
+                tree.Overlap(BoundingBox{ point - extent, point + extent }, [&](int32_t) { found++; return true; });
+            }
+            sink = found;
+        }, 3), Benchmark::Measure([&] {
+            size_t found = 0;
+            for (auto &point : points)
+            {
+                BoundingBox box{ point - extent, point + extent };
+                for (auto &other : boxes)
+                {
+                    found += DynamicTree::Intersect(box, other);
+                }
+            }
+            sink = found;
+        }, 3));
+
+        constexpr float radius = 15.0f;
+        report("sphere overlap", Benchmark::Measure([&] {
+            size_t found = 0;
+            for (auto &point : points)
+            {
+                tree.Overlap(point, radius, [&](int32_t) { found++; return true; });
+            }
+            sink = found;
+        }, 3), Benchmark::Measure([&] {
+            size_t found = 0;
+            for (auto &point : points)
+            {
+                for (auto &other : boxes)
+                {
+                    found += DynamicTree::Distance2(other, point) <= radius * radius;
+                }
+            }
+            sink = found;
+        }, 3));
+
+        constexpr float maxDistance = 2000.0f;
+        report("raycast", Benchmark::Measure([&] {
+            size_t hits = 0;
+            for (int q = 0; q < queries; q++)
+            {
+                RaycastHit hit;
+                hits += tree.Raycast(points[q], directions[q], maxDistance, hit);
+            }
+            sink = hits;
+        }, 3), Benchmark::Measure([&] {
+            size_t hits = 0;
+            for (int q = 0; q < queries; q++)
+            {
+                float distance;
+                hits += Raycast(boxes, points[q], directions[q], maxDistance, distance);
+            }
+            sink = hits;
+        }, 3));
+
+        constexpr size_t k = 8;
+        std::vector<uint32_t> nearest;
+        std::vector<std::pair<float, uint32_t>> distances(count);
+        report("8 nearest", Benchmark::Measure([&] {
+            for (auto &point : points)
+            {
+                tree.Nearest(point, k, nearest);
+            }
+            sink = nearest[0];
+        }, 3), Benchmark::Measure([&] {
+            for (auto &point : points)
+            {
+                for (size_t i = 0; i < count; i++)
+                {
+                    distances[i] = { DynamicTree::Distance2(boxes[i], point), uint32_t(i) };
+                }
+                std::partial_sort(distances.begin(), distances.begin() + k, distances.end());
+            }
+            sink = distances[0].second;
+        }, 3));
+    }
+}
@@ -0,0 +1,68 @@
+#include "Benchmark.h"
+#include "Render/Render.h"
+#include "Scene/Component.h"
+#include "Scene/Object.h"
+#include "Scene/Scene.h"
+
+using namespace Immortal;
+
+/*
+ * @brief Spawning and destroying 1M sprites one object at a time, the way a loop over
+ *  CreateObject and AddComponent does it, against CreateObjects from a prototype and a
+ *  single DestroyObjects over the range.
+ */
+BENCHMARK(Spawn)
+{
+    Benchmark::Engine();
+
+    constexpr size_t count = 1000000;
+    const Vector4 color{ 1.0f, 0.5f, 0.25f, 1.0f };
+
+    {
+        Scene scene{ "Spawn" };
+        std::vector<entt::entity> objects;
+        objects.reserve(count);
+
+        Timer timer;
+        timer.Start();
+        for (size_t i = 0; i < count; i++)
+        {
+            Object object = scene.CreateObject();
+            object.AddComponent<SpriteRendererComponent>(Render::Preset()->WhiteTextureHandle, color);
+            objects.emplace_back(object);
+        }
+        Benchmark::Report("CreateObject and AddComponent", timer.Stop(), "ms");
+
+        timer.Start();
+        for (auto o : objects)
+        {
+            Object object{ o, &scene };
+            scene.DestroyObject(object);
+        }
+        Benchmark::Report("DestroyObject", timer.Stop(), "ms");
+    }
+
+    {
+        Scene scene{ "Spawn" };
+        Object prototype = scene.CreateObject("Sprite");
+        prototype.AddComponent<SpriteRendererComponent>(Render::Preset()->WhiteTextureHandle, color);
+
+        Timer timer;
+        timer.Start();
+        auto objects = scene.CreateObjects(count, prototype);
+        Benchmark::Report("CreateObjects from a prototype", timer.Stop(), "ms");
+
+        timer.Start();
+        scene.DestroyObjects(objects);
+        Benchmark::Report("DestroyObjects", timer.Stop(), "ms");
+    }
+
+    {
+        Scene scene{ "Spawn" };
+
+        Timer timer;
+        timer.Start();
+        auto objects = scene.CreateObjects(count);
+        Benchmark::Report("CreateObjects, transform, ID and tag only", timer.Stop(), "ms");
+    }
+}
@@ -0,0 +1,227 @@
+#include "Benchmark.h"
+#include "Scene/Component.h"
+#include "Scene/Object.h"
+#include "Scene/Scene.h"
+
+#include <algorithm>
+#include <random>
+
+using namespace Immortal;
+
+namespace
+{
+
+/*
+ * @brief What TransformComponent::Transform did on every call before the matrix was
+ *  cached.
+ */
+static inline Matrix4 Compose(const TransformComponent &transform)
+{
+    return Vector::Translate(transform.Position) * Vector::Rotate(transform.Rotation) * Vector::Scale(transform.Scale);
+}
+
+static std::vector<entt::entity> Populate(Scene &scene, size_t count, float extent, float minScale, float maxScale)
+{
+    std::mt19937 random{ 7 };
+    std::uniform_real_distribution<float> position{ -extent, extent };
+    std::uniform_real_distribution<float> scale{ minScale, maxScale };
+
+    auto objects = scene.CreateObjects(count);
+    auto &registry = scene.Registry();
+    for (auto o : objects)
+    {
+        registry.get<TransformComponent>(o).Set(
+            Vector3{ position(random), position(random), position(random) },
+            Vector3{ position(random), position(random), position(random) },
+            Vector3{ scale(random), scale(random), scale(random) });
+    }
+    return objects;
+}
+
+/*
+ * @brief Nudge every step-th object of the range, a different one each frame.
+ */
+static void Move(Scene &scene, const std::vector<entt::entity> &objects, size_t step, size_t frame)
+{
+    auto &registry = scene.Registry();
+    for (size_t i = frame % step; i < objects.size(); i += step)
+    {
+        registry.get<TransformComponent>(objects[i]).Position.x += 1e-3f;
+    }
+}
+
+/*
+ * @brief Every draw reads the local matrix of every object once.
+ */
+static float Draw(Scene &scene, const std::vector<entt::entity> &objects)
+{
+    auto &registry = scene.Registry();
+    float sum = 0;
+    for (auto o : objects)
+    {
+        sum += registry.get<TransformComponent>(o).Transform()[3][0];
+    }
+    return sum;
+}
+
+/*
+ * @brief The world matrices the naive way, from every root down through the links of the
+ *  relationships, composing every local matrix on the way.
+ */
+static void Recurse(entt::registry &registry, entt::entity e, const Matrix4 &parent)
+{
+    auto &transform = registry.get<TransformComponent>(e);
+    Matrix4 world = parent * Compose(transform);
+    transform.SetWorldTransform(world);
+
+    if (auto *relationship = registry.try_get<RelationshipComponent>(e))
+    {
+        for (entt::entity child = relationship->First; child != entt::null; child = registry.get<RelationshipComponent>(child).Next)
+        {
+            Recurse(registry, child, world);
+        }
+    }
+}
+
+}
+
+/*
+ * @brief A frame of 100k transforms that mostly stand still. Before, each draw composed
+ *  the matrix again. Now UpdateTransforms rebuilds the changed ones once and the draws
+ *  read the cache.
+ */
+BENCHMARK(TransformCache)
+{
+    Benchmark::Engine();
+
+    constexpr size_t count = 100000;
+    volatile float sink = 0;
+
+    Scene scene{ "TransformCache" };
+    auto objects = Populate(scene, count, 20.0f, 0.5f, 2.0f);
+
+    double ms = Benchmark::Measure([&] {
+        auto &registry = scene.Registry();
+        float sum = 0;
+        for (auto o : objects)
+        {
+            sum += Compose(registry.get<TransformComponent>(o))[3][0];
+        }
+        sink = sum;
+    });
+    Benchmark::Report("Composed on every draw", ms, "ms");
+
+    struct
+    {
+        const char *Name;
+        size_t Step;
+    } cases[] = {
+        { "Cached, static",     0 },
+        { "Cached, 1% moving", 100 },
+        { "Cached, all moving",  1 },
+    };
+
+    for (auto &c : cases)
+    {
+        size_t frame = 0;
+        ms = Benchmark::Measure([&] {
+            if (c.Step)
+            {
+                Move(scene, objects, c.Step, frame++);
+            }
+            scene.UpdateTransforms();
+            sink = Draw(scene, objects);
+        });
+        Benchmark::Report(c.Name, ms, "ms");
+    }
+}
+
+/*
+ * @brief 1M transforms linked into levels of equal size, each node under a random one of
+ *  the level above. The levels are dealt out over the objects at random, so the pool is
+ *  not in breadth first order to begin with. The first UpdateTransforms after linking
+ *  sorts it, the following ones only propagate.
+ */
+BENCHMARK(TransformHierarchy)
+{
+    Benchmark::Engine();
+
+    constexpr size_t count = 1000000;
+    volatile float sink = 0;
+
+    for (size_t depth : { 1, 4, 16, 64 })
+    {
+        Scene scene{ "TransformHierarchy" };
+        auto objects = Populate(scene, count, 2.0f, 1.0f, 1.0f);
+
+        std::mt19937 random{ 11 };
+        std::vector<entt::entity> levels = objects;
+        std::shuffle(levels.begin(), levels.end(), random);
+
+        size_t width = count / depth;
+        std::vector<entt::entity> roots{ levels.begin(), levels.begin() + width };
+
+        Timer timer;
+        timer.Start();
+        for (size_t i = width; i < count; i++)
+        {
+            size_t level = i / width;
+            if (level >= depth)
+            {
+                roots.emplace_back(levels[i]);
+                continue;
+            }
+
+            Object child{ levels[i], &scene };
+            Object parent{ levels[(level - 1) * width + random() % width], &scene };
+            scene.SetParent(child, parent);
+        }
+        double link = timer.Stop();
+
+        timer.Start();
+        scene.UpdateTransforms();
+        double sort = timer.Stop();
+
+        char name[64];
+        sprintf(name, "Depth %zu, linking", depth);
+        Benchmark::Report(name, link, "ms");
+        sprintf(name, "Depth %zu, first update, sorting", depth);
+        Benchmark::Report(name, sort, "ms");
+
+        double ms = Benchmark::Measure([&] {
+            auto &registry = scene.Registry();
+            for (auto root : roots)
+            {
+                Recurse(registry, root, Matrix4{ 1.0f });
+            }
+            sink = registry.get<TransformComponent>(roots[0]).WorldTransform()[3][0];
+        }, 3);
+        sprintf(name, "Depth %zu, recursive", depth);
+        Benchmark::Report(name, ms, "ms");
+
+        struct
+        {
+            const char *Name;
+            const std::vector<entt::entity> &Moving;
+            size_t Step;
+        } cases[] = {
+            { "static",              roots,     0 },
+            { "1% of roots moving",  roots,   100 },
+            { "all moving",          objects,   1 },
+        };
+
+        for (auto &c : cases)
+        {
+            size_t frame = 0;
+            ms = Benchmark::Measure([&] {
+                if (c.Step)
+                {
+                    Move(scene, c.Moving, c.Step, frame++);
+                }
+                scene.UpdateTransforms();
+            }, 3);
+            sprintf(name, "Depth %zu, %s", depth, c.Name);
+            Benchmark::Report(name, ms, "ms");
+        }
+    }
+}
@@ -42,7 +42,7 @@ public:
 		static float rotation = 0.0f;
 		rotation += Application::App()->DeltaTime() * 50.0f;
 
-		Render2D::DrawQuad({ 0.0f, 0.0f }, { texture->Ratio() * 2.0, 2.0f }, texture, 1.0f, Vector::Color(1.f));
+		Render2D::DrawQuad({ 0.0f, 0.0f }, { texture->Ratio() * 2.0, 2.0f }, Handle<Texture>{ texture }, 1.0f, Vector::Color(1.f));
 		Render2D::SetColor(color, luminance);
 		Render2D::EndScene();
 
@@ -47,7 +47,8 @@ public:
 
         if (isDeleted)
         {
-            scene->DestroyObject(o);
+            /* Still inside Registry().each, the object goes at the next sync point */
+            scene->Commands().Destroy(o);
             if (selectedObject == o)
             {
                 selectedObject = {};
@@ -28,7 +28,9 @@ public:
                 strcat(buf, tag.c_str());
                 if (ImGui::InputText(WordsMap::Get("Object Name").c_str(), buf, SL_ARRAY_LENGTH(buf)))
                 {
-                    tag = std::string{ buf };
+                    o.PatchComponent<TagComponent>([&](TagComponent &component) {
+                        component.Tag = std::string{ buf };
+                    });
                 }
             }
             ImGui::NewLine();
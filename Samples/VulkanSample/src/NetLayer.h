@@ -16,6 +16,7 @@ public:
 
     virtual void OnAttach() override
     {
+        /* The socket blocks on receive, keep it off the compute workers */
         Async::Execute([]() {
             Socket socket{ "localhost", "8080" };
 
@@ -33,7 +34,7 @@ public:
                     printf("%s\n", buffer.data());
                 }
                 });
-            });
+            }, Priority::IO);
     }
 
     virtual void OnDetach() override
@@ -214,7 +214,9 @@ public:
             {
                 selectedObject.Add<SpriteRendererComponent>();
             }
-            selectedObject.Get<SpriteRendererComponent>().Texture = image;
+            selectedObject.PatchComponent<SpriteRendererComponent>([&](auto &sprite) {
+                sprite.Texture = Handle<Texture>{ image };
+            });
         }        
     }
 
@@ -226,8 +228,7 @@ public:
             auto o = scene.CreateObject(res.value());
 
             std::shared_ptr<Texture> texture{ Render::Create<Texture>(res.value()) };
-            auto &sprite = o.AddComponent<SpriteRendererComponent>();
-            sprite.Texture = texture;
+            o.AddComponent<SpriteRendererComponent>(Handle<Texture>{ texture });
 
             auto &transform = o.GetComponent<TransformComponent>();
             transform.Scale = Vector3{ texture->Ratio(), 1.0f, 1.0f };